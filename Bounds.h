@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include <float.h>
+#include <glm/glm.hpp>
+#include <math.h>
+
+/*
+	Axis aligned bounding box. A default
+	constructed box is empty and expands
+	to fit whatever is added to it.
+*/
+struct AABB
+{
+  glm::vec3 m_min{FLT_MAX, FLT_MAX, FLT_MAX};
+  glm::vec3 m_max{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+  AABB() {}
+
+  AABB(const glm::vec3& inMin, const glm::vec3& inMax)
+      : m_min(inMin)
+      , m_max(inMax)
+  {
+  }
+
+  bool isEmpty() const { return m_min.x > m_max.x; }
+
+  glm::vec3 getCenter() const { return (m_min + m_max) * 0.5f; }
+  glm::vec3 getExtent() const { return (m_max - m_min) * 0.5f; }
+
+  void expand(const glm::vec3& inPoint)
+  {
+    m_min = glm::min(m_min, inPoint);
+    m_max = glm::max(m_max, inPoint);
+  }
+
+  void expand(const AABB& inBox)
+  {
+    m_min = glm::min(m_min, inBox.m_min);
+    m_max = glm::max(m_max, inBox.m_max);
+  }
+
+  /*
+		Bounds of this box after an affine
+		transform (Arvo's method).
+	*/
+  AABB transformed(const glm::mat4& inMatrix) const
+  {
+    if(isEmpty())
+      return AABB();
+
+    glm::vec3 center = glm::vec3(inMatrix * glm::vec4(getCenter(), 1.0f));
+    glm::vec3 extent = getExtent();
+    glm::vec3 outExtent;
+    for(int r = 0; r < 3; ++r)
+    {
+      outExtent[r] = fabsf(inMatrix[0][r]) * extent.x + fabsf(inMatrix[1][r]) * extent.y + fabsf(inMatrix[2][r]) * extent.z;
+    }
+    return AABB(center - outExtent, center + outExtent);
+  }
+};
+
+/*
+	Six clip planes extracted from a
+	projection * view matrix, normals
+	pointing inwards.
+*/
+struct Frustum
+{
+  glm::vec4 m_planes[6];
+
+  Frustum() {}
+
+  explicit Frustum(const glm::mat4& inProjView) { setMatrix(inProjView); }
+
+  void setMatrix(const glm::mat4& inProjView)
+  {
+    glm::mat4 m = glm::transpose(inProjView);
+
+    m_planes[0] = m[3] + m[0];  //left
+    m_planes[1] = m[3] - m[0];  //right
+    m_planes[2] = m[3] + m[1];  //bottom
+    m_planes[3] = m[3] - m[1];  //top
+    m_planes[4] = m[3] + m[2];  //near, conservative for 0..1 depth
+    m_planes[5] = m[3] - m[2];  //far
+
+    for(int i = 0; i < 6; ++i)
+    {
+      m_planes[i] /= glm::length(glm::vec3(m_planes[i]));
+    }
+  }
+};
@@ -20,6 +20,7 @@
 /* Contact chebert@nvidia.com (Chris Hebert) for feedback */
 
 #include "Node.h"
+#include "NodeStorage.h"
 #include "glm/gtc/quaternion.hpp"
 
 
@@ -122,18 +123,13 @@ Node* Node::newChild()
 
 Node* Node::newChild(const ID& inID)
 {
-
-  Node* node = new Node(this, inID);
-  m_child_nodes.addNode(node, this);
-  return node;
+  return m_child_nodes.newNode(inID, this);
 }
 
 Node* Node::newChild(const glm::vec4& inPosition)
 {
-  ID    id   = m_child_nodes.nextID();
-  Node* node = new Node(this, id);
-  m_child_nodes.addNode(node, this);
-  return node;
+  ID id = m_child_nodes.nextID();
+  return m_child_nodes.newNode(id, this);
 }
 
 Node* Node::newChild(const float inX, const float inY, const float inZ)
@@ -144,7 +140,8 @@ Node* Node::newChild(const float inX, const float inY, const float inZ)
 
 Renderable* Node::newRenderable()
 {
-  Renderable* renderable = new Renderable();
+  NodeStorage* storage    = m_child_nodes.getStorage();
+  Renderable*  renderable = storage ? storage->renderables.newObject() : new Renderable();
   m_renderables.push_back(renderable);
   return renderable;
 }
@@ -203,7 +200,8 @@ Node::Count Node::NodeList::count()
 
 Node* Node::NodeList::newNode(const ID& inID, Node* inParent)
 {
-  Node* node = new Node(inParent, inID);
+  Node* node = m_storage ? storagePool<Node>(*m_storage).newObject(inParent, inID) : new Node(inParent, inID);
+  node->m_child_nodes.setStorage(m_storage);
   m_data.push_back(node);
   return node;
 }
@@ -21,12 +21,23 @@
 
 #pragma once
 
+#include "ObjectPool.h"
 #include "Renderable.h"
 #include "Transform.h"
 #include "Types.h"
 #include <map>
 #include <vector>
 
+struct NodeStorage;
+
+/*
+	The pool in a NodeStorage that holds nodes of
+	type T. Specialised in NodeStorage.h for each
+	node class the storage keeps.
+*/
+template <typename T>
+ObjectPool<T>& storagePool(NodeStorage& inStorage);
+
 class Node
 {
 public:
@@ -55,15 +66,19 @@ public:
 
     Node::List& getData() { return m_data; }
 
+    void         setStorage(NodeStorage* inStorage) { m_storage = inStorage; }
+    NodeStorage* getStorage() { return m_storage; }
+
     template <typename T>
     T* newNodeClass(Node* inParent = NULL)
     {
 
       typename T::ID id = nextID();
 
-      T* node = new T(inParent, id);
+      T* node = m_storage ? storagePool<T>(*m_storage).newObject(inParent, id) : new T(inParent, id);
+      node->m_child_nodes.setStorage(m_storage);
 
-      addNode(node);
+      addNode(node, inParent);
 
       return node;
     }
@@ -72,7 +87,8 @@ public:
     Count count();
 
   private:
-    Node::List m_data;
+    Node::List   m_data;
+    NodeStorage* m_storage = nullptr;
   };
 
   void setPosition(float inX, float inY, float inZ);
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include "Camera.h"
+#include "Node.h"
+#include "ObjectPool.h"
+#include "Renderable.h"
+
+/*
+	Backing store for the nodes, cameras and renderables
+	of a scene. Lists created from a list bound to a
+	storage inherit it, so a whole hierarchy lives in
+	the same pools and is released together with its scene.
+*/
+struct NodeStorage
+{
+  ObjectPool<Node>       nodes;
+  ObjectPool<Camera>     cameras;
+  ObjectPool<Renderable> renderables;
+};
+
+template <>
+inline ObjectPool<Node>& storagePool<Node>(NodeStorage& inStorage)
+{
+  return inStorage.nodes;
+}
+
+template <>
+inline ObjectPool<Camera>& storagePool<Camera>(NodeStorage& inStorage)
+{
+  return inStorage.cameras;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include <new>
+#include <stdint.h>
+#include <stdlib.h>
+#include <utility>
+#include <vector>
+
+/*
+	Fixed size object store.
+	Objects are placement-constructed into chunks of
+	contiguous slots. Freed slots are kept on an
+	intrusive free list and reused first, so both
+	newObject and deleteObject are O(1). Pointers stay
+	valid until the object is deleted or the pool is
+	cleared, as chunks are never moved.
+*/
+template <typename T, size_t ChunkSize = 256>
+class ObjectPool
+{
+public:
+  typedef size_t Count;
+
+  ObjectPool() {}
+
+  ~ObjectPool() { clear(); }
+
+  template <typename... Args>
+  T* newObject(Args&&... inArgs)
+  {
+    Slot* slot = m_free_list;
+
+    if(slot)
+    {
+      m_free_list = slot->next;
+    }
+    else
+    {
+      if(m_chunks.empty() || m_chunk_used == ChunkSize)
+      {
+        m_chunks.push_back((Slot*)malloc(sizeof(Slot) * ChunkSize));
+        m_chunk_used = 0;
+      }
+      slot       = &m_chunks.back()[m_chunk_used++];
+      slot->live = false;
+    }
+
+    T* outObject = new(slot->storage) T(std::forward<Args>(inArgs)...);
+    slot->live   = true;
+    ++m_count;
+    return outObject;
+  }
+
+  void deleteObject(T* inObject)
+  {
+    if(!inObject)
+      return;
+
+    Slot* slot = (Slot*)inObject;
+    if(!slot->live)
+      return;
+
+    inObject->~T();
+    slot->live  = false;
+    slot->next  = m_free_list;
+    m_free_list = slot;
+    --m_count;
+  }
+
+  /*
+		Destroys every live object and returns
+		all chunks to the system in one go.
+	*/
+  void clear()
+  {
+    size_t chunkCount = m_chunks.size();
+    for(size_t c = 0; c < chunkCount; ++c)
+    {
+      size_t used = (c == chunkCount - 1) ? m_chunk_used : ChunkSize;
+      for(size_t i = 0; i < used; ++i)
+      {
+        Slot& slot = m_chunks[c][i];
+        if(slot.live)
+        {
+          ((T*)slot.storage)->~T();
+        }
+      }
+      free(m_chunks[c]);
+    }
+
+    m_chunks.clear();
+    m_chunk_used = 0;
+    m_free_list  = nullptr;
+    m_count      = 0;
+  }
+
+  Count count() const { return m_count; }
+
+  /*
+		True when inObject lives in one of this pool's
+		chunks. Lists that also accept externally
+		allocated objects use this before deleting.
+	*/
+  bool owns(const T* inObject) const
+  {
+    const uint8_t* ptr = (const uint8_t*)inObject;
+    for(size_t c = 0; c < m_chunks.size(); ++c)
+    {
+      const uint8_t* begin = (const uint8_t*)m_chunks[c];
+      if(ptr >= begin && ptr < begin + sizeof(Slot) * ChunkSize)
+        return true;
+    }
+    return false;
+  }
+
+private:
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  struct Slot
+  {
+    union
+    {
+      alignas(T) uint8_t storage[sizeof(T)];
+      Slot* next;
+    };
+    bool live;
+  };
+
+  std::vector<Slot*> m_chunks;
+  size_t             m_chunk_used = 0;
+  Slot*              m_free_list  = nullptr;
+  Count              m_count      = 0;
+};
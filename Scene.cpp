@@ -25,11 +25,17 @@
 Scene::Scene()
     : m_id(0)
 {
+  m_root_nodes.setStorage(&m_node_storage);
+  m_camera_list.setStorage(&m_node_storage);
+  m_light_list.setStorage(&m_node_storage);
 }
 
 Scene::Scene(const Scene::ID& inID)
     : m_id(inID)
 {
+  m_root_nodes.setStorage(&m_node_storage);
+  m_camera_list.setStorage(&m_node_storage);
+  m_light_list.setStorage(&m_node_storage);
 }
 
 void Scene::update()
@@ -23,6 +23,7 @@
 
 #include "Camera.h"
 #include "Node.h"
+#include "NodeStorage.h"
 #include "Types.h"
 #include <map>
 #include <stdint.h>
@@ -56,6 +57,12 @@ public:
 private:
   ID m_id;
 
+  /*
+		Owns every node created through the scene's
+		lists. Released in bulk when the scene is deleted.
+	*/
+  NodeStorage m_node_storage;
+
   Node::NodeList m_root_nodes;
   Node::NodeList m_camera_list;
   Node::NodeList m_light_list;
@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#include "VKSCache.h"
+#include "nvh/nvprint.hpp"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+VKSMappedFile::VKSMappedFile() {}
+
+VKSMappedFile::~VKSMappedFile()
+{
+  unmap();
+}
+
+bool VKSMappedFile::map(const std::string& inPath)
+{
+  unmap();
+
+#if defined(WIN32)
+  HANDLE file = CreateFileA(inPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(!mapping)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  m_data    = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  m_size    = size_t(size.QuadPart);
+  m_file    = file;
+  m_mapping = mapping;
+#else
+  int fd = open(inPath.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* ptr = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if(ptr == MAP_FAILED)
+    return false;
+
+  m_data = (const uint8_t*)ptr;
+  m_size = size_t(st.st_size);
+#endif
+
+  if(!m_data)
+  {
+    unmap();
+    return false;
+  }
+  return true;
+}
+
+void VKSMappedFile::unmap()
+{
+#if defined(WIN32)
+  if(m_data)
+    UnmapViewOfFile(m_data);
+  if(m_mapping)
+    CloseHandle((HANDLE)m_mapping);
+  if(m_file)
+    CloseHandle((HANDLE)m_file);
+  m_mapping = nullptr;
+  m_file    = nullptr;
+#else
+  if(m_data)
+    munmap((void*)m_data, m_size);
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
+
+uint64_t hashVKSFile(const std::string& inPath)
+{
+  VKSMappedFile file;
+  if(!file.map(inPath))
+    return 0;
+
+  const uint8_t* data = file.getData();
+  size_t         sz   = file.getSize();
+
+  uint64_t hash = 14695981039346656037ULL;
+  for(size_t i = 0; i < sz; ++i)
+  {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+VKSCache::VKSCache() {}
+
+VKSCache::~VKSCache()
+{
+  close();
+}
+
+bool VKSCache::sectionValid(const VKSCacheSection& inSection, size_t inElementSize) const
+{
+  if(inSection.offset > m_file.getSize())
+    return false;
+
+  /*
+	Divide rather than multiply, so a huge
+	count cannot wrap round to a small size.
+	*/
+  return inSection.count <= (m_file.getSize() - inSection.offset) / inElementSize;
+}
+
+static bool rangeValid(uint64_t inFirst, uint64_t inCount, uint64_t inTotal)
+{
+  return inFirst <= inTotal && inCount <= inTotal - inFirst;
+}
+
+/*
+	Checks every index the load follows against
+	the section it points into. A node's parent
+	must come before it, as nodes are created in
+	record order. Vertex indices are read on the
+	host for bounds and by the GPU from the VBO,
+	so each one has to land inside the vertices.
+*/
+bool VKSCache::indicesValid() const
+{
+  const VKSCacheHeader* header  = m_header;
+  uint64_t              nodeCnt = header->nodes.count;
+  uint64_t              vtxCnt  = header->vertices.count / 8;
+
+  const VKSMeshRecord* meshes  = get<VKSMeshRecord>(header->meshes);
+  const uint32_t*      indices = get<uint32_t>(header->indices);
+  for(uint64_t i = 0; i < header->meshes.count; ++i)
+  {
+    const VKSMeshRecord& mesh = meshes[i];
+    if(!rangeValid(mesh.firstIndex, mesh.indexCount, header->indices.count)
+       || !rangeValid(mesh.firstVertex, mesh.vertexCount, vtxCnt))
+      return false;
+
+    for(uint32_t j = 0; j < mesh.indexCount; ++j)
+    {
+      if(uint64_t(mesh.firstVertex) + indices[mesh.firstIndex + j] >= vtxCnt)
+        return false;
+    }
+  }
+
+  const VKSMaterialRecord* materials = get<VKSMaterialRecord>(header->materials);
+  for(uint64_t i = 0; i < header->materials.count; ++i)
+  {
+    if(!rangeValid(materials[i].firstTexture, materials[i].textureCount, header->textures.count))
+      return false;
+  }
+
+  const VKSAnimationNodeRecord* animNodes = get<VKSAnimationNodeRecord>(header->animationNodes);
+  for(uint64_t i = 0; i < header->animationNodes.count; ++i)
+  {
+    const VKSAnimationNodeRecord& node = animNodes[i];
+    if(!rangeValid(node.firstPosition, node.positionCount, header->animationKeys.count)
+       || !rangeValid(node.firstRotation, node.rotationCount, header->animationKeys.count)
+       || !rangeValid(node.firstScale, node.scaleCount, header->animationKeys.count)
+       || memchr(node.name, 0, sizeof(node.name)) == NULL)
+      return false;
+  }
+
+  const VKSCacheNodeRecord* nodes = get<VKSCacheNodeRecord>(header->nodes);
+  for(uint64_t i = 0; i < nodeCnt; ++i)
+  {
+    if(nodes[i].parent >= int64_t(i) || nodes[i].parent < -1 || nodes[i].meshIndex >= header->meshes.count)
+      return false;
+  }
+
+  const VKSCacheBindingRecord* bindings = get<VKSCacheBindingRecord>(header->bindings);
+  for(uint64_t i = 0; i < header->bindings.count; ++i)
+  {
+    if(bindings[i].node >= nodeCnt)
+      return false;
+  }
+
+  if(header->rotorNode < -1 || header->rotorNode >= int64_t(nodeCnt))
+    return false;
+
+  /*
+	The order has to be a permutation, or the
+	reorder would drop some nodes and repeat
+	others.
+	*/
+  const uint32_t*   order = get<uint32_t>(header->order);
+  std::vector<bool> seen(size_t(nodeCnt), false);
+  for(uint64_t i = 0; i < nodeCnt; ++i)
+  {
+    if(order[i] >= nodeCnt || seen[order[i]])
+      return false;
+    seen[order[i]] = true;
+  }
+
+  /*
+	The indirect commands go to the GPU as they
+	are, so they must draw exactly their node's
+	mesh.
+	*/
+  const VkDrawIndexedIndirectCommand* commands = get<VkDrawIndexedIndirectCommand>(header->commands);
+  for(uint64_t i = 0; i < nodeCnt; ++i)
+  {
+    const VKSMeshRecord& mesh = meshes[nodes[order[i]].meshIndex];
+    if(commands[i].firstIndex != mesh.firstIndex || commands[i].indexCount != mesh.indexCount
+       || commands[i].vertexOffset != int32_t(mesh.firstVertex))
+      return false;
+  }
+
+  return true;
+}
+
+bool VKSCache::open(const std::string& inPath, uint64_t inSourceHash, uint32_t inDrawKeyOrder)
+{
+  close();
+
+  if(inSourceHash == 0 || !m_file.map(inPath))
+    return false;
+
+  if(m_file.getSize() < sizeof(VKSCacheHeader))
+  {
+    close();
+    return false;
+  }
+
+  const VKSCacheHeader* header = (const VKSCacheHeader*)m_file.getData();
+  if(header->magic != VKS_CACHE_MAGIC || header->version != VKS_CACHE_VERSION || header->sourceHash != inSourceHash
+     || header->drawKeyOrder != inDrawKeyOrder)
+  {
+    close();
+    return false;
+  }
+
+  m_header = header;
+
+  bool valid = sectionValid(header->vertices, sizeof(float)) && sectionValid(header->indices, sizeof(uint32_t))
+               && sectionValid(header->meshes, sizeof(VKSMeshRecord))
+               && sectionValid(header->materials, sizeof(VKSMaterialRecord))
+               && sectionValid(header->textures, sizeof(VKSTextureRecord))
+               && sectionValid(header->nodes, sizeof(VKSCacheNodeRecord)) && sectionValid(header->order, sizeof(uint32_t))
+               && sectionValid(header->commands, sizeof(VkDrawIndexedIndirectCommand))
+               && sectionValid(header->animationNodes, sizeof(VKSAnimationNodeRecord))
+               && sectionValid(header->animationKeys, sizeof(VKSAnimationKeyRecord))
+               && sectionValid(header->bindings, sizeof(VKSCacheBindingRecord));
+
+  if(!valid || header->order.count != header->nodes.count || header->commands.count != header->nodes.count)
+  {
+    LOGE("Scene cache %s is truncated, ignoring it.\n", inPath.c_str());
+    close();
+    return false;
+  }
+
+  if(!indicesValid())
+  {
+    LOGE("Scene cache %s has indices out of range, ignoring it.\n", inPath.c_str());
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void VKSCache::close()
+{
+  m_header = nullptr;
+  m_file.unmap();
+}
+
+VKSCache::Writer::Writer()
+{
+  m_blob.resize(sizeof(VKSCacheHeader), 0);
+}
+
+VKSCacheSection VKSCache::Writer::addBytes(const void* inData, size_t inSize, size_t inCount)
+{
+  size_t offset = (m_blob.size() + 15) & ~size_t(15);
+  m_blob.resize(offset + inSize, 0);
+  if(inSize > 0)
+    memcpy(m_blob.data() + offset, inData, inSize);
+
+  VKSCacheSection outSection;
+  outSection.offset = offset;
+  outSection.count  = inCount;
+  return outSection;
+}
+
+bool VKSCache::Writer::save(const std::string& inPath, VKSCacheHeader& inHeader)
+{
+  inHeader.magic   = VKS_CACHE_MAGIC;
+  inHeader.version = VKS_CACHE_VERSION;
+  memcpy(m_blob.data(), &inHeader, sizeof(VKSCacheHeader));
+
+  /*
+		Write to a temporary file and rename it so a
+		reader never maps a partially written cache.
+	*/
+  std::string tmpPath = inPath + ".tmp";
+  FILE*       fp      = fopen(tmpPath.c_str(), "wb");
+  if(!fp)
+    return false;
+
+  size_t written = fwrite(m_blob.data(), 1, m_blob.size(), fp);
+  fclose(fp);
+
+  if(written != m_blob.size())
+  {
+    remove(tmpPath.c_str());
+    return false;
+  }
+
+  remove(inPath.c_str());
+  return rename(tmpPath.c_str(), inPath.c_str()) == 0;
+}
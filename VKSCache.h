@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include "VKSFile.h"
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/*
+	Binary snapshot of a fully built VKS scene.
+	The file is a header followed by 16 byte
+	aligned arrays. It is keyed by a hash of the
+	source .vks file and memory mapped on load,
+	so a warm start reads the arrays in place.
+*/
+
+#define VKS_CACHE_MAGIC 0x48435356
+#define VKS_CACHE_VERSION 3
+
+struct VKSCacheSection
+{
+  uint64_t offset;
+  uint64_t count;
+};
+
+struct VKSCacheHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sourceHash;
+  int32_t  rotorNode;
+  uint32_t drawKeyOrder;  //VkeDrawKeys::getOrderCode of the node order
+
+  VKSCacheSection vertices;        //float
+  VKSCacheSection indices;         //uint32_t
+  VKSCacheSection meshes;          //VKSMeshRecord
+  VKSCacheSection materials;       //VKSMaterialRecord
+  VKSCacheSection textures;        //VKSTextureRecord
+  VKSCacheSection nodes;           //VKSCacheNodeRecord
+  VKSCacheSection order;           //uint32_t
+  VKSCacheSection commands;        //VkDrawIndexedIndirectCommand
+  VKSCacheSection animationNodes;  //VKSAnimationNodeRecord
+  VKSCacheSection animationKeys;   //VKSAnimationKeyRecord
+  VKSCacheSection bindings;        //VKSCacheBindingRecord
+};
+
+/*
+	One entry of the flattened hierarchy, in
+	creation order so a parent always precedes
+	its children. parent is -1 for root nodes.
+*/
+struct VKSCacheNodeRecord
+{
+  int32_t   parent;
+  uint32_t  nodeID;
+  uint32_t  meshIndex;
+  uint32_t  padding;
+  glm::quat rotation;
+  glm::vec4 position;
+  glm::vec4 scale;
+};
+
+/*
+	Binds an animation node, by name, to the
+	node data created for a flattened node.
+*/
+struct VKSCacheBindingRecord
+{
+  uint32_t node;
+  char     name[32];
+};
+
+class VKSMappedFile
+{
+public:
+  VKSMappedFile();
+  ~VKSMappedFile();
+
+  bool map(const std::string& inPath);
+  void unmap();
+
+  const uint8_t* getData() const { return m_data; }
+  size_t         getSize() const { return m_size; }
+
+private:
+  VKSMappedFile(const VKSMappedFile&) = delete;
+  VKSMappedFile& operator=(const VKSMappedFile&) = delete;
+
+  const uint8_t* m_data = nullptr;
+  size_t         m_size = 0;
+#if defined(WIN32)
+  void* m_file    = nullptr;
+  void* m_mapping = nullptr;
+#endif
+};
+
+class VKSCache
+{
+public:
+  VKSCache();
+  ~VKSCache();
+
+  /*
+		Maps inPath and checks it against the source
+		hash and draw key order. Returns false on any
+		mismatch.
+	*/
+  bool open(const std::string& inPath, uint64_t inSourceHash, uint32_t inDrawKeyOrder);
+  void close();
+
+  bool isOpen() const { return m_header != nullptr; }
+
+  const VKSCacheHeader* getHeader() const { return m_header; }
+
+  template <typename T>
+  const T* get(const VKSCacheSection& inSection) const
+  {
+    return (const T*)(m_file.getData() + inSection.offset);
+  }
+
+  class Writer
+  {
+  public:
+    Writer();
+
+    template <typename T>
+    VKSCacheSection add(const T* inData, size_t inCount)
+    {
+      return addBytes(inData, sizeof(T) * inCount, inCount);
+    }
+
+    bool save(const std::string& inPath, VKSCacheHeader& inHeader);
+
+  private:
+    VKSCacheSection addBytes(const void* inData, size_t inSize, size_t inCount);
+
+    std::vector<uint8_t> m_blob;
+  };
+
+private:
+  bool sectionValid(const VKSCacheSection& inSection, size_t inElementSize) const;
+  bool indicesValid() const;
+
+  VKSMappedFile         m_file;
+  const VKSCacheHeader* m_header = nullptr;
+};
+
+/*
+	FNV-1a hash of a file's contents.
+	Returns 0 if the file cannot be read.
+*/
+uint64_t hashVKSFile(const std::string& inPath);
@@ -38,29 +38,41 @@ void fread_s(void* inBuffer, size_t inBufSize, size_t inSize, size_t inCount, FI
 
 #endif
 
-void readVKSFile(VKSFile* inFile)
+std::string findVKSFile(const std::string& inFileName)
 {
-  FILE* fp = nullptr;
-
   std::vector<std::string> searchPaths;
   searchPaths.push_back(std::string("."));
   searchPaths.push_back(std::string("./resources_" PROJECT_NAME));
   searchPaths.push_back(std::string(PROJECT_NAME));
   searchPaths.push_back(NVPSystem::exePath() + std::string(PROJECT_RELDIRECTORY));
 
-  std::string filePath;
   for(uint32_t i = 0; i < searchPaths.size(); ++i)
   {
-    filePath = searchPaths[i] + "/" + inFile->outputFile;
+    std::string filePath = searchPaths[i] + "/" + inFileName;
 
+    FILE* fp = nullptr;
     fopen_s(&fp, filePath.c_str(), "rb");
     if(fp)
-      break;
+    {
+      fclose(fp);
+      return filePath;
+    }
   }
 
+  return std::string();
+}
+
+void readVKSFile(VKSFile* inFile)
+{
+  FILE* fp = nullptr;
+
+  std::string filePath = findVKSFile(inFile->outputFile);
+  if(!filePath.empty())
+    fopen_s(&fp, filePath.c_str(), "rb");
+
   if(!fp)
   {
-    LOGE("Could not load vks file %s\n", filePath.c_str());
+    LOGE("Could not load vks file %s\n", inFile->outputFile.c_str());
     exit(1);
   }
   else
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "MeshUtils.h"
+#include <string>
 #include <vector>
 
 /**************************************/
@@ -127,4 +128,11 @@ struct VKSFile
 };
 
 
+/*
+	Resolves inFileName against the resource
+	search paths. Returns an empty string if
+	the file is not found.
+*/
+std::string findVKSFile(const std::string& inFileName);
+
 void readVKSFile(VKSFile* inFile);
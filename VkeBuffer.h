@@ -57,6 +57,7 @@ public:
     if(m_backing_store == NULL)
       return;
     free(m_backing_store);
+    m_backing_store = NULL;
   }
 
   void initBackingStore(size_t inSize)
@@ -226,10 +226,13 @@ void VkeCamera::lookAt(glm::vec4& inPos)
 void VkeCamera::setLookAtMatrix(glm::mat4& inMat)
 {
   m_look_at_matrix = inMat;
-  glm::mat4 inv    = glm::inverse(inMat);
-  m_position.x     = inv[0][3];
-  m_position.y     = inv[1][3];
-  m_position.z     = inv[2][3];
+
+  /*
+	The eye is the translation of the inverse
+	view, which glm keeps in the last column.
+	*/
+  glm::mat4 inv = glm::inverse(inMat);
+  m_position    = glm::vec3(inv[3]);
 
   m_use_look_at = true;
 }
@@ -107,6 +107,10 @@ public:
   void lookAt(glm::vec4& inPosition);
   void setLookAtMatrix(glm::mat4& inMat);
 
+  const glm::mat4& getViewProjection() { return m_backing_store->proj_view_matrix; }
+
+  const glm::vec3& getPosition() const { return m_position; }
+
 private:
   void updateProjection();
   void updateTransform();
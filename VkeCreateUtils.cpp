@@ -1029,11 +1029,13 @@ void deviceCreateInfo(VkDeviceCreateInfo*       outInfo,
                       const char* const*        inExtensionNames,
                       uint32_t                  inLayerCount,
                       const char* const*        inLayerNames,
-                      VkPhysicalDeviceFeatures* inFeatures)
+                      VkPhysicalDeviceFeatures* inFeatures,
+                      const void*               inNext)
 {
 
   memset(outInfo, 0, sizeof(VkDeviceCreateInfo));
   outInfo->sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  outInfo->pNext                   = inNext;
   outInfo->queueCreateInfoCount    = inQueueCount;
   outInfo->pQueueCreateInfos       = inQueues;
   outInfo->enabledLayerCount       = inLayerCount;
@@ -1051,12 +1053,13 @@ void deviceCreate(VkDevice*                 outDevice,
                   const char* const*        inExtensionNames,
                   uint32_t                  inLayerCount,
                   const char* const*        inLayerNames,
-                  VkPhysicalDeviceFeatures* inFeatures)
+                  VkPhysicalDeviceFeatures* inFeatures,
+                  const void*               inNext)
 {
 
   VkDeviceCreateInfo devInfo;
 
-  deviceCreateInfo(&devInfo, 1, inQueues, inExtensionCount, NULL, inLayerCount, inLayerNames, inFeatures);
+  deviceCreateInfo(&devInfo, 1, inQueues, inExtensionCount, inExtensionNames, inLayerCount, inLayerNames, inFeatures, inNext);
 
   VKA_CHECK_ERROR(vkCreateDevice(*inPhysicalDevice, &devInfo, NULL, outDevice), "Could not create logical device.\n");
 }
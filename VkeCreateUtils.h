@@ -372,7 +372,8 @@ void deviceCreateInfo(VkDeviceCreateInfo*       outInfo,
                       const char* const*        inExtensionNames,
                       uint32_t                  inLayerCount = 0,
                       const char* const*        inLayerNames = NULL,
-                      VkPhysicalDeviceFeatures* inFeatures   = NULL);
+                      VkPhysicalDeviceFeatures* inFeatures   = NULL,
+                      const void*               inNext       = NULL);
 
 void deviceCreate(VkDevice*                 outDevice,
                   VkPhysicalDevice*         inPhysicalDevice,
@@ -382,4 +383,5 @@ void deviceCreate(VkDevice*                 outDevice,
                   const char* const*        inExtensionNames,
                   uint32_t                  inLayerCount = 0,
                   const char* const*        inLayerNames = NULL,
-                  VkPhysicalDeviceFeatures* inFeatures   = NULL);
+                  VkPhysicalDeviceFeatures* inFeatures   = NULL,
+                  const void*               inNext       = NULL);
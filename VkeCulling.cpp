@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#include "VkeCulling.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define VKE_CULL_SSE 1
+#endif
+
+static inline bool sphereVisible(const Frustum& inFrustum, float inX, float inY, float inZ, float inRadius)
+{
+  for(int p = 0; p < 6; ++p)
+  {
+    const glm::vec4& plane = inFrustum.m_planes[p];
+    if(plane.x * inX + plane.y * inY + plane.z * inZ + plane.w < -inRadius)
+      return false;
+  }
+  return true;
+}
+
+uint32_t cullSpheres(const Frustum& inFrustum,
+                     const float*   inX,
+                     const float*   inY,
+                     const float*   inZ,
+                     const float*   inRadius,
+                     uint32_t       inFirst,
+                     uint32_t       inCount,
+                     uint32_t*      outVisible)
+{
+  uint32_t visible = 0;
+  uint32_t i       = inFirst;
+  uint32_t end     = inFirst + inCount;
+
+#if defined(VKE_CULL_SSE)
+  __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+  for(int p = 0; p < 6; ++p)
+  {
+    planeX[p] = _mm_set1_ps(inFrustum.m_planes[p].x);
+    planeY[p] = _mm_set1_ps(inFrustum.m_planes[p].y);
+    planeZ[p] = _mm_set1_ps(inFrustum.m_planes[p].z);
+    planeW[p] = _mm_set1_ps(inFrustum.m_planes[p].w);
+  }
+
+  for(; i + 4 <= end; i += 4)
+  {
+    __m128 x         = _mm_loadu_ps(inX + i);
+    __m128 y         = _mm_loadu_ps(inY + i);
+    __m128 z         = _mm_loadu_ps(inZ + i);
+    __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(inRadius + i));
+
+    __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[0], x), _mm_mul_ps(planeY[0], y)),
+                                            _mm_add_ps(_mm_mul_ps(planeZ[0], z), planeW[0])),
+                                 negRadius);
+    for(int p = 1; p < 6; ++p)
+    {
+      __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                            _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+      inside   = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+    }
+
+    /*
+			Write every index and only advance past
+			the visible ones, so there is no branch
+			per sphere.
+		*/
+    int mask = _mm_movemask_ps(inside);
+    for(int b = 0; b < 4; ++b)
+    {
+      outVisible[visible] = i + b;
+      visible += (mask >> b) & 1;
+    }
+  }
+#endif
+
+  for(; i < end; ++i)
+  {
+    if(sphereVisible(inFrustum, inX[i], inY[i], inZ[i], inRadius[i]))
+      outVisible[visible++] = i;
+  }
+
+  return visible;
+}
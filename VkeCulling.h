@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include "Bounds.h"
+#include <stdint.h>
+
+/*
+	Tests inCount spheres, starting at inFirst,
+	against the frustum planes. The spheres are
+	given as separate x, y, z and radius arrays
+	so four can be tested at once with SSE.
+	Writes the indices of the visible spheres to
+	outVisible in ascending order and returns how
+	many there were. outVisible needs room for
+	inCount indices.
+*/
+uint32_t cullSpheres(const Frustum& inFrustum,
+                     const float*   inX,
+                     const float*   inY,
+                     const float*   inZ,
+                     const float*   inRadius,
+                     uint32_t       inFirst,
+                     uint32_t       inCount,
+                     uint32_t*      outVisible);
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#include "VkeDrawKeys.h"
+#include <algorithm>
+#include <string.h>
+
+#define DRAW_KEY_RADIX_BITS 8
+#define DRAW_KEY_RADIX_PASSES (64 / DRAW_KEY_RADIX_BITS)
+#define DRAW_KEY_RADIX_BUCKETS (1 << DRAW_KEY_RADIX_BITS)
+
+/*
+	Bits per field, 64 in total so every order
+	fits. Indexed by VkeDrawKeys::Field.
+*/
+static const uint32_t s_field_bits[VkeDrawKeys::FIELD_COUNT] = {4, 8, 8, 20, 24};
+static const char     s_field_letters[]                      = "posmg";
+
+VkeDrawKeys::VkeDrawKeys()
+{
+  setOrder(s_field_letters);
+}
+
+bool VkeDrawKeys::setOrder(const std::string& inOrder)
+{
+  Field    order[FIELD_COUNT];
+  bool     used[FIELD_COUNT] = {};
+  uint32_t count             = 0;
+
+  for(char letter : inOrder)
+  {
+    const char* found = strchr(s_field_letters, letter);
+    if(letter == 0 || !found)
+      return false;
+
+    Field field = Field(found - s_field_letters);
+    if(used[field])
+      return false;
+
+    used[field]    = true;
+    order[count++] = field;
+  }
+
+  uint32_t shift = 64;
+  for(uint32_t i = 0; i < count; ++i)
+  {
+    shift -= s_field_bits[order[i]];
+    m_shift[order[i]] = shift;
+    m_order[i]        = order[i];
+  }
+
+  for(uint32_t f = 0; f < FIELD_COUNT; ++f)
+  {
+    m_used[f] = used[f];
+  }
+  m_order_count = count;
+  return true;
+}
+
+uint32_t VkeDrawKeys::getOrderCode() const
+{
+  uint32_t code = 0;
+  for(uint32_t i = 0; i < m_order_count; ++i)
+  {
+    code = (code << 3) | (uint32_t(m_order[i]) + 1);
+  }
+  return code;
+}
+
+uint64_t VkeDrawKeys::makeKey(const Inputs& inInputs) const
+{
+  /*
+	Opacity goes in inverted, so ascending keys
+	put the most opaque draws first.
+	*/
+  float    opacity       = std::min(std::max(inInputs.opacity, 0.0f), 1.0f);
+  uint32_t opacityBucket = 255 - uint32_t(opacity * 255.0f + 0.5f);
+
+  uint32_t values[FIELD_COUNT] = {inInputs.pass, opacityBucket, inInputs.pipeline, inInputs.material, inInputs.mesh};
+
+  uint64_t key = 0;
+  for(uint32_t f = 0; f < FIELD_COUNT; ++f)
+  {
+    if(!m_used[f])
+      continue;
+
+    uint64_t maxValue = (uint64_t(1) << s_field_bits[f]) - 1;
+    key |= std::min(uint64_t(values[f]), maxValue) << m_shift[f];
+  }
+  return key;
+}
+
+void VkeDrawKeys::sort(const uint64_t* inKeys, uint32_t inCount, uint32_t* outOrder)
+{
+  if(inCount == 0)
+    return;
+
+  for(uint32_t i = 0; i < 2; ++i)
+  {
+    m_keys[i].resize(inCount);
+    m_values[i].resize(inCount);
+  }
+
+  /*
+	All the histograms come from one read of the
+	keys.
+	*/
+  uint32_t histograms[DRAW_KEY_RADIX_PASSES][DRAW_KEY_RADIX_BUCKETS] = {};
+  for(uint32_t i = 0; i < inCount; ++i)
+  {
+    uint64_t key = inKeys[i];
+    for(uint32_t p = 0; p < DRAW_KEY_RADIX_PASSES; ++p)
+    {
+      histograms[p][(key >> (p * DRAW_KEY_RADIX_BITS)) & (DRAW_KEY_RADIX_BUCKETS - 1)]++;
+    }
+    m_keys[0][i]   = key;
+    m_values[0][i] = i;
+  }
+
+  uint32_t src = 0;
+  for(uint32_t p = 0; p < DRAW_KEY_RADIX_PASSES; ++p)
+  {
+    uint32_t* histogram = histograms[p];
+    uint32_t  shift     = p * DRAW_KEY_RADIX_BITS;
+
+    if(histogram[(m_keys[src][0] >> shift) & (DRAW_KEY_RADIX_BUCKETS - 1)] == inCount)
+      continue;
+
+    uint32_t offset = 0;
+    for(uint32_t b = 0; b < DRAW_KEY_RADIX_BUCKETS; ++b)
+    {
+      uint32_t count = histogram[b];
+      histogram[b]   = offset;
+      offset += count;
+    }
+
+    const uint64_t* srcKeys   = m_keys[src].data();
+    const uint32_t* srcValues = m_values[src].data();
+    uint64_t*       dstKeys   = m_keys[src ^ 1].data();
+    uint32_t*       dstValues = m_values[src ^ 1].data();
+    for(uint32_t i = 0; i < inCount; ++i)
+    {
+      uint32_t slot   = histogram[(srcKeys[i] >> shift) & (DRAW_KEY_RADIX_BUCKETS - 1)]++;
+      dstKeys[slot]   = srcKeys[i];
+      dstValues[slot] = srcValues[i];
+    }
+    src ^= 1;
+  }
+
+  memcpy(outOrder, m_values[src].data(), sizeof(uint32_t) * inCount);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+	Packs what a node draw is sorted by into one 64
+	bit key, most significant field first, so one
+	radix sort orders the draws by all of them.
+	The field order is configurable; fields left
+	out of it take no bits and do not count.
+*/
+class VkeDrawKeys
+{
+public:
+  enum Field
+  {
+    FIELD_PASS,      //see Pass
+    FIELD_OPACITY,   //most opaque first
+    FIELD_PIPELINE,  //pipeline state
+    FIELD_MATERIAL,
+    FIELD_MESH,
+    FIELD_COUNT
+  };
+
+  /*
+		Blend state a draw needs, one scene pipeline
+		each, in the order they are drawn.
+	*/
+  enum Pass
+  {
+    PASS_OPAQUE      = 0,
+    PASS_ALPHA_TEST  = 1,
+    PASS_TRANSPARENT = 2,
+    PASS_COUNT
+  };
+
+  /*
+		What one key is built from. Values too wide
+		for their field are clamped to its largest.
+	*/
+  struct Inputs
+  {
+    uint32_t pass;
+    float    opacity;
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+  };
+
+  VkeDrawKeys();
+
+  /*
+		Sets the order from field letters, most
+		significant first: p pass, o opacity,
+		s pipeline state, m material, g mesh.
+		Returns false and keeps the current order
+		if inOrder does not parse.
+	*/
+  bool setOrder(const std::string& inOrder);
+
+  /*
+		Identifies the order, so data sorted with
+		one order is not taken for another.
+	*/
+  uint32_t getOrderCode() const;
+
+  uint64_t makeKey(const Inputs& inInputs) const;
+
+  /*
+		Stable LSD radix sort of inCount keys, a byte
+		per pass. outOrder[i] is the index of the i-th
+		smallest key. Bytes that are the same in every
+		key are skipped, so unused low fields are free.
+	*/
+  void sort(const uint64_t* inKeys, uint32_t inCount, uint32_t* outOrder);
+
+private:
+  Field    m_order[FIELD_COUNT];
+  uint32_t m_order_count = 0;
+  uint32_t m_shift[FIELD_COUNT];
+  bool     m_used[FIELD_COUNT];
+
+  std::vector<uint64_t> m_keys[2];
+  std::vector<uint32_t> m_values[2];
+};
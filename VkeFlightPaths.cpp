@@ -0,0 +1,618 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#include "VkeFlightPaths.h"
+#include "VkeScenario.h"
+#include "VkeThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <math.h>
+#include <memory>
+#include <nvh/nvprint.hpp>
+
+/*
+	Swarm steering. Paths are handed to the thread
+	pool in chunks, and each path looks at no more
+	than SWARM_NEIGHBOURS others. The gains are
+	accelerations per unit radius; the spring and
+	damping together return an offset to the line
+	without overshoot. Long frames are clamped to
+	SWARM_MAX_STEP to keep the integration stable.
+*/
+#define SWARM_CHUNK_SIZE 4096
+#define SWARM_NEIGHBOURS 8
+#define SWARM_SEPARATION 8.0f
+#define SWARM_SPRING 1.0f
+#define SWARM_DAMPING 2.0f
+#define SWARM_MAX_STEP 0.1f
+
+/*
+	Hashes a cell coordinate into the table.
+	Distinct cells may share a slot, which only
+	adds candidates the distance test rejects.
+*/
+static inline uint32_t swarmCellHash(int32_t inX, int32_t inY, int32_t inZ, uint32_t inMask)
+{
+  return ((uint32_t(inX) * 73856093u) ^ (uint32_t(inY) * 19349663u) ^ (uint32_t(inZ) * 83492791u)) & inMask;
+}
+
+VkeFlightPaths::VkeFlightPaths() {}
+
+VkeFlightPaths::~VkeFlightPaths() {}
+
+void VkeFlightPaths::resize(uint32_t inCount)
+{
+  m_start_x.resize(inCount, 0.0f);
+  m_start_y.resize(inCount, 0.0f);
+  m_range_x.resize(inCount, 0.0f);
+  m_range_y.resize(inCount, 1.0f);
+  m_t.resize(inCount, 0.0f);
+  m_velocity.resize(inCount, 0.06f);
+  m_altitude.resize(inCount, 10.0f);
+  m_cos_heading.resize(inCount, 1.0f);
+  m_sin_heading.resize(inCount, 0.0f);
+  m_scale.resize(inCount, 1.0f);
+  m_rotation_xy.resize(inCount, 0);
+  m_rotation_zw.resize(inCount, 0);
+  m_offset_x.resize(inCount, 0.0f);
+  m_offset_y.resize(inCount, 0.0f);
+  m_offset_z.resize(inCount, 0.0f);
+  m_drift_x.resize(inCount, 0.0f);
+  m_drift_y.resize(inCount, 0.0f);
+  m_drift_z.resize(inCount, 0.0f);
+
+  if(isSwarm())
+    setSwarm(m_swarm_radius);
+}
+
+void VkeFlightPaths::setPath(uint32_t         inIndex,
+                             const glm::vec2& inStart,
+                             const glm::vec2& inEnd,
+                             float            inStartT,
+                             float            inAltitude,
+                             float            inVelocity,
+                             float            inScale)
+{
+  glm::vec2 range   = inEnd - inStart;
+  float     heading = atan2f(range.x, range.y);
+
+  m_start_x[inIndex]     = inStart.x;
+  m_start_y[inIndex]     = inStart.y;
+  m_range_x[inIndex]     = range.x;
+  m_range_y[inIndex]     = range.y;
+  m_t[inIndex]           = inStartT;
+  m_velocity[inIndex]    = inVelocity;
+  m_altitude[inIndex]    = inAltitude;
+  m_cos_heading[inIndex] = cosf(heading);
+  m_sin_heading[inIndex] = sinf(heading);
+  m_scale[inIndex]       = inScale;
+
+  glm::quat rotation = glm::angleAxis(heading, glm::vec3(0.0f, 1.0f, 0.0f))
+                       * glm::angleAxis(glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+  uint64_t packed = glm::packSnorm4x16(glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w));
+
+  m_rotation_xy[inIndex] = uint32_t(packed);
+  m_rotation_zw[inIndex] = uint32_t(packed >> 32);
+}
+
+/*
+	Advances t on its own. This loop has no
+	stores other than t, so the compiler can
+	vectorise it.
+*/
+void VkeFlightPaths::advance(float inDeltaTime)
+{
+  size_t cnt = m_t.size();
+
+  float* __restrict       t        = m_t.data();
+  const float* __restrict velocity = m_velocity.data();
+
+  for(size_t i = 0; i < cnt; ++i)
+  {
+    float nt = t[i] + velocity[i] * inDeltaTime;
+    t[i]     = nt - floorf(nt);
+  }
+}
+
+void VkeFlightPaths::update(float inDeltaTime, float* outMatrices, size_t inStride)
+{
+  advance(inDeltaTime);
+
+  /*
+		Emit translate(x, altitude, y) * rotateY(heading)
+		* rotateX(-90) * scale, expanded to its columns.
+	*/
+  size_t cnt = m_t.size();
+
+  const float* __restrict t      = m_t.data();
+  const float* __restrict startX = m_start_x.data();
+  const float* __restrict startY = m_start_y.data();
+  const float* __restrict rangeX = m_range_x.data();
+  const float* __restrict rangeY = m_range_y.data();
+  const float* __restrict alt    = m_altitude.data();
+  const float* __restrict c      = m_cos_heading.data();
+  const float* __restrict s      = m_sin_heading.data();
+  const float* __restrict scale  = m_scale.data();
+  const float* __restrict offX   = m_offset_x.data();
+  const float* __restrict offY   = m_offset_y.data();
+  const float* __restrict offZ   = m_offset_z.data();
+
+  for(size_t i = 0; i < cnt; ++i)
+  {
+    float* __restrict m = outMatrices + i * inStride;
+
+    m[0]  = c[i] * scale[i];
+    m[1]  = 0.0f;
+    m[2]  = -s[i] * scale[i];
+    m[3]  = 0.0f;
+    m[4]  = -s[i] * scale[i];
+    m[5]  = 0.0f;
+    m[6]  = -c[i] * scale[i];
+    m[7]  = 0.0f;
+    m[8]  = 0.0f;
+    m[9]  = scale[i];
+    m[10] = 0.0f;
+    m[11] = 0.0f;
+    m[12] = rangeX[i] * t[i] + startX[i] + offX[i];
+    m[13] = alt[i] + offY[i];
+    m[14] = rangeY[i] * t[i] + startY[i] + offZ[i];
+    m[15] = 1.0f;
+  }
+}
+
+void VkeFlightPaths::updateCompact(float inDeltaTime, VkeInstanceRecord* outRecords)
+{
+  advance(inDeltaTime);
+
+  size_t cnt = m_t.size();
+
+  const float* __restrict t      = m_t.data();
+  const float* __restrict startX = m_start_x.data();
+  const float* __restrict startY = m_start_y.data();
+  const float* __restrict rangeX = m_range_x.data();
+  const float* __restrict rangeY = m_range_y.data();
+  const float* __restrict alt    = m_altitude.data();
+  const float* __restrict scale  = m_scale.data();
+  const float* __restrict offX   = m_offset_x.data();
+  const float* __restrict offY   = m_offset_y.data();
+  const float* __restrict offZ   = m_offset_z.data();
+
+  for(size_t i = 0; i < cnt; ++i)
+  {
+    VkeInstanceRecord& r = outRecords[i];
+
+    r.position[0] = rangeX[i] * t[i] + startX[i] + offX[i];
+    r.position[1] = alt[i] + offY[i];
+    r.position[2] = rangeY[i] * t[i] + startY[i] + offZ[i];
+    r.scale       = scale[i];
+    r.rotation[0] = m_rotation_xy[i];
+    r.rotation[1] = m_rotation_zw[i];
+  }
+}
+
+glm::vec3 VkeFlightPaths::getPosition(uint32_t inIndex) const
+{
+  return glm::vec3(m_range_x[inIndex] * m_t[inIndex] + m_start_x[inIndex] + m_offset_x[inIndex],
+                   m_altitude[inIndex] + m_offset_y[inIndex],
+                   m_range_y[inIndex] * m_t[inIndex] + m_start_y[inIndex] + m_offset_z[inIndex]);
+}
+
+glm::mat4 VkeFlightPaths::getMatrix(uint32_t inIndex) const
+{
+  float c = m_cos_heading[inIndex] * m_scale[inIndex];
+  float s = m_sin_heading[inIndex] * m_scale[inIndex];
+
+  return glm::mat4(glm::vec4(c, 0.0f, -s, 0.0f), glm::vec4(-s, 0.0f, -c, 0.0f), glm::vec4(0.0f, m_scale[inIndex], 0.0f, 0.0f),
+                   glm::vec4(getPosition(inIndex), 1.0f));
+}
+
+void VkeFlightPaths::getRecords(VkeFlightRecord* outRecords) const
+{
+  for(size_t i = 0; i < m_t.size(); ++i)
+  {
+    outRecords[i].path        = glm::vec4(m_start_x[i], m_start_y[i], m_range_x[i], m_range_y[i]);
+    outRecords[i].motion      = glm::vec4(m_cos_heading[i], m_sin_heading[i], m_altitude[i], m_velocity[i]);
+    outRecords[i].t           = m_t[i];
+    outRecords[i].scale       = m_scale[i];
+    outRecords[i].rotation[0] = m_rotation_xy[i];
+    outRecords[i].rotation[1] = m_rotation_zw[i];
+  }
+}
+
+void VkeFlightPaths::getSpheres(float inRadius, uint32_t inFirst, uint32_t inCount, float* outX, float* outY, float* outZ, float* outRadius) const
+{
+  const float* __restrict t      = m_t.data();
+  const float* __restrict startX = m_start_x.data();
+  const float* __restrict startY = m_start_y.data();
+  const float* __restrict rangeX = m_range_x.data();
+  const float* __restrict rangeY = m_range_y.data();
+  const float* __restrict alt    = m_altitude.data();
+  const float* __restrict scale  = m_scale.data();
+  const float* __restrict offX   = m_offset_x.data();
+  const float* __restrict offY   = m_offset_y.data();
+  const float* __restrict offZ   = m_offset_z.data();
+
+  for(size_t i = inFirst; i < size_t(inFirst) + inCount; ++i)
+  {
+    outX[i]      = rangeX[i] * t[i] + startX[i] + offX[i];
+    outY[i]      = alt[i] + offY[i];
+    outZ[i]      = rangeY[i] * t[i] + startY[i] + offZ[i];
+    outRadius[i] = inRadius * scale[i];
+  }
+}
+
+void VkeFlightPaths::setSwarm(float inRadius)
+{
+  m_swarm_radius = std::max(inRadius, 0.0f);
+
+  std::fill(m_offset_x.begin(), m_offset_x.end(), 0.0f);
+  std::fill(m_offset_y.begin(), m_offset_y.end(), 0.0f);
+  std::fill(m_offset_z.begin(), m_offset_z.end(), 0.0f);
+  std::fill(m_drift_x.begin(), m_drift_x.end(), 0.0f);
+  std::fill(m_drift_y.begin(), m_drift_y.end(), 0.0f);
+  std::fill(m_drift_z.begin(), m_drift_z.end(), 0.0f);
+
+  if(!isSwarm())
+  {
+    m_cell_mask = 0;
+    m_pos_x.clear();
+    m_pos_y.clear();
+    m_pos_z.clear();
+    m_path_cell.clear();
+    m_cell_start.clear();
+    m_cell_paths.clear();
+    return;
+  }
+
+  /*
+	Twice as many slots as paths keeps the
+	chains short.
+	*/
+  size_t   cnt   = m_t.size();
+  uint32_t slots = 1;
+  while(slots < cnt * 2)
+    slots <<= 1;
+
+  m_cell_mask = slots - 1;
+  m_pos_x.resize(cnt);
+  m_pos_y.resize(cnt);
+  m_pos_z.resize(cnt);
+  m_path_cell.resize(cnt);
+  m_cell_start.resize(size_t(slots) + 1);
+  m_cell_paths.resize(cnt);
+}
+
+void VkeFlightPaths::buildCells(VkeThreadPool& inPool)
+{
+  uint32_t cnt        = count();
+  uint32_t chunkCount = (cnt + SWARM_CHUNK_SIZE - 1) / SWARM_CHUNK_SIZE;
+  float    invCell    = 1.0f / m_swarm_radius;
+
+  inPool.run(chunkCount, [&](uint32_t inChunk) {
+    uint32_t first = inChunk * SWARM_CHUNK_SIZE;
+    uint32_t last  = std::min(first + SWARM_CHUNK_SIZE, cnt);
+
+    for(uint32_t i = first; i < last; ++i)
+    {
+      float x = m_range_x[i] * m_t[i] + m_start_x[i] + m_offset_x[i];
+      float y = m_altitude[i] + m_offset_y[i];
+      float z = m_range_y[i] * m_t[i] + m_start_y[i] + m_offset_z[i];
+
+      m_pos_x[i]     = x;
+      m_pos_y[i]     = y;
+      m_pos_z[i]     = z;
+      m_path_cell[i] = swarmCellHash(int32_t(floorf(x * invCell)), int32_t(floorf(y * invCell)),
+                                     int32_t(floorf(z * invCell)), m_cell_mask);
+    }
+  });
+
+  /*
+	Counting sort of the paths by slot: count into
+	the entry after each slot, sum, then scatter,
+	which leaves each entry at its slot's end, so
+	shift them back by one. Paths stay in index
+	order within a slot, so the neighbours found
+	do not depend on the thread count.
+	*/
+  uint32_t* start = m_cell_start.data();
+  uint32_t  slots = m_cell_mask + 1;
+
+  std::fill(m_cell_start.begin(), m_cell_start.end(), 0u);
+  for(uint32_t i = 0; i < cnt; ++i)
+  {
+    start[m_path_cell[i] + 1]++;
+  }
+  for(uint32_t c = 0; c < slots; ++c)
+  {
+    start[c + 1] += start[c];
+  }
+  for(uint32_t i = 0; i < cnt; ++i)
+  {
+    m_cell_paths[start[m_path_cell[i]]++] = i;
+  }
+  for(uint32_t c = slots; c > 0; --c)
+  {
+    start[c] = start[c - 1];
+  }
+  start[0] = 0;
+}
+
+void VkeFlightPaths::steer(float inDeltaTime, VkeThreadPool& inPool)
+{
+  if(!isSwarm() || m_t.empty())
+    return;
+
+  buildCells(inPool);
+
+  uint32_t cnt        = count();
+  uint32_t chunkCount = (cnt + SWARM_CHUNK_SIZE - 1) / SWARM_CHUNK_SIZE;
+  float    radius     = m_swarm_radius;
+  float    radiusSq   = radius * radius;
+  float    invCell    = 1.0f / radius;
+  float    dt         = std::min(inDeltaTime, SWARM_MAX_STEP);
+
+  /*
+	Positions come from the snapshot buildCells
+	took, and each path only writes its own
+	offset, so the chunks need no locking.
+	*/
+  inPool.run(chunkCount, [&](uint32_t inChunk) {
+    uint32_t first = inChunk * SWARM_CHUNK_SIZE;
+    uint32_t last  = std::min(first + SWARM_CHUNK_SIZE, cnt);
+
+    for(uint32_t i = first; i < last; ++i)
+    {
+      float   px = m_pos_x[i];
+      float   py = m_pos_y[i];
+      float   pz = m_pos_z[i];
+      int32_t cx = int32_t(floorf(px * invCell));
+      int32_t cy = int32_t(floorf(py * invCell));
+      int32_t cz = int32_t(floorf(pz * invCell));
+
+      float    sx           = 0.0f;
+      float    sy           = 0.0f;
+      float    sz           = 0.0f;
+      uint32_t found        = 0;
+      uint32_t visited[27]  = {};
+      uint32_t visitedCount = 0;
+
+      for(int32_t dz = -1; dz <= 1 && found < SWARM_NEIGHBOURS; ++dz)
+      {
+        for(int32_t dy = -1; dy <= 1 && found < SWARM_NEIGHBOURS; ++dy)
+        {
+          for(int32_t dx = -1; dx <= 1 && found < SWARM_NEIGHBOURS; ++dx)
+          {
+            uint32_t slot = swarmCellHash(cx + dx, cy + dy, cz + dz, m_cell_mask);
+
+            /*
+						Neighbouring cells can hash to the same
+						slot. Walk each slot once.
+						*/
+            bool seen = false;
+            for(uint32_t v = 0; v < visitedCount && !seen; ++v)
+            {
+              seen = visited[v] == slot;
+            }
+            if(seen)
+              continue;
+            visited[visitedCount++] = slot;
+
+            for(uint32_t k = m_cell_start[slot]; k < m_cell_start[slot + 1] && found < SWARM_NEIGHBOURS; ++k)
+            {
+              uint32_t j      = m_cell_paths[k];
+              float    ox     = px - m_pos_x[j];
+              float    oy     = py - m_pos_y[j];
+              float    oz     = pz - m_pos_z[j];
+              float    distSq = ox * ox + oy * oy + oz * oz;
+              if(j == i || distSq >= radiusSq || distSq <= 0.0f)
+                continue;
+
+              /*
+							Unit push away from the neighbour,
+							fading to nothing at the radius.
+							*/
+              float dist = sqrtf(distSq);
+              float w    = (radius - dist) / (radius * dist);
+              sx += ox * w;
+              sy += oy * w;
+              sz += oz * w;
+              found++;
+            }
+          }
+        }
+      }
+
+      float gain = SWARM_SEPARATION * radius;
+      float ax   = sx * gain - m_offset_x[i] * SWARM_SPRING - m_drift_x[i] * SWARM_DAMPING;
+      float ay   = sy * gain - m_offset_y[i] * SWARM_SPRING - m_drift_y[i] * SWARM_DAMPING;
+      float az   = sz * gain - m_offset_z[i] * SWARM_SPRING - m_drift_z[i] * SWARM_DAMPING;
+
+      m_drift_x[i] += ax * dt;
+      m_drift_y[i] += ay * dt;
+      m_drift_z[i] += az * dt;
+      m_offset_x[i] += m_drift_x[i] * dt;
+      m_offset_y[i] += m_drift_y[i] * dt;
+      m_offset_z[i] += m_drift_z[i] * dt;
+    }
+  });
+}
+
+/*
+	The original per instance path, kept as
+	the reference for the benchmark.
+*/
+struct FlightPath
+{
+  glm::vec2 m_start_position;
+  glm::vec2 m_range;
+  float     m_t;
+  float     m_velocity;
+  float     m_altitude;
+
+  FlightPath(const glm::vec2& initialPosition, const glm::vec2& endPosition, float startT, float inAltitude, float inVelocity)
+      : m_start_position(initialPosition)
+      , m_range(endPosition - initialPosition)
+      , m_t(startT)
+      , m_velocity(inVelocity)
+      , m_altitude(inAltitude)
+  {
+  }
+
+  void update(glm::mat4* inMat, float deltaTime)
+  {
+    m_t = fmodf(m_t + m_velocity * deltaTime, 1.f);
+
+    glm::vec2 position = (m_range * m_t) + m_start_position;
+
+    float yRot = atan2(m_range.x, m_range.y);
+
+    glm::mat4 translation(1);
+    translation = glm::translate(translation, glm::vec3(position.x, m_altitude, position.y));
+
+    glm::mat4 rotation(1);
+    rotation = glm::rotate(rotation, yRot, glm::vec3(0.0, 1.0, 0.0));
+    rotation = glm::rotate(rotation, glm::radians(-90.f), glm::vec3(1.0, 0.0, 0.0));
+    *inMat   = translation * rotation;
+  }
+};
+
+void VkeFlightPaths::benchmark()
+{
+  typedef std::chrono::high_resolution_clock Clock;
+
+  const uint32_t counts[] = {128, 10000, 1000000};
+  const float    dt       = 1.0f / 60.0f;
+
+  for(uint32_t count : counts)
+  {
+    uint32_t frames = count >= 1000000 ? 20 : 200;
+
+    std::vector<std::unique_ptr<FlightPath>> reference(count);
+    VkeFlightPaths                           paths;
+    paths.resize(count);
+
+    VkeRandom random(1);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+      glm::vec2 initPos(random.signedUniform() * 100.0f, -200.f + (random.signedUniform() * 20.f));
+      glm::vec2 endPos(random.signedUniform() * 100.0f, 200.f + (random.signedUniform() * 20.f));
+      float     startT   = random.uniform();
+      float     altitude = random.signedUniform() * 4.f + 10.f;
+      reference[i]       = std::make_unique<FlightPath>(initPos, endPos, startT, altitude, 0.06f);
+      paths.setPath(i, initPos, endPos, startT, altitude);
+    }
+
+    std::vector<glm::mat4> aos(count);
+    std::vector<glm::mat4> soa(count);
+
+    Clock::time_point start = Clock::now();
+    for(uint32_t f = 0; f < frames; ++f)
+    {
+      for(uint32_t i = 0; i < count; ++i)
+      {
+        reference[i]->update(&aos[i], dt);
+      }
+    }
+    double aosMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+
+    start = Clock::now();
+    for(uint32_t f = 0; f < frames; ++f)
+    {
+      paths.update(dt, &soa[0][0][0]);
+    }
+    double soaMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+
+    float maxError = 0.0f;
+    for(uint32_t i = 0; i < count; ++i)
+    {
+      for(int c = 0; c < 4; ++c)
+      {
+        glm::vec4 d = glm::abs(aos[i][c] - soa[i][c]);
+        maxError    = glm::max(maxError, glm::max(glm::max(d.x, d.y), glm::max(d.z, d.w)));
+      }
+    }
+
+    std::vector<VkeInstanceRecord> compact(count);
+
+    start = Clock::now();
+    for(uint32_t f = 0; f < frames; ++f)
+    {
+      paths.updateCompact(dt, compact.data());
+    }
+    double compactMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+
+    LOGI("Flight paths %7u: per instance %8.3f ms, batched %8.3f ms, %5.2fx, compact %8.3f ms, max error %g\n", count,
+         aosMs, soaMs, soaMs > 0.0 ? aosMs / soaMs : 0.0, compactMs, maxError);
+  }
+}
+
+void VkeFlightPaths::swarmBenchmark()
+{
+  typedef std::chrono::high_resolution_clock Clock;
+
+  const uint32_t counts[] = {1000, 10000, 100000};
+  const float    dt       = 1.0f / 60.0f;
+  const float    radius   = 4.0f;
+  const uint32_t frames   = 50;
+
+  VkeThreadPool serial;
+  VkeThreadPool parallel;
+  parallel.start();
+
+  VkeThreadPool* pools[2] = {&serial, &parallel};
+
+  for(uint32_t count : counts)
+  {
+    /*
+		Grow the lanes with the count, so the density
+		and with it the work per path stay the same.
+		*/
+    float       spread = sqrtf(float(count) / float(counts[0]));
+    VkeScenario scenario;
+    scenario.instance_count = count;
+    scenario.lane_width *= spread;
+    scenario.path_length *= spread;
+    scenario.path_jitter *= spread;
+
+    double ms[2];
+    for(int p = 0; p < 2; ++p)
+    {
+      VkeFlightPaths paths;
+      VkeRandom      random(1);
+      scenario.generatePaths(paths, random);
+      paths.setSwarm(radius);
+
+      Clock::time_point start = Clock::now();
+      for(uint32_t f = 0; f < frames; ++f)
+      {
+        paths.steer(dt, *pools[p]);
+        paths.advance(dt);
+      }
+      ms[p] = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+    }
+
+    LOGI("Swarm %6u paths: 1 thread %8.3f ms, %6.1f ns/path, %2u threads %8.3f ms, %6.1f ns/path\n", count, ms[0],
+         ms[0] * 1e6 / count, parallel.getThreadCount(), ms[1], ms[1] * 1e6 / count);
+  }
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+class VkeThreadPool;
+
+/*
+	Compact instance transform, 24 bytes against
+	64 for a mat4: position, uniform scale and
+	the rotation as a snorm16 quaternion, x and y
+	in the first word, z and w in the second.
+	std_vertex.glsl rebuilds the matrix.
+*/
+struct VkeInstanceRecord
+{
+  float    position[3];
+  float    scale;
+  uint32_t rotation[2];
+};
+
+/*
+	One path as read by flight_compute.glsl.
+*/
+struct VkeFlightRecord
+{
+  glm::vec4 path;    //start.xy, range.xy
+  glm::vec4 motion;  //cos heading, sin heading, altitude, velocity
+  float     t;
+  float     scale;
+  uint32_t  rotation[2];
+};
+
+/*
+	Straight line flight paths for the chopper
+	instances, stored as one array per field.
+	Each path only ever flies along a fixed
+	heading, so its rotation is computed once
+	in setPath and update just advances t and
+	writes the translation.
+
+	In swarm mode every path also carries an
+	offset from its line. steer pushes the
+	offsets apart where paths crowd and springs
+	them back to the line otherwise.
+*/
+class VkeFlightPaths
+{
+public:
+  VkeFlightPaths();
+  ~VkeFlightPaths();
+
+  void     resize(uint32_t inCount);
+  uint32_t count() const { return uint32_t(m_t.size()); }
+
+  void setPath(uint32_t         inIndex,
+               const glm::vec2& inStart,
+               const glm::vec2& inEnd,
+               float            inStartT,
+               float            inAltitude,
+               float            inVelocity = 0.06f,
+               float            inScale    = 1.0f);
+
+  /*
+		Advances every path by inDeltaTime and writes
+		one column major mat4 per path to outMatrices,
+		inStride floats apart.
+	*/
+  void update(float inDeltaTime, float* outMatrices, size_t inStride = 16);
+
+  /*
+		As update, writing compact records instead.
+		Only the position changes from frame to frame.
+	*/
+  void updateCompact(float inDeltaTime, VkeInstanceRecord* outRecords);
+
+  glm::vec3 getPosition(uint32_t inIndex) const;
+  glm::mat4 getMatrix(uint32_t inIndex) const;
+
+  void getRecords(VkeFlightRecord* outRecords) const;
+
+  /*
+		Bounding spheres for paths [inFirst, inFirst +
+		inCount), centred on each position with inRadius
+		times the path scale. Written at the path index
+		into each array.
+	*/
+  void getSpheres(float inRadius, uint32_t inFirst, uint32_t inCount, float* outX, float* outY, float* outZ, float* outRadius) const;
+
+  /*
+		Turns swarm mode on with paths keeping
+		inRadius apart, or off for 0. Sizes all
+		the swarm state, so steer never allocates.
+	*/
+  void setSwarm(float inRadius);
+  bool isSwarm() const { return m_swarm_radius > 0.0f; }
+
+  /*
+		Bins the current positions into a uniform
+		spatial hash with cells inRadius wide, then
+		steers each path away from at most a fixed
+		number of neighbours within the radius.
+		Both passes are split over inPool. Call
+		before update.
+	*/
+  void steer(float inDeltaTime, VkeThreadPool& inPool);
+
+  /*
+		Times update and updateCompact against the
+		per instance FlightPath they replaced, at
+		128, 10k and 1M instances, and logs the
+		results.
+	*/
+  static void benchmark();
+
+  /*
+		Times steer at 1k, 10k and 100k paths at the
+		same density, on one thread and on all of
+		them, and logs the cost per path.
+	*/
+  static void swarmBenchmark();
+
+private:
+  std::vector<float> m_start_x;
+  std::vector<float> m_start_y;
+  std::vector<float> m_range_x;
+  std::vector<float> m_range_y;
+  std::vector<float> m_t;
+  std::vector<float> m_velocity;
+  std::vector<float> m_altitude;
+  std::vector<float> m_cos_heading;
+  std::vector<float> m_sin_heading;
+  std::vector<float> m_scale;
+
+  std::vector<uint32_t> m_rotation_xy;
+  std::vector<uint32_t> m_rotation_zw;
+
+  /*
+		Swarm offsets and their velocities, zero
+		unless swarm mode is on.
+	*/
+  std::vector<float> m_offset_x;
+  std::vector<float> m_offset_y;
+  std::vector<float> m_offset_z;
+  std::vector<float> m_drift_x;
+  std::vector<float> m_drift_y;
+  std::vector<float> m_drift_z;
+
+  /*
+		Spatial hash, rebuilt by steer. m_cell_start
+		holds where each cell's paths begin in
+		m_cell_paths, plus one end entry.
+	*/
+  float                 m_swarm_radius = 0.0f;
+  uint32_t              m_cell_mask    = 0;
+  std::vector<float>    m_pos_x;
+  std::vector<float>    m_pos_y;
+  std::vector<float>    m_pos_z;
+  std::vector<uint32_t> m_path_cell;
+  std::vector<uint32_t> m_cell_start;
+  std::vector<uint32_t> m_cell_paths;
+
+  void advance(float inDeltaTime);
+  void buildCells(VkeThreadPool& inPool);
+};
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#include "VkeFrameContext.h"
+#include "VkeCreateUtils.h"
+#include <chrono>
+
+VkeFrameContext::VkeFrameContext() {}
+
+VkeFrameContext::~VkeFrameContext() {}
+
+void VkeFrameContext::init(uint32_t inThreadCount)
+{
+  VkDevice device = getDefaultDevice();
+
+  /*
+	Created signalled, so a frame that has
+	never been submitted does not block.
+	*/
+  VkFenceCreateInfo fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+  fenceInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
+  VKA_CHECK_ERROR(vkCreateFence(device, &fenceInfo, NULL, &m_fence), "Could not create frame fence.\n");
+
+  VkSemaphoreCreateInfo semInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+  VKA_CHECK_ERROR(vkCreateSemaphore(device, &semInfo, NULL, &m_present_done), "Could not create present done semaphore.\n");
+  VKA_CHECK_ERROR(vkCreateSemaphore(device, &semInfo, NULL, &m_render_done), "Could not create render done semaphore.\n");
+
+  commandPoolCreate(&m_primary_pool, 0, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+  VkCommandBufferAllocateInfo cmdBufInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+  cmdBufInfo.commandBufferCount          = 1;
+  cmdBufInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  cmdBufInfo.commandPool                 = m_primary_pool;
+
+  VKA_CHECK_ERROR(vkAllocateCommandBuffers(device, &cmdBufInfo, &m_primary), "Could not allocate primary command buffer.\n");
+
+  m_thread_pools.resize(inThreadCount);
+  for(uint32_t i = 0; i < inThreadCount; ++i)
+  {
+    commandPoolCreate(&m_thread_pools[i], 0, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+  }
+}
+
+void VkeFrameContext::waitFence()
+{
+  VKA_CHECK_ERROR(vkWaitForFences(getDefaultDevice(), 1, &m_fence, VK_TRUE, ~0ULL), "Could not wait for frame fence.\n");
+}
+
+void VkeFrameContext::wait()
+{
+  typedef std::chrono::high_resolution_clock Clock;
+
+  Clock::time_point start = Clock::now();
+  waitFence();
+  m_wait_ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+VkCommandBuffer VkeFrameContext::begin()
+{
+  VKA_CHECK_ERROR(vkResetCommandPool(getDefaultDevice(), m_primary_pool, 0), "Could not reset primary command pool.\n");
+  return m_primary;
+}
+
+void VkeFrameContext::resetThreadPool(uint32_t inThread)
+{
+  waitFence();
+  VKA_CHECK_ERROR(vkResetCommandPool(getDefaultDevice(), m_thread_pools[inThread], 0), "Could not reset thread command pool.\n");
+}
+
+VkCommandBuffer VkeFrameContext::allocateSecondary(uint32_t inThread)
+{
+  VkCommandBufferAllocateInfo cmdBufInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+  cmdBufInfo.commandBufferCount          = 1;
+  cmdBufInfo.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+  cmdBufInfo.commandPool                 = m_thread_pools[inThread];
+
+  VkCommandBuffer outCmd = VK_NULL_HANDLE;
+  VKA_CHECK_ERROR(vkAllocateCommandBuffers(getDefaultDevice(), &cmdBufInfo, &outCmd),
+                  "Could not allocate secondary command buffer.\n");
+  return outCmd;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include "vkaUtils.h"
+#include <stdint.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/*
+	The renderer keeps a ring of 1 to
+	MAX_FRAMES_IN_FLIGHT frame contexts. More
+	frames let the CPU run further ahead of the
+	GPU at the cost of latency.
+*/
+#define MAX_FRAMES_IN_FLIGHT 4
+
+/*
+	Everything one frame in flight owns: its
+	fence and semaphores, command pools, resolve
+	target and framebuffer. Every pool is
+	transient and reset as a whole once the
+	frame's fence has signalled, never buffer by
+	buffer. The primary pool is reset each frame;
+	each recording thread has its own pool, reset
+	only when that thread records again.
+*/
+class VkeFrameContext
+{
+public:
+  VkeFrameContext();
+  ~VkeFrameContext();
+
+  void init(uint32_t inThreadCount);
+
+  /*
+		Waits for the frame's last submit, after
+		which the CPU may write anything the frame
+		owns. The wait is timed, it is how long the
+		CPU ran ahead of the GPU.
+	*/
+  void wait();
+
+  /*
+		Resets the primary pool and returns the
+		primary command buffer to record into.
+		Call wait() first.
+	*/
+  VkCommandBuffer begin();
+
+  /*
+		Waits for the frame's last submit and
+		resets inThread's pool. Safe to call from
+		that thread while others record.
+	*/
+  void resetThreadPool(uint32_t inThread);
+
+  VkCommandBuffer allocateSecondary(uint32_t inThread);
+
+  VkFence         getFence() const { return m_fence; }
+  VkCommandBuffer getPrimary() const { return m_primary; }
+  VkSemaphore     getPresentDone() const { return m_present_done; }
+  VkSemaphore     getRenderDone() const { return m_render_done; }
+  float           getWaitMs() const { return m_wait_ms; }
+
+  /*
+		Size dependent targets and the secondaries
+		recorded against them. The renderer creates
+		and releases these with the framebuffers.
+	*/
+  ColorImageView  m_resolve_attachment = {};
+  VkFramebuffer   m_framebuffer        = VK_NULL_HANDLE;
+  VkCommandBuffer m_terrain_command    = VK_NULL_HANDLE;
+  VkCommandBuffer m_impostor_command   = VK_NULL_HANDLE;
+
+private:
+  void waitFence();
+
+  VkFence                    m_fence        = VK_NULL_HANDLE;
+  VkSemaphore                m_present_done = VK_NULL_HANDLE;
+  VkSemaphore                m_render_done  = VK_NULL_HANDLE;
+  float                      m_wait_ms      = 0.0f;
+  VkCommandPool              m_primary_pool = VK_NULL_HANDLE;
+  VkCommandBuffer            m_primary      = VK_NULL_HANDLE;
+  std::vector<VkCommandPool> m_thread_pools;
+};
@@ -22,6 +22,7 @@
 #include <include_gl.h>
 
 #include "VkeCamera.h"
+#include "VkeCulling.h"
 #include "VkeGameRendererDynamic.h"
 #include "VkeIBO.h"
 #include "VkeMaterial.h"
@@ -29,11 +30,36 @@
 #include "VkeVBO.h"
 #include "VulkanAppContext.h"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <nvh/nvprint.hpp>
 #ifndef INIT_COMMAND_ID
 #define INIT_COMMAND_ID 1
 #endif
 
+/*
+	Impostor atlas of IMPOSTOR_GRID x IMPOSTOR_GRID
+	views. Each view is mipped down to 4 texels, so
+	a texel never mixes two views. The fade band is
+	a fraction of the impostor distance.
+*/
+#define IMPOSTOR_GRID 8
+#define IMPOSTOR_TILE_SIZE 128
+#define IMPOSTOR_LEVELS 6
+#define IMPOSTOR_FADE_BAND 0.2f
+
+/*
+	Upper bound on the scene secondaries, one
+	per thread in the pool.
+*/
+#define MAX_DRAW_CALLS 16
+
+/*
+	Slots in the bindless material texture array,
+	if the device allows that many.
+*/
+#define MAX_BINDLESS_TEXTURES 4096
+
 #ifndef GL_NV_draw_vulkan_image
 #define GL_NV_draw_vulkan_image 1
 //typedef GLVULKANPROCNV (GLAPIENTRY* PFNGLGETVKINSTANCEPROCADDRNVPROC) (const GLchar *name);
@@ -86,15 +112,34 @@ static void setDefaultViewportAndScissor(VkCommandBuffer cmd, uint32_t width, ui
   vkCmdSetScissor(cmd, 0, 1, &sc);
 }
 
-VkeDrawCall::VkeDrawCall(vkeGameRendererDynamic* inRenderer)
+/*
+	Inverse of the octahedral map used to lay out
+	the impostor views, matches vertexImpostor.glsl.
+*/
+static glm::vec3 octahedralDecode(const glm::vec2& inCoord)
+{
+  glm::vec3 n(inCoord.x, inCoord.y, 1.0f - fabsf(inCoord.x) - fabsf(inCoord.y));
+  if(n.z < 0.0f)
+  {
+    float x = (1.0f - fabsf(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+    float y = (1.0f - fabsf(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    n.x     = x;
+    n.y     = y;
+  }
+  return glm::normalize(n);
+}
+
+VkeDrawCall::VkeDrawCall(vkeGameRendererDynamic* inRenderer, uint32_t inThread)
     : m_renderer(inRenderer)
-    , m_buffer_ready(false)
+    , m_thread(inThread)
 {
-  m_draw_command[0] = VK_NULL_HANDLE;
-  m_draw_command[1] = VK_NULL_HANDLE;
+  for(uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+  {
+    m_draw_command[i] = VK_NULL_HANDLE;
+    m_buffer_ready[i] = false;
+  }
 
-  initCommandPool();
-  initDescriptorPool();
+  initCommandBuffers();
 }
 
 VkeDrawCall::~VkeDrawCall() {}
@@ -104,87 +149,73 @@ VkCommandBuffer VkeDrawCall::getDrawCommand(const uint32_t inFrameIndex)
   return m_draw_command[inFrameIndex];
 }
 
-void VkeDrawCall::initCommandPool()
+bool VkeDrawCall::RecordState::operator==(const RecordState& inOther) const
 {
-
-  VulkanDC*         dc     = VulkanDC::Get();
-  VulkanDC::Device* device = dc->getDefaultDevice();
-
-  VkCommandPoolCreateInfo cmdPoolInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
-  cmdPoolInfo.queueFamilyIndex        = 0;
-  cmdPoolInfo.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-  VKA_CHECK_ERROR(vkCreateCommandPool(device->getVKDevice(), &cmdPoolInfo, NULL, &m_command_pool), "Could not create command pool.\n");
-
-  VkCommandBufferAllocateInfo cmdBufInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
-  cmdBufInfo.commandBufferCount          = 2;
-  cmdBufInfo.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
-  cmdBufInfo.commandPool                 = m_command_pool;
-
-  VKA_CHECK_ERROR(vkAllocateCommandBuffers(device->getVKDevice(), &cmdBufInfo, m_draw_command),
-                  "Could not allocate secondary command buffers.\n");
+  return pipeline == inOther.pipeline && layout == inOther.layout && sets[0] == inOther.sets[0] && sets[1] == inOther.sets[1]
+         && sets[2] == inOther.sets[2] && offsets[0] == inOther.offsets[0] && offsets[1] == inOther.offsets[1]
+         && render_pass == inOther.render_pass && indirect == inOther.indirect && first == inOther.first && count == inOther.count
+         && width == inOther.width && height == inOther.height;
 }
 
-void VkeDrawCall::initDescriptorPool()
+void VkeDrawCall::invalidate()
 {
-  VulkanDC*         dc     = VulkanDC::Get();
-  VulkanDC::Device* device = dc->getDefaultDevice();
-
-  VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1};
-
-  VkDescriptorPoolCreateInfo poolInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-  poolInfo.maxSets                    = 1;
-  poolInfo.poolSizeCount              = 1;
-  poolInfo.pPoolSizes                 = &poolSize;
-  poolInfo.flags                      = 0;
-
-  VKA_CHECK_ERROR(vkCreateDescriptorPool(device->getVKDevice(), &poolInfo, NULL, &m_descriptor_pool),
-                  "Could not create descriptor pool.\n");
+  for(uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+  {
+    m_buffer_ready[i] = false;
+  }
 }
 
-void VkeDrawCall::initDescriptor()
+/*
+	One secondary per frame in flight, each from
+	this call's pool in that frame's context.
+*/
+void VkeDrawCall::initCommandBuffers()
 {
-
-  VulkanDC*            dc     = VulkanDC::Get();
-  VulkanDC::Device*    device = dc->getDefaultDevice();
-  VkWriteDescriptorSet writes[1];
-
-  vkResetDescriptorPool(device->getVKDevice(), m_descriptor_pool, 0);
-
-  VkDescriptorSetAllocateInfo descAlloc = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
-
-  descAlloc.descriptorPool     = m_descriptor_pool;
-  descAlloc.pSetLayouts        = (m_renderer->getTransformDescriptorLayout());
-  descAlloc.descriptorSetCount = 1;
-
-
-  VKA_CHECK_ERROR(vkAllocateDescriptorSets(device->getVKDevice(), &descAlloc, &m_transform_descriptor_set),
-                  "Could not allocate descriptor sets.\n");
-
-  descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, (m_renderer->getTransformsDescriptor()),
-                     VK_NULL_HANDLE, 0, m_transform_descriptor_set);  //transform
-  vkUpdateDescriptorSets(device->getVKDevice(), 1, writes, 0, NULL);
+  for(uint32_t i = 0; i < m_renderer->getFrameCount(); ++i)
+  {
+    m_draw_command[i] = m_renderer->getFrameContext(i).allocateSecondary(m_thread);
+  }
 }
 
-
-void VkeDrawCall::initDrawCommands(const uint32_t inCount,
+bool VkeDrawCall::initDrawCommands(const uint32_t inFirst,
+                                   const uint32_t inCount,
                                    const uint32_t inCommandIndex,
                                    VkRenderPass   parentRenderPass,
                                    uint32_t       viewportWidth,
                                    uint32_t       viewportHeight)
 {
+  VkeVBO* theVBO = VulkanAppContext::GetInstance()->getVBO();
+  VkeIBO* theIBO = VulkanAppContext::GetInstance()->getIBO();
+
+  RecordState state;
+  state.pipeline    = m_renderer->getPipeline();
+  state.layout      = m_renderer->getPipelineLayout();
+  state.sets[0]     = m_renderer->getSceneDescriptorSet();
+  state.sets[1]     = m_renderer->getTextureDescriptorSets()[0];
+  state.sets[2]     = m_renderer->getTransformDescriptorSet();
+  state.offsets[0]  = m_renderer->getFrameOffset(inCommandIndex);
+  state.offsets[1]  = m_renderer->getTransformsOffset(inCommandIndex);
+  state.render_pass = parentRenderPass;
+  state.indirect    = m_renderer->getSceneDrawBuffer();
+  state.first       = inFirst;
+  state.count       = inCount;
+  state.width       = viewportWidth;
+  state.height      = viewportHeight;
 
-  VkPipelineLayout layout              = m_renderer->getPipelineLayout();
-  VkPipeline       pipeline            = m_renderer->getPipeline();
-  VkDescriptorSet  sceneDescriptor     = m_renderer->getSceneDescriptorSet();
-  VkDescriptorSet* textureDescriptors  = m_renderer->getTextureDescriptorSets();
-  VkBuffer         sceneIndirectBuffer = m_renderer->getSceneIndirectBuffer();
-
-
-  VulkanAppContext* ctxt = VulkanAppContext::GetInstance();
+  /*
+	Recorded with SIMULTANEOUS_USE, so an up to
+	date buffer is executed again as it is.
+	*/
+  if(m_buffer_ready[inCommandIndex] && m_recorded[inCommandIndex] == state)
+    return false;
 
+  VkCommandBuffer cmd = m_draw_command[inCommandIndex];
 
-  vkResetCommandBuffer(m_draw_command[inCommandIndex], 0);
+  /*
+	The pool only holds this buffer, so resetting
+	it is a reset of the buffer.
+	*/
+  m_renderer->getFrameContext(inCommandIndex).resetThreadPool(m_thread);
 
   VkCommandBufferInheritanceInfo cmdInheritanceInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
   cmdInheritanceInfo.renderPass                     = parentRenderPass;
@@ -193,34 +224,26 @@ void VkeDrawCall::initDrawCommands(const uint32_t inCount,
   cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
   cmdBeginInfo.pInheritanceInfo = &cmdInheritanceInfo;
 
-  VKA_CHECK_ERROR(vkBeginCommandBuffer(m_draw_command[inCommandIndex], &cmdBeginInfo), "Could not begin command buffer.\n");
+  VKA_CHECK_ERROR(vkBeginCommandBuffer(cmd, &cmdBeginInfo), "Could not begin command buffer.\n");
 
   // TODO: Switch to using inherited viewport and scissor
-  setDefaultViewportAndScissor(m_draw_command[inCommandIndex], viewportWidth, viewportHeight);
-  vkCmdBindPipeline(m_draw_command[inCommandIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-  VkeVBO* theVBO = ctxt->getVBO();
-  VkeIBO* theIBO = ctxt->getIBO();
-
-  theVBO->bind(&m_draw_command[inCommandIndex]);
-  theIBO->bind(&m_draw_command[inCommandIndex]);
-
-  VkDescriptorSet sets[3] = {sceneDescriptor, textureDescriptors[0], m_transform_descriptor_set};
-  vkCmdBindDescriptorSets(m_draw_command[inCommandIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 3, sets, 0, NULL);
+  setDefaultViewportAndScissor(cmd, viewportWidth, viewportHeight);
 
-  vkCmdDrawIndexedIndirect(m_draw_command[inCommandIndex], sceneIndirectBuffer, 0, inCount, sizeof(VkDrawIndexedIndirectCommand));
-  vkCmdDraw(m_draw_command[inCommandIndex], 1, 1, 0, 0);
-  vkEndCommandBuffer(m_draw_command[inCommandIndex]);
+  theVBO->bind(&cmd);
+  theIBO->bind(&cmd);
 
   /*
-	Lock mutex to update generated call count.
+	The scene pipelines share a layout, so the
+	sets stay bound across the batches.
 	*/
-  //std::lock_guard<std::mutex> lk(m_renderer->getSecondaryCmdBufferMutex());
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state.layout, 0, 3, state.sets, 2, state.offsets);
 
-  /*
-	Increment the generated call count
-	*/
-  m_renderer->incrementDrawCallsGenerated();
+  m_pipeline_binds[inCommandIndex] = m_renderer->recordSceneBatches(cmd, inFirst, inCount);
+  vkEndCommandBuffer(cmd);
+
+  m_recorded[inCommandIndex]     = state;
+  m_buffer_ready[inCommandIndex] = true;
+  return true;
 }
 
 vkeGameRendererDynamic::vkeGameRendererDynamic()
@@ -251,6 +274,8 @@ void vkeGameRendererDynamic::initIndirectCommands()
   VkDeviceMemory sceneIndirectMemStaging;
 
   VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  if(m_gpu_cull)
+    usageFlags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
   bufferCreate(&m_scene_indirect_buffer, sz, (VkBufferUsageFlagBits)usageFlags);
   bufferAlloc(&m_scene_indirect_buffer, &m_scene_indirect_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -267,14 +292,24 @@ void vkeGameRendererDynamic::initIndirectCommands()
 
   for(size_t i = 0; i < cnt; ++i)
   {
-    VkeMesh* mesh             = m_node_data->getData(i)->getMesh();
-    commands[i].firstIndex    = mesh->getFirstIndex();
+    if(m_cached_commands)
+    {
+      commands[i] = m_cached_commands[i];
+    }
+    else
+    {
+      VkeMesh* mesh            = m_node_data->getData(i)->getMesh();
+      commands[i].firstIndex   = mesh->getFirstIndex();
+      commands[i].vertexOffset = mesh->getFirstVertex();
+      commands[i].indexCount   = mesh->getIndexCount();
+    }
     commands[i].firstInstance = uint32_t(i * m_instance_count);
-    commands[i].vertexOffset  = mesh->getFirstVertex();
-    commands[i].indexCount    = mesh->getIndexCount();
     commands[i].instanceCount = uint32_t(m_instance_count);
   }
 
+  m_indirect_commands.assign(commands, commands + cnt);
+  m_patched_instance_count = m_instance_count;
+
   vkUnmapMemory(device->getVKDevice(), sceneIndirectMemStaging);
 
   VkBufferCopy bufCpy;
@@ -312,15 +347,365 @@ void vkeGameRendererDynamic::initIndirectCommands()
 
   vkFreeCommandBuffers(device->getVKDevice(), queue->getCommandPool(), 1, &copyCmd);
   vkDestroyFence(device->getVKDevice(), theFence, NULL);
+
+  initDrawBatches();
+  initGPUCulling();
+  initTimestamps();
+}
+
+/*
+	Splits the sorted nodes into runs that share
+	a pass.
+*/
+void vkeGameRendererDynamic::initDrawBatches()
+{
+  VulkanAppContext* ctxt      = VulkanAppContext::GetInstance();
+  uint32_t          nodeCount = uint32_t(m_node_data->count());
+
+  m_draw_batches.clear();
+  for(uint32_t i = 0; i < nodeCount; ++i)
+  {
+    uint32_t pass = ctxt->getDrawPass(uint32_t(m_node_data->getData(i)->getMesh()->getMaterialID()));
+    if(m_draw_batches.empty() || m_draw_batches.back().pass != pass)
+    {
+      DrawBatch batch = {i, 0, pass};
+      m_draw_batches.push_back(batch);
+    }
+    m_draw_batches.back().count++;
+  }
+
+  LOGI("Scene draws in %u batches\n", uint32_t(m_draw_batches.size()));
+}
+
+/*
+	Creates the GPU culling buffers. The visible list
+	is bound for the CPU path too, where the vertex
+	shader never reads it, so it is kept tiny there.
+*/
+void vkeGameRendererDynamic::initGPUCulling()
+{
+  VulkanDC::Device* device    = VulkanDC::Get()->getDefaultDevice();
+  VkDeviceSize      nodeCount = m_node_data->count();
+
+  VkDeviceSize visibleSize = m_gpu_cull ? sizeof(uint32_t) * nodeCount * m_instance_count : sizeof(uint32_t);
+
+  bufferCreate(&m_cull_visible_buffer, visibleSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+  bufferAlloc(&m_cull_visible_buffer, &m_cull_visible_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  m_visible_descriptor.buffer = m_cull_visible_buffer;
+  m_visible_descriptor.offset = 0;
+  m_visible_descriptor.range  = visibleSize;
+
+  if(!m_gpu_cull)
+    return;
+
+  /*
+	Per node counts, then the instances that passed
+	the whole chopper test, the draw count and the
+	two occlusion counters. Only those are read
+	back; the draw count of each batch follows.
+	*/
+  VkDeviceSize countSize  = sizeof(uint32_t) * (nodeCount + 4);
+  VkDeviceSize batchCount = m_draw_batches.size();
+
+  bufferCreate(&m_cull_count_buffer, countSize + sizeof(uint32_t) * batchCount,
+               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                   | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  bufferAlloc(&m_cull_count_buffer, &m_cull_count_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  bufferCreate(&m_cull_draw_buffer, sizeof(VkDrawIndexedIndirectCommand) * nodeCount,
+               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+  bufferAlloc(&m_cull_draw_buffer, &m_cull_draw_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  /*
+	The end of each batch, for the pass that
+	packs the commands.
+	*/
+  uint32_t* batchEnds = NULL;
+  bufferCreate(&m_cull_batch_buffer, sizeof(uint32_t) * batchCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+  bufferAlloc(&m_cull_batch_buffer, &m_cull_batch_memory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  VKA_CHECK_ERROR(vkMapMemory(device->getVKDevice(), m_cull_batch_memory, 0, VK_WHOLE_SIZE, 0, (void**)&batchEnds),
+                  "Could not map cull batch memory.\n");
+  for(size_t i = 0; i < m_draw_batches.size(); ++i)
+  {
+    batchEnds[i] = m_draw_batches[i].first + m_draw_batches[i].count;
+  }
+  vkUnmapMemory(device->getVKDevice(), m_cull_batch_memory);
+
+  bufferCreate(&m_cull_readback, countSize * m_frame_count, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  bufferAlloc(&m_cull_readback, &m_cull_readback_memory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  VKA_CHECK_ERROR(vkMapMemory(device->getVKDevice(), m_cull_readback_memory, 0, VK_WHOLE_SIZE, 0, (void**)&m_cull_readback_ptr),
+                  "Could not map cull readback memory.\n");
+
+  for(uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+  {
+    m_cull_readback_ready[i] = false;
+  }
+
+  if(!m_occlusion_cull)
+    return;
+
+  /*
+	Instances set aside by the first phase, and the
+	two cameras the Hi-Z tests project with.
+	*/
+  bufferCreate(&m_occluded_buffer, sizeof(uint32_t) * m_instance_count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+  bufferAlloc(&m_occluded_buffer, &m_occluded_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  bufferCreate(&m_occlusion_params_buffer, sizeof(glm::mat4) * 2 + sizeof(glm::vec4),
+               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  bufferAlloc(&m_occlusion_params_buffer, &m_occlusion_params_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  samplerCreate(&m_hiz_sampler, VK_FILTER_NEAREST, VK_FILTER_NEAREST, VK_FALSE, VK_COMPARE_OP_NEVER,
+                VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_MIPMAP_MODE_NEAREST, 0.0f, 16.0f);
+
+  m_hiz_view_projection = glm::mat4(1.0f);
+}
+
+/*
+	Creates the timestamp queries, which only the
+	occlusion culling stats and the draw benchmark
+	read.
+*/
+void vkeGameRendererDynamic::initTimestamps()
+{
+  if(!m_occlusion_cull && !m_draw_benchmark)
+    return;
+
+  VulkanDC::Device*             device = VulkanDC::Get()->getDefaultDevice();
+  const VkPhysicalDeviceLimits& limits = device->getProperties().limits;
+  if(!limits.timestampComputeAndGraphics)
+  {
+    LOGI("Timestamps are not supported, GPU times will read 0.\n");
+    return;
+  }
+
+  m_timestamp_period = limits.timestampPeriod;
+
+  VkQueryPoolCreateInfo queryInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+  queryInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+  queryInfo.queryCount            = 4 * m_frame_count;
+  VKA_CHECK_ERROR(vkCreateQueryPool(device->getVKDevice(), &queryInfo, NULL, &m_timestamp_pool),
+                  "Could not create timestamp query pool.\n");
+
+  for(uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+  {
+    m_timestamps_ready[i] = false;
+  }
+}
+
+/*
+	Creates the depth pyramid for the current frame
+	size. The base is the largest power of two that
+	fits in the frame, so every level halves exactly
+	and a texel at level n covers 2^n base texels.
+*/
+void vkeGameRendererDynamic::initHiZ()
+{
+  VulkanDC::Device* device = VulkanDC::Get()->getDefaultDevice();
+
+  m_hiz_width  = 1;
+  m_hiz_height = 1;
+  while(m_hiz_width * 2 <= m_width)
+    m_hiz_width *= 2;
+  while(m_hiz_height * 2 <= m_height)
+    m_hiz_height *= 2;
+
+  m_hiz_levels = 1;
+  while((std::max(m_hiz_width, m_hiz_height) >> m_hiz_levels) > 0)
+    m_hiz_levels++;
+
+  imageCreateAndBind(&m_hiz_image, &m_hiz_memory, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TYPE_2D, m_hiz_width, m_hiz_height, 1, 1,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                     VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                     VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, m_hiz_levels);
+  imageViewCreate(&m_hiz_view, m_hiz_image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R32_SFLOAT);
+
+  /*
+	One storage view and descriptor set per level.
+	*/
+  VkDescriptorPoolSize typeCounts[] = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_hiz_levels + 1},
+                                       {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_hiz_levels * 2},
+                                       {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
+                                       {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1}};
+
+  VkDescriptorPoolCreateInfo poolInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+  poolInfo.poolSizeCount              = 4;
+  poolInfo.pPoolSizes                 = typeCounts;
+  poolInfo.maxSets                    = m_hiz_levels + 1;
+  VKA_CHECK_ERROR(vkCreateDescriptorPool(device->getVKDevice(), &poolInfo, NULL, &m_hiz_descriptor_pool),
+                  "Could not create Hi-Z descriptor pool.\n");
+
+  std::vector<VkDescriptorSetLayout> layouts(m_hiz_levels, m_hiz_descriptor_layout);
+  m_hiz_level_views.resize(m_hiz_levels);
+  m_hiz_level_sets.resize(m_hiz_levels);
+
+  VkDescriptorSetAllocateInfo descAlloc = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+  descAlloc.descriptorPool              = m_hiz_descriptor_pool;
+  descAlloc.descriptorSetCount          = m_hiz_levels;
+  descAlloc.pSetLayouts                 = layouts.data();
+  VKA_CHECK_ERROR(vkAllocateDescriptorSets(device->getVKDevice(), &descAlloc, m_hiz_level_sets.data()),
+                  "Could not allocate Hi-Z descriptor sets.\n");
+
+  descAlloc.descriptorSetCount = 1;
+  descAlloc.pSetLayouts        = &m_occlusion_descriptor_layout;
+  VKA_CHECK_ERROR(vkAllocateDescriptorSets(device->getVKDevice(), &descAlloc, &m_occlusion_descriptor_set),
+                  "Could not allocate occlusion descriptor set.\n");
+
+  for(uint32_t i = 0; i < m_hiz_levels; ++i)
+  {
+    VkImageViewCreateInfo viewInfo;
+    imageViewCreateInfo(&viewInfo, m_hiz_image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R32_SFLOAT);
+    viewInfo.subresourceRange.baseMipLevel = i;
+    viewInfo.subresourceRange.levelCount   = 1;
+    VKA_CHECK_ERROR(vkCreateImageView(device->getVKDevice(), &viewInfo, NULL, &m_hiz_level_views[i]),
+                    "Could not create Hi-Z level view.\n");
+  }
+
+  /*
+	Hi-Z bindings (compute)
+	Binding 0:		Depth attachment
+	Binding 1:		Source level
+	Binding 2:		Destination level
+	*/
+  VkDescriptorImageInfo depthInfo = {m_hiz_sampler, m_depth_attachment.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+
+  for(uint32_t i = 0; i < m_hiz_levels; ++i)
+  {
+    VkDescriptorImageInfo srcInfo = {VK_NULL_HANDLE, m_hiz_level_views[i > 0 ? i - 1 : 0], VK_IMAGE_LAYOUT_GENERAL};
+    VkDescriptorImageInfo dstInfo = {VK_NULL_HANDLE, m_hiz_level_views[i], VK_IMAGE_LAYOUT_GENERAL};
+
+    VkWriteDescriptorSet writes[3];
+    descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &depthInfo, 0,
+                       m_hiz_level_sets[i]);
+    descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_NULL_HANDLE, &srcInfo, 0, m_hiz_level_sets[i]);
+    descriptorSetWrite(&writes[2], 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_NULL_HANDLE, &dstInfo, 0, m_hiz_level_sets[i]);
+    vkUpdateDescriptorSets(device->getVKDevice(), 3, writes, 0, NULL);
+  }
+
+  /*
+	Occlusion bindings (compute, set 1 of the cull pass)
+	Binding 0:		Depth pyramid
+	Binding 1:		Cameras and pyramid size
+	Binding 2:		Occluded instances
+	*/
+  VkDescriptorImageInfo  hizInfo      = {m_hiz_sampler, m_hiz_view, VK_IMAGE_LAYOUT_GENERAL};
+  VkDescriptorBufferInfo paramsInfo   = {m_occlusion_params_buffer, 0, VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo occludedInfo = {m_occluded_buffer, 0, VK_WHOLE_SIZE};
+
+  VkWriteDescriptorSet writes[3];
+  descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &hizInfo, 0,
+                     m_occlusion_descriptor_set);
+  descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &paramsInfo, VK_NULL_HANDLE, 0, m_occlusion_descriptor_set);
+  descriptorSetWrite(&writes[2], 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &occludedInfo, VK_NULL_HANDLE, 0,
+                     m_occlusion_descriptor_set);
+  vkUpdateDescriptorSets(device->getVKDevice(), 3, writes, 0, NULL);
+}
+
+void vkeGameRendererDynamic::releaseHiZ()
+{
+  VkDevice device = VulkanDC::Get()->getDefaultDevice()->getVKDevice();
+
+  if(m_hiz_image == VK_NULL_HANDLE)
+    return;
+
+  vkDestroyDescriptorPool(device, m_hiz_descriptor_pool, NULL);
+  for(size_t i = 0; i < m_hiz_level_views.size(); ++i)
+  {
+    vkDestroyImageView(device, m_hiz_level_views[i], NULL);
+  }
+  vkDestroyImageView(device, m_hiz_view, NULL);
+  vkDestroyImage(device, m_hiz_image, NULL);
+  vkFreeMemory(device, m_hiz_memory, NULL);
+
+  m_hiz_level_views.clear();
+  m_hiz_level_sets.clear();
+  m_hiz_descriptor_pool      = VK_NULL_HANDLE;
+  m_occlusion_descriptor_set = VK_NULL_HANDLE;
+  m_hiz_view                 = VK_NULL_HANDLE;
+  m_hiz_image                = VK_NULL_HANDLE;
+  m_hiz_memory               = VK_NULL_HANDLE;
+}
+
+/*
+	Creates the impostor atlases and the target they
+	are baked through. None of it depends on the frame
+	size, so it lives as long as the renderer.
+*/
+void vkeGameRendererDynamic::initImpostors()
+{
+  VulkanDC::Device* device = VulkanDC::Get()->getDefaultDevice();
+
+  const uint32_t    atlasSize  = IMPOSTOR_GRID * IMPOSTOR_TILE_SIZE;
+  const VkFormat    colorFmt   = VK_FORMAT_R8G8B8A8_UNORM;
+  const VkFormat    depthFmt   = VK_FORMAT_D24_UNORM_S8_UINT;
+  VkImageUsageFlags atlasUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+                                 | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+  imageCreateAndBind(&m_impostor_albedo, &m_impostor_albedo_memory, colorFmt, VK_IMAGE_TYPE_2D, atlasSize, atlasSize, 1, 1,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, atlasUsage, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT,
+                     IMPOSTOR_LEVELS);
+  imageCreateAndBind(&m_impostor_normal, &m_impostor_normal_memory, colorFmt, VK_IMAGE_TYPE_2D, atlasSize, atlasSize, 1, 1,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, atlasUsage, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT,
+                     IMPOSTOR_LEVELS);
+  imageCreateAndBind(&m_impostor_depth, &m_impostor_depth_memory, depthFmt, VK_IMAGE_TYPE_2D, atlasSize, atlasSize, 1, 1,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                     VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT);
+
+  imageViewCreate(&m_impostor_albedo_view, m_impostor_albedo, VK_IMAGE_VIEW_TYPE_2D, colorFmt);
+  imageViewCreate(&m_impostor_normal_view, m_impostor_normal, VK_IMAGE_VIEW_TYPE_2D, colorFmt);
+
+  /*
+	The bake renders to the base level only.
+	*/
+  VkImage targets[2] = {m_impostor_albedo, m_impostor_normal};
+  for(uint32_t i = 0; i < 2; ++i)
+  {
+    VkImageViewCreateInfo viewInfo;
+    imageViewCreateInfo(&viewInfo, targets[i], VK_IMAGE_VIEW_TYPE_2D, colorFmt);
+    viewInfo.subresourceRange.levelCount = 1;
+    VKA_CHECK_ERROR(vkCreateImageView(device->getVKDevice(), &viewInfo, NULL, &m_impostor_target_views[i]),
+                    "Could not create impostor target view.\n");
+  }
+  imageViewCreate(&m_impostor_target_views[2], m_impostor_depth, VK_IMAGE_VIEW_TYPE_2D, depthFmt, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+  VkFramebufferCreateInfo fbInfo = {VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+  fbInfo.renderPass              = m_impostor_render_pass;
+  fbInfo.attachmentCount         = 3;
+  fbInfo.pAttachments            = m_impostor_target_views;
+  fbInfo.width                   = atlasSize;
+  fbInfo.height                  = atlasSize;
+  fbInfo.layers                  = 1;
+  VKA_CHECK_ERROR(vkCreateFramebuffer(device->getVKDevice(), &fbInfo, NULL, &m_impostor_framebuffer),
+                  "Could not create impostor framebuffer.\n");
+
+  samplerCreate(&m_impostor_sampler, VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_FALSE, VK_COMPARE_OP_NEVER,
+                VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_MIPMAP_MODE_LINEAR, 0.0f, float(IMPOSTOR_LEVELS));
+
+  /*
+	Written by recordInstanceCounts each frame.
+	*/
+  bufferCreate(&m_impostor_indirect_buffer, sizeof(VkDrawIndirectCommand),
+               VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  bufferAlloc(&m_impostor_indirect_buffer, &m_impostor_indirect_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 }
 
 void vkeGameRendererDynamic::initDescriptorPool()
 {
   VkeRenderer::initDescriptorPool();
 
-  VkDescriptorPoolSize typeCounts[] = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
-                                       {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2},
-                                       {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1}};
+  if(m_descriptor_pool != VK_NULL_HANDLE)
+    return;
+
+  uint32_t samplerCount = m_bindless_textures ? 3 : 3 + m_texture_slots;
+
+  VkDescriptorPoolSize typeCounts[] = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+                                       {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4},
+                                       {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, samplerCount},
+                                       {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 11},
+                                       {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 2}};
 
   VulkanDC* dc = VulkanDC::Get();
   if(!dc)
@@ -329,17 +714,28 @@ void vkeGameRendererDynamic::initDescriptorPool()
   VulkanDC::Device* device = dc->getDefaultDevice();
 
   VkDescriptorPoolCreateInfo descriptorPoolInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-  descriptorPoolInfo.poolSizeCount              = 3;
+  descriptorPoolInfo.poolSizeCount              = 5;
   descriptorPoolInfo.pPoolSizes                 = typeCounts;
-  descriptorPoolInfo.maxSets                    = (m_descriptor_pool_size * 2) + 3;
+  descriptorPoolInfo.maxSets                    = (m_descriptor_pool_size * 2) + 5;
   VKA_CHECK_ERROR(vkCreateDescriptorPool(device->getVKDevice(), &descriptorPoolInfo, NULL, &m_descriptor_pool),
                   "Could not create descriptor pool.\n");
-}
 
+  if(!m_bindless_textures)
+    return;
 
-float quickRandomUVD()
-{
-  return ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+  /*
+	Update after bind sets need a pool created
+	for them.
+	*/
+  VkDescriptorPoolSize textureCount = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_texture_slots};
+
+  VkDescriptorPoolCreateInfo texturePoolInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+  texturePoolInfo.flags                      = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+  texturePoolInfo.poolSizeCount              = 1;
+  texturePoolInfo.pPoolSizes                 = &textureCount;
+  texturePoolInfo.maxSets                    = 1;
+  VKA_CHECK_ERROR(vkCreateDescriptorPool(device->getVKDevice(), &texturePoolInfo, NULL, &m_texture_descriptor_pool),
+                  "Could not create texture descriptor pool.\n");
 }
 
 
@@ -348,46 +744,93 @@ void vkeGameRendererDynamic::initRenderer()
   VulkanDC*         dc     = VulkanDC::Get();
   VulkanDC::Device* device = dc->getDevice();
 
-  m_instance_count = 128;
+  const VulkanAppContext::Settings& settings = VulkanAppContext::GetInstance()->getSettings();
+
+  m_instance_format = settings.instance_format == 1 ? INSTANCE_FORMAT_COMPACT : INSTANCE_FORMAT_MATRIX;
+  m_instance_stride = m_instance_format == INSTANCE_FORMAT_COMPACT ? sizeof(VkeInstanceRecord) : sizeof(glm::mat4);
+
+  m_gpu_flight      = settings.gpu_flight != 0;
+  m_validate_flight = m_gpu_flight && settings.validate_flight != 0;
+  m_cull_instances  = settings.cull_instances != 0;
+  m_gpu_cull        = settings.gpu_cull != 0;
+  m_draw_benchmark  = settings.draw_benchmark != 0;
+
+  m_bindless_textures = device->hasDescriptorIndexing();
+  if(m_bindless_textures)
+    m_texture_slots = std::min(uint32_t(MAX_BINDLESS_TEXTURES), device->getMaxUpdateAfterBindTextures());
+
+  if(m_gpu_cull && !device->getDrawIndexedIndirectCount())
+  {
+    LOGI("VK_KHR_draw_indirect_count is not supported, culling on the CPU.\n");
+    m_gpu_cull = false;
+  }
+
+  m_occlusion_cull = m_gpu_cull && settings.occlusion_cull != 0;
+  if(settings.occlusion_cull != 0 && !m_occlusion_cull)
+  {
+    LOGI("Occlusion culling needs GPU culling, disabled.\n");
+  }
+
+  /*
+	The impostors are partitioned by the CPU cull.
+	*/
+  m_impostors = settings.impostor_distance > 0.0f;
+  if(m_impostors && (m_gpu_flight || m_gpu_cull || !m_cull_instances))
+  {
+    LOGI("Impostors need the CPU flight paths and culling, disabled.\n");
+    m_impostors = false;
+  }
+  m_impostor_near = settings.impostor_distance;
+  m_impostor_far  = settings.impostor_distance * (1.0f + IMPOSTOR_FADE_BAND);
+
+  /*
+	Each instance is one record in the transforms
+	storage buffer, so the count is bounded by
+	the largest range a storage descriptor can
+	cover. With impostors, instances in the fade
+	band are in there twice.
+	*/
+  uint32_t maxInstances = device->getProperties().limits.maxStorageBufferRange / m_instance_stride;
+  if(m_impostors)
+    maxInstances /= 2;
+
+  m_instance_count = std::max(settings.scenario.instance_count, 1u);
+  if(m_instance_count > maxInstances)
+  {
+    LOGE("%u instances exceed the storage buffer range, using %u.\n", m_instance_count, maxInstances);
+    m_instance_count = maxInstances;
+  }
+
+  m_draw_instance_count    = m_instance_count;
+  m_patched_instance_count = m_instance_count;
+
+  m_thread_pool.start(uint32_t(std::max(settings.threads, 0)));
+
+  m_frame_count = uint32_t(glm::clamp(settings.frames_in_flight, 1, MAX_FRAMES_IN_FLIGHT));
+  if(int(m_frame_count) != settings.frames_in_flight)
+    LOGI("%d frames in flight is out of range, using %u.\n", settings.frames_in_flight, m_frame_count);
 
   //glWaitVkSemaphoreNV = (PFNGLWAITVKSEMAPHORENVPROC)NVPSystem::GetProcAddressGL("glWaitVkSemaphoreNV");
   //glSignalVkSemaphoreNV = (PFNGLSIGNALVKSEMAPHORENVPROC)NVPSystem::GetProcAddressGL("glSignalVkSemaphoreNV");
   //glSignalVkFenceNV = (PFNGLSIGNALVKFENCENVPROC)NVPSystem::GetProcAddressGL("glSignalVkFenceNV");
   //	glDrawVkImageNV = (PFNGLDRAWVKIMAGENVPROC)NVPSystem::GetProcAddressGL("glDrawVkImageNV");
 
-  VkSemaphoreCreateInfo semInfo   = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
-  VkFenceCreateInfo     fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
-
-  VKA_CHECK_ERROR(vkCreateSemaphore(device->getVKDevice(), &semInfo, NULL, &m_present_done[0]),
-                  "Could not create present done semaphore.\n");
-  VKA_CHECK_ERROR(vkCreateSemaphore(device->getVKDevice(), &semInfo, NULL, &m_render_done[0]),
-                  "Could not create render done semaphore.\n");
-  VKA_CHECK_ERROR(vkCreateSemaphore(device->getVKDevice(), &semInfo, NULL, &m_present_done[1]),
-                  "Could not create present done semaphore.\n");
-  VKA_CHECK_ERROR(vkCreateSemaphore(device->getVKDevice(), &semInfo, NULL, &m_render_done[1]),
-                  "Could not create render done semaphore.\n");
-
-  VKA_CHECK_ERROR(vkCreateFence(device->getVKDevice(), &fenceInfo, NULL, &m_update_fence[0]), "Could not create update fence.\n");
-  fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-  VKA_CHECK_ERROR(vkCreateFence(device->getVKDevice(), &fenceInfo, NULL, &m_update_fence[1]), "Could not create update fence.\n");
-
-  m_terrain_command[0] = VK_NULL_HANDLE;
-  m_terrain_command[1] = VK_NULL_HANDLE;
-  m_framebuffers[0]    = VK_NULL_HANDLE;
-  m_framebuffers[1]    = VK_NULL_HANDLE;
-  m_update_commands[0] = VK_NULL_HANDLE;
-  m_update_commands[1] = VK_NULL_HANDLE;
-
   m_is_first_frame = true;
 
 
+  /*
+	Everything random in the scene comes from the
+	scenario seed, so runs are repeatable.
+	*/
+  VkeRandom random(settings.scenario.seed);
+
   glm::vec4 table[128][128];
 
   for(int v = 0; v < 128; ++v)
   {
     for(int u = 0; u < 128; ++u)
     {
-      glm::vec2 vctr(quickRandomUVD(), quickRandomUVD());
+      glm::vec2 vctr(random.signedUniform(), random.signedUniform());
       vctr = glm::normalize(vctr);
       // VK_FORMAT_R32G32B32_SFLOAT isn't so widely supported, so we use
       // VK_FORMAT_R32G32B32A32_SFLOAT instead.
@@ -402,14 +845,20 @@ void vkeGameRendererDynamic::initRenderer()
   m_textures.newTexture(0)->setFormat(VK_FORMAT_R32G32B32A32_SFLOAT);
   m_textures.getTexture(0)->loadTextureFloatData((float*)&(table[0][0].x), 128, 128, 4);
 
-  m_flight_paths.resize(m_instance_count);
+  VkeScenario scenario    = settings.scenario;
+  scenario.instance_count = m_instance_count;
+  scenario.generatePaths(m_flight_paths, random);
 
-  for(uint32_t i = 0; i < m_instance_count; ++i)
+  /*
+	The compute flight paths have no neighbours
+	to steer around.
+	*/
+  if(scenario.swarm_radius > 0.0f)
   {
-    glm::vec2 initPos(quickRandomUVD() * 100.0f, -200.f + (quickRandomUVD() * 20.f));
-    glm::vec2 endPos(quickRandomUVD() * 100.0f, 200.f + (quickRandomUVD() * 20.f));
-    m_flight_paths[i] =
-        std::make_unique<FlightPath>(initPos, endPos, quickRandomUVD() * 0.5f + 0.5f, quickRandomUVD() * 4.f + 10.f);
+    if(m_gpu_flight)
+      LOGI("The swarm needs the CPU flight paths, disabled.\n");
+    else
+      m_flight_paths.setSwarm(scenario.swarm_radius);
   }
 
   /*
@@ -421,28 +870,9 @@ void vkeGameRendererDynamic::initRenderer()
 
 
   /*
-	Create primary command pool for the
+	Create the pool for one off setup commands.
 	*/
-  VkCommandPoolCreateInfo cmdPoolInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
-  cmdPoolInfo.queueFamilyIndex        = 0;
-  cmdPoolInfo.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-  VKA_CHECK_ERROR(vkCreateCommandPool(device->getVKDevice(), &cmdPoolInfo, NULL, &m_primary_buffer_cmd_pool),
-                  "Could not create primary command pool.\n");
-
-  m_primary_commands[0] = VK_NULL_HANDLE;
-  m_primary_commands[1] = VK_NULL_HANDLE;
-
-  VkCommandBufferAllocateInfo cmdBufInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
-  cmdBufInfo.commandBufferCount          = 2;
-  cmdBufInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  cmdBufInfo.commandPool                 = m_primary_buffer_cmd_pool;
-
-
-  VKA_CHECK_ERROR(vkAllocateCommandBuffers(device->getVKDevice(), &cmdBufInfo, m_primary_commands),
-                  "Could not allocate primary command buffers.\n");
-  VKA_CHECK_ERROR(vkAllocateCommandBuffers(device->getVKDevice(), &cmdBufInfo, m_update_commands),
-                  "Could not allocate primary command buffers.\n");
+  commandPoolCreate(&m_primary_buffer_cmd_pool, 0, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
 
   m_current_buffer_index = 0;
 }
@@ -454,49 +884,182 @@ void vkeGameRendererDynamic::setNodeData(VkeNodeData::List* inData)
   if(m_node_data != NULL)
   {
 
-    size_t cnt            = m_node_data->count();
-    size_t transformsSize = 64 * m_instance_count;
+    VulkanDC*         dc     = VulkanDC::Get();
+    VulkanDC::Device* device = dc->getDefaultDevice();
+
+    size_t cnt = m_node_data->count();
+
+    /*
+		Draw i covers instances [i * m_instance_count,
+		(i + 1) * m_instance_count), which has to fit
+		in a 32 bit gl_InstanceIndex.
+		*/
+    if(cnt > 0 && uint64_t(cnt) * m_instance_count > uint64_t(INT32_MAX))
+    {
+      uint32_t maxInstances = uint32_t(uint64_t(INT32_MAX) / cnt);
+      LOGE("%u instances of %zu nodes overflow the instance index, using %u.\n", m_instance_count, cnt, maxInstances);
+      m_instance_count = maxInstances;
+      m_flight_paths.resize(m_instance_count);
+    }
+
+    if(m_gpu_cull && uint64_t(cnt) * m_instance_count * sizeof(uint32_t) > device->getProperties().limits.maxStorageBufferRange)
+    {
+      LOGE("Visible lists for %u instances of %zu nodes exceed the storage buffer range, culling on the CPU.\n",
+           m_instance_count, cnt);
+      m_gpu_cull       = false;
+      m_occlusion_cull = false;
+    }
+
+    size_t transformsSize = size_t(m_instance_stride) * m_instance_count * (m_impostors ? 2 : 1);
+    size_t recordsSize    = sizeof(VkeNodeRecord) * cnt;
 
-    size_t sz = sizeof(VkeNodeUniform) * cnt;
-    sz += (transformsSize);
+    /*
+		With GPU flight the compute pass writes the
+		transforms after the node records in the same
+		allocation, so round them up to the SSBO
+		offset alignment. Otherwise the buffer only
+		holds the node records.
+		*/
+    VkDeviceSize align = device->getProperties().limits.minStorageBufferOffsetAlignment;
+    size_t       sz    = recordsSize;
+
+    if(m_gpu_flight)
+    {
+      m_transforms_offset = ((recordsSize + align - 1) / align) * align;
+      sz                  = size_t(m_transforms_offset) + transformsSize;
+    }
 
     m_uniforms_local = (float*)malloc(sz);
+    memset(m_uniforms_local, 0, sz);
+    m_uniforms_size = sz;
 
-    bufferCreate(&m_uniforms_buffer, sz, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    bufferCreate(&m_uniforms_buffer, sz,
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
     bufferAlloc(&m_uniforms_buffer, &m_uniforms_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
+    bufferCreate(&m_uniforms_buffer_staging, sz * m_frame_count, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    bufferAlloc(&m_uniforms_buffer_staging, &m_uniforms_staging,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VKA_CHECK_ERROR(vkMapMemory(device->getVKDevice(), m_uniforms_staging, 0, VK_WHOLE_SIZE, 0, (void**)&m_uniforms_staging_ptr),
+                    "Could not map uniform staging memory.\n");
+
+    m_node_data->markAllDirty();
+    m_force_full_upload = true;
+
 
     m_uniforms_descriptor.buffer = m_uniforms_buffer;
     m_uniforms_descriptor.offset = 0;
-    m_uniforms_descriptor.range  = sizeof(VkeNodeUniform) * cnt;
+    m_uniforms_descriptor.range  = recordsSize;
+
+    /*
+		Per frame data lives in a persistently mapped
+		ring, one region per frame in flight: the
+		camera, then the transforms when the CPU
+		writes them. Regions are aligned so either
+		binding can be selected by a dynamic offset.
+		*/
+    VkDeviceSize ringAlign  = std::max(align, device->getProperties().limits.minUniformBufferOffsetAlignment);
+    VkDeviceSize cameraSize = ((sizeof(VkeCameraUniform) + ringAlign - 1) / ringAlign) * ringAlign;
+    VkDeviceSize regionSize = cameraSize + (m_gpu_flight ? 0 : transformsSize);
+    m_frame_ring_stride     = ((regionSize + ringAlign - 1) / ringAlign) * ringAlign;
+
+    bufferCreate(&m_frame_ring, size_t(m_frame_ring_stride) * m_frame_count,
+                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    bufferAlloc(&m_frame_ring, &m_frame_ring_memory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VKA_CHECK_ERROR(vkMapMemory(device->getVKDevice(), m_frame_ring_memory, 0, VK_WHOLE_SIZE, 0, (void**)&m_frame_ring_ptr),
+                    "Could not map frame ring memory.\n");
+    memset(m_frame_ring_ptr, 0, size_t(m_frame_ring_stride) * m_frame_count);
+
+    m_camera_descriptor.buffer = m_frame_ring;
+    m_camera_descriptor.offset = 0;
+    m_camera_descriptor.range  = sizeof(VkeCameraUniform);
+
+    if(m_gpu_flight)
+    {
+      m_transforms_descriptor.buffer = m_uniforms_buffer;
+      m_transforms_descriptor.offset = m_transforms_offset;
+      m_transforms_descriptor.range  = transformsSize;
+    }
+    else
+    {
+      m_flight_transforms.resize(size_t(m_instance_stride) * m_instance_count);
+
+      m_transforms_descriptor.buffer = m_frame_ring;
+      m_transforms_descriptor.offset = cameraSize;
+      m_transforms_descriptor.range  = transformsSize;
+    }
 
-    m_transforms_descriptor.buffer = m_uniforms_buffer;
-    m_transforms_descriptor.offset = sizeof(VkeNodeUniform) * cnt;
-    m_transforms_descriptor.range  = transformsSize;
+    initFlightSimulation();
   }
 }
 
-void vkeGameRendererDynamic::setMaterialData(VkeMaterial::List* inData)
+/*
+	Uploads the flight paths for the compute pass
+	and, when validating, sets up the readback of
+	one frame's transforms per command buffer.
+*/
+void vkeGameRendererDynamic::initFlightSimulation()
 {
-  m_materials = inData;
+  if(!m_gpu_flight)
+    return;
 
-  if(m_materials != NULL)
-  {
+  VulkanDC*         dc     = VulkanDC::Get();
+  VulkanDC::Device* device = dc->getDefaultDevice();
 
-    size_t cnt = m_materials->count();
-    size_t sz  = sizeof(VkeMaterialUniform) * cnt;
+  size_t sz = sizeof(VkeFlightRecord) * m_instance_count;
 
-    VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+  bufferCreate(&m_flight_buffer, sz, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  bufferAlloc(&m_flight_buffer, &m_flight_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    bufferCreate(&m_material_buffer_staging, sz, (VkBufferUsageFlagBits)usageFlags);
-    bufferAlloc(&m_material_buffer_staging, &m_material_staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+  bufferCreate(&m_flight_buffer_staging, sz, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+  bufferAlloc(&m_flight_buffer_staging, &m_flight_staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    VkeMaterialUniform* uniforms = NULL;
+  VkeFlightRecord* records = NULL;
+  VKA_CHECK_ERROR(vkMapMemory(device->getVKDevice(), m_flight_staging, 0, sz, 0, (void**)&records),
+                  "Could not map flight staging memory.\n");
+  m_flight_paths.getRecords(records);
+  vkUnmapMemory(device->getVKDevice(), m_flight_staging);
 
-    VKA_CHECK_ERROR(vkMapMemory(getDefaultDevice(), m_material_staging, 0, sz, 0, (void**)&uniforms), "Could not map buffer memory.\n");
+  m_flight_upload_pending = true;
 
-    for(size_t i = 0; i < cnt; ++i)
-    {
+  if(!m_validate_flight)
+    return;
+
+  size_t transformsSize = size_t(m_instance_stride) * m_instance_count;
+
+  bufferCreate(&m_flight_readback, transformsSize * m_frame_count, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  bufferAlloc(&m_flight_readback, &m_flight_readback_memory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  VKA_CHECK_ERROR(vkMapMemory(device->getVKDevice(), m_flight_readback_memory, 0, VK_WHOLE_SIZE, 0, (void**)&m_flight_readback_ptr),
+                  "Could not map flight readback memory.\n");
+
+  for(uint32_t i = 0; i < m_frame_count; ++i)
+  {
+    m_flight_reference[i].resize(transformsSize);
+    m_flight_readback_ready[i] = false;
+  }
+}
+
+void vkeGameRendererDynamic::setMaterialData(VkeMaterial::List* inData)
+{
+  m_materials = inData;
+
+  if(m_materials != NULL)
+  {
+
+    size_t cnt = m_materials->count();
+    size_t sz  = sizeof(VkeMaterialUniform) * cnt;
+
+    VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+    bufferCreate(&m_material_buffer_staging, sz, (VkBufferUsageFlagBits)usageFlags);
+    bufferAlloc(&m_material_buffer_staging, &m_material_staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+    VkeMaterialUniform* uniforms = NULL;
+
+    VKA_CHECK_ERROR(vkMapMemory(getDefaultDevice(), m_material_staging, 0, sz, 0, (void**)&uniforms), "Could not map buffer memory.\n");
+
+    for(size_t i = 0; i < cnt; ++i)
+    {
       VkeMaterial* mat = m_materials->getMaterial(i);
       mat->initVKBufferData(m_material_buffer_staging);
       mat->updateVKBufferData(uniforms);
@@ -514,62 +1077,101 @@ size_t vkeGameRendererDynamic::getRequiredDescriptorCount()
 }
 
 
-void vkeGameRendererDynamic::update()
+void vkeGameRendererDynamic::update(float inDeltaTime)
 {
   VulkanDC*         dc     = VulkanDC::Get();
   VulkanDC::Device* device = dc->getDefaultDevice();
 
-  static float totalTime = 0.0f;
-  static auto lastFrameStart = std::chrono::high_resolution_clock::now();
-  auto thisFrameStart = std::chrono::high_resolution_clock::now();
-
-  float deltaTime = std::chrono::duration<float>(thisFrameStart - lastFrameStart).count();
-  totalTime += deltaTime;
-  lastFrameStart = thisFrameStart;
+  float deltaTime = inDeltaTime;
+  m_total_time += deltaTime;
 
-  size_t cnt = m_node_data->count();
+  m_delta_time = deltaTime;
+  m_upload_ranges.clear();
 
+  /*
+	Waits for this frame's last submit, so its
+	staging and transform ring regions are free
+	to be written below.
+	*/
+  m_frames[m_current_buffer_index].wait();
 
-  for(size_t i = 0; i < m_instance_count; ++i)
+  /*
+	Flight transforms. Every path moves each
+	frame. The CPU writes them to this frame's
+	ring region, or to a scratch copy that the
+	culling packs into the region. In GPU mode
+	the compute pass writes them, and the CPU
+	only runs as the validation reference for
+	frames that will be submitted.
+	*/
+  if(!m_gpu_flight)
   {
-    size_t     pointerOffset = (sizeof(VkeNodeUniform) * cnt) + (64 * i);
-    glm::mat4* matPtr        = (glm::mat4*)(((uint8_t*)m_uniforms_local) + pointerOffset);
-    m_flight_paths[i]->update(matPtr, deltaTime);
+    bool packed = m_cull_instances && !m_gpu_cull;
+    updateFlightPaths(deltaTime, packed ? m_flight_transforms.data() : getTransformRegion(m_current_buffer_index));
   }
+  else if(m_validate_flight)
+  {
+    validateFlightSimulation();
+    if(!m_is_first_frame)
+      updateFlightPaths(deltaTime, m_flight_reference[m_current_buffer_index].data());
+  }
+
+  m_node_data->update((VkeNodeRecord*)m_uniforms_local, m_instance_count);
 
-  m_node_data->update((VkeNodeUniform*)m_uniforms_local, m_instance_count);
+  const VkeNodeData::DirtyRanges& dirty = m_node_data->getDirtyRanges();
+  for(size_t i = 0; i < dirty.size(); ++i)
+  {
+    addUploadRange(sizeof(VkeNodeRecord) * dirty[i].first, sizeof(VkeNodeRecord) * dirty[i].count);
+  }
 
   m_camera->setViewport(0, 0, (float)m_width, (float)m_height);
-  m_camera->update(totalTime);
+  m_camera->update(m_total_time);
+
+  /*
+	The camera is written to this frame's ring
+	region rather than updated in the stream.
+	*/
+  memcpy(getFrameRegion(m_current_buffer_index), m_camera->getBackingStore(), sizeof(VkeCameraUniform));
+
+  cullInstances();
 
   generateDrawCommands();
+  reportStats(deltaTime);
 
   if(!m_is_first_frame)
   {
-    vkResetFences(device->getVKDevice(), 1, &m_update_fence[m_current_buffer_index]);
+    VkeFrameContext& frame = m_frames[m_current_buffer_index];
+
+    VkFence fence = frame.getFence();
+    vkResetFences(device->getVKDevice(), 1, &fence);
 
     const VkPipelineStageFlags waitStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    VkCommandBuffer            primary    = frame.getPrimary();
     VkSubmitInfo               subInfo    = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
     subInfo.commandBufferCount            = 1;
-    subInfo.pCommandBuffers               = &m_primary_commands[m_current_buffer_index];
+    subInfo.pCommandBuffers               = &primary;
 
 #if defined(WIN32)
+    VkSemaphore presentDone = frame.getPresentDone();
+    VkSemaphore renderDone  = frame.getRenderDone();
+
     subInfo.waitSemaphoreCount   = 1;
-    subInfo.pWaitSemaphores      = &m_present_done[m_current_buffer_index];
+    subInfo.pWaitSemaphores      = &presentDone;
     subInfo.pWaitDstStageMask    = &waitStages;
     subInfo.signalSemaphoreCount = 1;
-    subInfo.pSignalSemaphores    = &m_render_done[m_current_buffer_index];
+    subInfo.pSignalSemaphores    = &renderDone;
 #endif
-    vkQueueSubmit(dc->getDefaultQueue()->getVKQueue(), 1, &subInfo, m_update_fence[m_current_buffer_index]);
+    vkQueueSubmit(dc->getDefaultQueue()->getVKQueue(), 1, &subInfo, fence);
+    m_flight_readback_ready[m_current_buffer_index] = m_validate_flight;
+    m_cull_readback_ready[m_current_buffer_index]   = m_gpu_cull;
+    m_timestamps_ready[m_current_buffer_index]      = m_timestamp_pool != VK_NULL_HANDLE;
 
     /*
-				Synchronise the next buffer. 
-				This prevents the buffer from being reset when still in use
-				when we have more than 2 frames in flight.
-			*/
-    uint32_t nextBufferIndex = (m_current_buffer_index + 1) % 2;
+		The next frame context waits for its own
+		last submit when it begins, so up to
+		m_frame_count frames are queued.
+		*/
     present();
-    vkWaitForFences(device->getVKDevice(), 1, &m_update_fence[nextBufferIndex], VK_TRUE, 1000000);
   }
   else
   {
@@ -577,24 +1179,939 @@ void vkeGameRendererDynamic::update()
   }
 
   m_current_buffer_index++;
-  m_current_buffer_index %= 2;
+  m_current_buffer_index %= m_frame_count;
+}
+
+
+/*
+	Advances the CPU flight paths and writes the
+	instances in the current format. The swarm
+	steers on the worker threads first.
+*/
+void vkeGameRendererDynamic::updateFlightPaths(float inDeltaTime, uint8_t* outInstances)
+{
+  if(m_flight_paths.isSwarm())
+    m_flight_paths.steer(inDeltaTime, m_thread_pool);
+
+  if(m_instance_format == INSTANCE_FORMAT_COMPACT)
+    m_flight_paths.updateCompact(inDeltaTime, (VkeInstanceRecord*)outInstances);
+  else
+    m_flight_paths.update(inDeltaTime, (float*)outInstances);
+}
+
+/*
+	Queues a byte range of m_uniforms_local for upload,
+	merging it with the previous range when contiguous.
+*/
+void vkeGameRendererDynamic::addUploadRange(VkDeviceSize inOffset, VkDeviceSize inSize)
+{
+  if(!m_upload_ranges.empty())
+  {
+    VkBufferCopy& last = m_upload_ranges.back();
+    if(last.dstOffset + last.size == inOffset)
+    {
+      last.size += inSize;
+      return;
+    }
+  }
+
+  VkBufferCopy range;
+  range.srcOffset = 0;
+  range.dstOffset = inOffset;
+  range.size      = inSize;
+  m_upload_ranges.push_back(range);
+}
+
+/*
+	Copies the dirty ranges into this frame's staging
+	region and records the buffer copies. The whole
+	buffer is sent until the first frame is submitted.
+*/
+void vkeGameRendererDynamic::recordUploads(VkCommandBuffer inCmd)
+{
+  if(m_force_full_upload || m_is_first_frame)
+  {
+    m_upload_ranges.clear();
+    addUploadRange(0, m_uniforms_size);
+    if(!m_is_first_frame)
+      m_force_full_upload = false;
+  }
+
+  m_stats.upload_bytes  = 0;
+  m_stats.upload_ranges = uint32_t(m_upload_ranges.size());
+
+  if(m_upload_ranges.empty())
+    return;
+
+  VkDeviceSize regionOffset = m_uniforms_size * m_current_buffer_index;
+
+  for(size_t i = 0; i < m_upload_ranges.size(); ++i)
+  {
+    VkBufferCopy& range = m_upload_ranges[i];
+    range.srcOffset     = regionOffset + range.dstOffset;
+    memcpy(m_uniforms_staging_ptr + range.srcOffset, ((uint8_t*)m_uniforms_local) + range.dstOffset, size_t(range.size));
+    m_stats.upload_bytes += range.size;
+  }
+
+  /*
+	The previous frame's vertex and compute
+	shaders may still read what is overwritten.
+	*/
+  VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+  barrier.srcAccessMask         = VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+  barrier.dstAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer                = m_uniforms_buffer;
+  barrier.offset                = 0;
+  barrier.size                  = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+
+  vkCmdCopyBuffer(inCmd, m_uniforms_buffer_staging, m_uniforms_buffer, uint32_t(m_upload_ranges.size()), m_upload_ranges.data());
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+}
+
+/*
+	Copies the flight paths up on the first submitted
+	frame, then advances them on the GPU. Runs after
+	the uploads so the transforms it writes are not
+	overwritten by a full upload.
+*/
+void vkeGameRendererDynamic::recordFlightSimulation(VkCommandBuffer inCmd)
+{
+  if(!m_gpu_flight)
+    return;
+
+  if(m_flight_upload_pending)
+  {
+    VkBufferCopy bufCpy;
+    bufCpy.srcOffset = 0;
+    bufCpy.dstOffset = 0;
+    bufCpy.size      = sizeof(VkeFlightRecord) * m_instance_count;
+    vkCmdCopyBuffer(inCmd, m_flight_buffer_staging, m_flight_buffer, 1, &bufCpy);
+
+    if(!m_is_first_frame)
+      m_flight_upload_pending = false;
+  }
+
+  /*
+	Wait for this frame's copies and for the vertex
+	reads of the previous frame before writing.
+	*/
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+  struct
+  {
+    float    delta_time;
+    uint32_t count;
+  } params = {m_delta_time, m_instance_count};
+
+  vkCmdBindPipeline(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_flight_pipeline);
+  vkCmdBindDescriptorSets(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_flight_pipeline_layout, 0, 1, &m_flight_descriptor_set, 0, NULL);
+  vkCmdPushConstants(inCmd, m_flight_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+  vkCmdDispatch(inCmd, (m_instance_count + 63) / 64, 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0, 1, &barrier, 0, NULL, 0, NULL);
+
+  if(!m_validate_flight)
+    return;
+
+  VkDeviceSize transformsSize = VkDeviceSize(m_instance_stride) * m_instance_count;
+
+  VkBufferCopy readback;
+  readback.srcOffset = m_transforms_offset;
+  readback.dstOffset = transformsSize * m_current_buffer_index;
+  readback.size      = transformsSize;
+  vkCmdCopyBuffer(inCmd, m_uniforms_buffer, m_flight_readback, 1, &readback);
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+/*
+	Compares the transforms read back from the last
+	submission of this command buffer with the CPU
+	reference integrated for the same frame. t is
+	advanced separately on each side, so rounding
+	differences drift slowly; the tolerance allows
+	for that. Instances are compared float by float,
+	the packed rotation words are bit identical.
+*/
+void vkeGameRendererDynamic::validateFlightSimulation()
+{
+  VulkanDC::Device* device = VulkanDC::Get()->getDefaultDevice();
+  uint32_t          index  = m_current_buffer_index;
+
+  if(!m_flight_readback_ready[index] || vkGetFenceStatus(device->getVKDevice(), m_frames[index].getFence()) != VK_SUCCESS)
+    return;
+
+  m_flight_readback_ready[index] = false;
+
+  size_t       floatsPerInstance = m_instance_stride / sizeof(float);
+  size_t       floatCount        = floatsPerInstance * m_instance_count;
+  const float* gpu               = (const float*)(m_flight_readback_ptr + m_flight_reference[index].size() * index);
+  const float* cpu               = (const float*)m_flight_reference[index].data();
+
+  float    maxError = 0.0f;
+  uint32_t worst    = 0;
+  for(size_t i = 0; i < floatCount; ++i)
+  {
+    float error = fabsf(gpu[i] - cpu[i]);
+    if(error > maxError)
+    {
+      maxError = error;
+      worst    = uint32_t(i / floatsPerInstance);
+    }
+  }
+
+  if(maxError > 0.05f)
+  {
+    LOGE("Flight validation failed: instance %u is %g away from the CPU result.\n", worst, maxError);
+  }
+}
+
+/*
+	Culls the CPU flight instances against the
+	camera frustum and packs the visible ones, in
+	order, to the front of the transforms block.
+	The sphere test covers the whole chopper in
+	any orientation, so it needs no matrices.
+	With impostors, only instances short of the
+	fade band's far edge stay in the mesh block,
+	and those past its near edge are copied after
+	it for the impostor draw.
+*/
+void vkeGameRendererDynamic::cullInstances()
+{
+  if(m_gpu_cull)
+  {
+    m_draw_instance_count = m_instance_count;
+    readCullStats();
+    return;
+  }
+
+  if(m_gpu_flight || !m_cull_instances)
+  {
+    m_draw_instance_count     = m_instance_count;
+    m_stats.visible_instances = m_instance_count;
+    m_stats.culled_instances  = 0;
+    return;
+  }
+
+  if(m_cull_x.size() != m_instance_count)
+  {
+    m_cull_x.resize(m_instance_count);
+    m_cull_y.resize(m_instance_count);
+    m_cull_z.resize(m_instance_count);
+    m_cull_radius.resize(m_instance_count);
+  }
+  m_visible_instances.resize(m_instance_count);
+
+  AABB      sceneBounds = m_node_data->getBounds();
+  glm::vec3 farthest    = glm::max(glm::abs(sceneBounds.m_min), glm::abs(sceneBounds.m_max));
+  float     radius      = glm::length(farthest);
+  Frustum   frustum(m_camera->getViewProjection());
+
+  const uint32_t chunkSize  = 4096;
+  uint32_t       chunkCount = (m_instance_count + chunkSize - 1) / chunkSize;
+  m_cull_chunk_counts.resize(chunkCount);
+
+  m_thread_pool.run(chunkCount, [&](uint32_t inChunk) {
+    uint32_t first = inChunk * chunkSize;
+    uint32_t count = std::min(chunkSize, m_instance_count - first);
+
+    m_flight_paths.getSpheres(radius, first, count, m_cull_x.data(), m_cull_y.data(), m_cull_z.data(), m_cull_radius.data());
+    m_cull_chunk_counts[inChunk] = cullSpheres(frustum, m_cull_x.data(), m_cull_y.data(), m_cull_z.data(),
+                                               m_cull_radius.data(), first, count, m_visible_instances.data() + first);
+  });
+
+  /*
+	Gather the chunk results and write each visible
+	transform to its packed slot in this frame's
+	ring region. The region is only written, in
+	order, which suits uncached host memory. A
+	slot never lies past its source, so the index
+	list can be packed in place.
+	*/
+  const uint8_t* source     = m_flight_transforms.data();
+  uint8_t*       transforms = getTransformRegion(m_current_buffer_index);
+  uint32_t       visible    = 0;
+  uint32_t       inView     = 0;
+  uint32_t       impostors  = 0;
+  glm::vec3      eye        = m_camera->getPosition();
+  float          nearSq     = m_impostors ? m_impostor_near * m_impostor_near : FLT_MAX;
+  float          farSq      = m_impostors ? m_impostor_far * m_impostor_far : FLT_MAX;
+
+  if(m_impostors)
+    m_impostor_transforms.resize(size_t(m_instance_stride) * m_instance_count);
+
+  for(uint32_t c = 0; c < chunkCount; ++c)
+  {
+    const uint32_t* chunk = m_visible_instances.data() + size_t(c) * chunkSize;
+    uint32_t        count = m_cull_chunk_counts[c];
+    inView += count;
+    for(uint32_t i = 0; i < count; ++i)
+    {
+      uint32_t instance = chunk[i];
+      float    dx       = m_cull_x[instance] - eye.x;
+      float    dy       = m_cull_y[instance] - eye.y;
+      float    dz       = m_cull_z[instance] - eye.z;
+      float    distSq   = dx * dx + dy * dy + dz * dz;
+
+      if(distSq >= nearSq)
+      {
+        memcpy(m_impostor_transforms.data() + size_t(impostors++) * m_instance_stride,
+               source + size_t(instance) * m_instance_stride, m_instance_stride);
+      }
+
+      if(distSq >= farSq)
+        continue;
+
+      memcpy(transforms + size_t(visible) * m_instance_stride, source + size_t(instance) * m_instance_stride, m_instance_stride);
+      m_visible_instances[visible++] = instance;
+    }
+  }
+  m_visible_instances.resize(visible);
+
+  /*
+	The block has room for every instance twice,
+	so the impostors always fit after the meshes.
+	*/
+  if(impostors > 0)
+  {
+    memcpy(transforms + size_t(visible) * m_instance_stride, m_impostor_transforms.data(), size_t(impostors) * m_instance_stride);
+  }
+
+  m_draw_instance_count      = visible;
+  m_impostor_instance_count  = impostors;
+  m_stats.visible_instances  = inView;
+  m_stats.culled_instances   = m_instance_count - inView;
+  m_stats.mesh_instances     = visible;
+  m_stats.impostor_instances = impostors;
+}
+
+/*
+	Takes the visible count from the last submission
+	of this command buffer, so the GPU culling stats
+	trail by a frame or two.
+*/
+void vkeGameRendererDynamic::readCullStats()
+{
+  VulkanDC::Device* device = VulkanDC::Get()->getDefaultDevice();
+  uint32_t          index  = m_current_buffer_index;
+
+  if(!m_cull_readback_ready[index] || vkGetFenceStatus(device->getVKDevice(), m_frames[index].getFence()) != VK_SUCCESS)
+    return;
+
+  m_cull_readback_ready[index] = false;
+
+  size_t          nodeCount = m_node_data->count();
+  const uint32_t* counts    = m_cull_readback_ptr + (nodeCount + 4) * index;
+  uint32_t        visible   = counts[nodeCount];
+
+  if(m_occlusion_cull)
+  {
+    m_stats.occluded_instances  = counts[nodeCount + 2];
+    m_stats.recovered_instances = counts[nodeCount + 3];
+    visible += m_stats.recovered_instances;
+  }
+
+  m_stats.visible_instances = visible;
+  m_stats.culled_instances  = m_instance_count - visible;
+}
+
+/*
+	Reads the timestamps of the last submission of
+	this command buffer. update() has waited for
+	it, so they are final. Without occlusion
+	culling only the main pass is bracketed.
+*/
+void vkeGameRendererDynamic::readTimestamps()
+{
+  VulkanDC::Device* device = VulkanDC::Get()->getDefaultDevice();
+  uint32_t          index  = m_current_buffer_index;
+
+  if(m_timestamp_pool == VK_NULL_HANDLE || !m_timestamps_ready[index])
+    return;
+
+  m_timestamps_ready[index] = false;
+
+  uint32_t count = m_occlusion_cull ? 4 : 2;
+  uint64_t ticks[4];
+  if(vkGetQueryPoolResults(device->getVKDevice(), m_timestamp_pool, index * 4, count, sizeof(uint64_t) * count, ticks,
+                           sizeof(uint64_t), VK_QUERY_RESULT_64_BIT)
+     != VK_SUCCESS)
+    return;
+
+  float msPerTick = m_timestamp_period * 1.0e-6f;
+
+  m_stats.scene_gpu_ms = float(ticks[1] - ticks[0]) * msPerTick;
+
+  if(!m_occlusion_cull)
+    return;
+
+  m_stats.scene_gpu_ms += float(ticks[3] - ticks[2]) * msPerTick;
+  m_stats.occlusion_gpu_ms = float(ticks[2] - ticks[1]) * msPerTick;
+
+  /*
+	An estimate: the instances that stayed hidden at
+	the average cost of a drawn one, less the cost
+	of the pyramid and the second phase.
+	*/
+  uint32_t visible     = m_stats.visible_instances;
+  uint32_t hidden      = m_stats.occluded_instances - m_stats.recovered_instances;
+  m_stats.saved_gpu_ms = visible > 0 ? m_stats.scene_gpu_ms / float(visible) * float(hidden) - m_stats.occlusion_gpu_ms : 0.0f;
+}
+
+/*
+	Culls instances and nodes in two dispatches. The
+	first appends each visible instance to the lists
+	of its visible nodes, the second packs the non
+	empty commands in node order and writes the draw
+	count. The frustum, and with occlusion culling
+	the two cameras, are the only per frame inputs.
+*/
+void vkeGameRendererDynamic::recordGPUCulling(VkCommandBuffer inCmd)
+{
+  if(!m_gpu_cull)
+    return;
+
+  /*
+	Wait for this frame's uploads and flight pass,
+	and for the previous frame's draws to finish
+	with the lists and commands.
+	*/
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(inCmd,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                           | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+  vkCmdFillBuffer(inCmd, m_cull_count_buffer, 0, VK_WHOLE_SIZE, 0);
+
+  /*
+	The first phase projects into the pyramid with
+	the camera it was built from, the second with
+	this frame's, which the pyramid then keeps.
+	*/
+  if(m_occlusion_cull)
+  {
+    struct
+    {
+      glm::mat4 view_proj[2];
+      glm::vec4 hiz_size;
+    } occlusion;
+
+    occlusion.view_proj[0] = m_hiz_view_projection;
+    occlusion.view_proj[1] = m_camera->getViewProjection();
+    occlusion.hiz_size     = glm::vec4(float(m_hiz_width), float(m_hiz_height), float(m_hiz_levels), 0.0f);
+    m_hiz_view_projection  = occlusion.view_proj[1];
+
+    vkCmdUpdateBuffer(inCmd, m_occlusion_params_buffer, 0, sizeof(occlusion), &occlusion);
+  }
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+  vkCmdBindPipeline(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline);
+  uint32_t transformsOffset = getTransformsOffset(m_current_buffer_index);
+  vkCmdBindDescriptorSets(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline_layout, 0, 1, &m_cull_descriptor_set, 1,
+                          &transformsOffset);
+  if(m_occlusion_cull)
+  {
+    vkCmdBindDescriptorSets(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline_layout, 1, 1, &m_occlusion_descriptor_set,
+                            0, NULL);
+  }
+  pushCullParams(inCmd, 0);
+  vkCmdDispatch(inCmd, (m_instance_count + 63) / 64, 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                       NULL, 0, NULL);
+
+  pushCullParams(inCmd, 1);
+  vkCmdDispatch(inCmd, 1, 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0, 1, &barrier, 0, NULL, 0, NULL);
+
+  /*
+	With occlusion culling the counts are read back
+	after the second phase.
+	*/
+  if(!m_occlusion_cull)
+    recordCullReadback(inCmd);
+}
+
+/*
+	Push constants for one pass of the cull shader.
+*/
+void vkeGameRendererDynamic::pushCullParams(VkCommandBuffer inCmd, uint32_t inPass)
+{
+  Frustum frustum(m_camera->getViewProjection());
+  AABB    sceneBounds = m_node_data->getBounds();
+
+  struct
+  {
+    glm::vec4 planes[6];
+    glm::vec4 scene_sphere;
+    uint32_t  instance_count;
+    uint32_t  node_count;
+    uint32_t  pass;
+  } params;
+
+  for(int p = 0; p < 6; ++p)
+  {
+    params.planes[p] = frustum.m_planes[p];
+  }
+  params.scene_sphere   = glm::vec4(sceneBounds.getCenter(), glm::length(sceneBounds.getExtent()));
+  params.instance_count = m_instance_count;
+  params.node_count     = uint32_t(m_node_data->count());
+  params.pass           = inPass;
+
+  vkCmdPushConstants(inCmd, m_cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+}
+
+/*
+	Builds the depth pyramid from the depth of the
+	main pass, one dispatch per level.
+*/
+void vkeGameRendererDynamic::recordHiZBuild(VkCommandBuffer inCmd)
+{
+  /*
+	Depth writes must land before it is sampled,
+	and the first phase must be done reading the
+	pyramid before it is overwritten.
+	*/
+  VkImageMemoryBarrier depthBarrier            = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+  depthBarrier.srcAccessMask                   = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  depthBarrier.dstAccessMask                   = VK_ACCESS_SHADER_READ_BIT;
+  depthBarrier.oldLayout                       = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  depthBarrier.newLayout                       = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+  depthBarrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+  depthBarrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+  depthBarrier.image                           = m_depth_attachment.image;
+  depthBarrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+  depthBarrier.subresourceRange.baseMipLevel   = 0;
+  depthBarrier.subresourceRange.levelCount     = 1;
+  depthBarrier.subresourceRange.baseArrayLayer = 0;
+  depthBarrier.subresourceRange.layerCount     = 1;
+
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &depthBarrier);
+
+  struct
+  {
+    int32_t  depth_size[2];
+    uint32_t level;
+    uint32_t samples;
+  } params = {{int32_t(m_width), int32_t(m_height)}, 0, uint32_t(getSamples())};
+
+  vkCmdBindPipeline(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hiz_pipeline);
+
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT;
+
+  for(uint32_t i = 0; i < m_hiz_levels; ++i)
+  {
+    uint32_t width  = std::max(m_hiz_width >> i, 1u);
+    uint32_t height = std::max(m_hiz_height >> i, 1u);
+
+    params.level = i;
+    vkCmdBindDescriptorSets(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hiz_pipeline_layout, 0, 1, &m_hiz_level_sets[i], 0, NULL);
+    vkCmdPushConstants(inCmd, m_hiz_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+    vkCmdDispatch(inCmd, (width + 7) / 8, (height + 7) / 8, 1);
+
+    vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                         NULL, 0, NULL);
+  }
+
+  /*
+	Hand the depth back to the second pass, which
+	also loads the color the main pass wrote.
+	*/
+  depthBarrier.srcAccessMask = 0;
+  depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  depthBarrier.oldLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+  depthBarrier.newLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT
+                           | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                       0, 1, &barrier, 0, NULL, 1, &depthBarrier);
+}
+
+/*
+	Second phase of occlusion culling, recorded after
+	the main pass. Rebuilds the pyramid, re-tests the
+	instances the first phase set aside and draws the
+	ones now visible over the main pass. Timestamps
+	bracket each step for the frame stats.
+*/
+void vkeGameRendererDynamic::recordOcclusionPass(VkCommandBuffer inCmd)
+{
+  if(!m_occlusion_cull)
+    return;
+
+  VulkanAppContext* ctxt      = VulkanAppContext::GetInstance();
+  uint32_t          nodeCount = uint32_t(m_node_data->count());
+  uint32_t          query     = m_current_buffer_index * 4;
+
+  recordHiZBuild(inCmd);
+
+  /*
+	The main pass is done with the lists and
+	commands. Clear the per node counts; the
+	occlusion counters after them carry over.
+	*/
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask   = 0;
+  barrier.dstAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+  vkCmdFillBuffer(inCmd, m_cull_count_buffer, 0, sizeof(uint32_t) * nodeCount, 0);
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+  VkDescriptorSet cullSets[2]      = {m_cull_descriptor_set, m_occlusion_descriptor_set};
+  uint32_t        transformsOffset = getTransformsOffset(m_current_buffer_index);
+  vkCmdBindPipeline(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline);
+  vkCmdBindDescriptorSets(inCmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline_layout, 0, 2, cullSets, 1, &transformsOffset);
+
+  /*
+	Only the set aside instances are tested, but
+	their count is on the GPU, so dispatch for all.
+	*/
+  pushCullParams(inCmd, 2);
+  vkCmdDispatch(inCmd, (m_instance_count + 63) / 64, 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                       NULL, 0, NULL);
+
+  pushCullParams(inCmd, 1);
+  vkCmdDispatch(inCmd, 1, 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0, 1, &barrier, 0, NULL, 0, NULL);
+
+  recordCullReadback(inCmd);
+
+  if(m_timestamp_pool != VK_NULL_HANDLE)
+    vkCmdWriteTimestamp(inCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_pool, query + 2);
+
+  /*
+	Draw the recovered instances inline, with the
+	same state the scene secondaries use.
+	*/
+  renderPassBegin(&inCmd, m_occlusion_render_pass, m_frames[m_current_buffer_index].m_framebuffer, 0, 0, m_width,
+                  m_height, NULL, 0, VK_SUBPASS_CONTENTS_INLINE);
+
+  setDefaultViewportAndScissor(inCmd, m_width, m_height);
+
+  ctxt->getVBO()->bind(&inCmd);
+  ctxt->getIBO()->bind(&inCmd);
+
+  VkDescriptorSet sets[3]    = {m_scene_descriptor_set, m_texture_descriptor_sets[0], m_transform_descriptor_set};
+  uint32_t        offsets[2] = {getFrameOffset(m_current_buffer_index), transformsOffset};
+  vkCmdBindDescriptorSets(inCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layout, 0, 3, sets, 2, offsets);
+
+  m_stats.pipeline_binds += recordSceneBatches(inCmd, 0, nodeCount);
+
+  vkCmdEndRenderPass(inCmd);
+
+  if(m_timestamp_pool != VK_NULL_HANDLE)
+    vkCmdWriteTimestamp(inCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_pool, query + 3);
+}
+
+/*
+	Copies the cull counts into this command buffer's
+	region of the readback buffer.
+*/
+void vkeGameRendererDynamic::recordCullReadback(VkCommandBuffer inCmd)
+{
+  VkDeviceSize countSize = sizeof(uint32_t) * (m_node_data->count() + 4);
+
+  VkBufferCopy readback;
+  readback.srcOffset = 0;
+  readback.dstOffset = countSize * m_current_buffer_index;
+  readback.size      = countSize;
+  vkCmdCopyBuffer(inCmd, m_cull_count_buffer, m_cull_readback, 1, &readback);
+
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask   = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
 }
 
+uint32_t vkeGameRendererDynamic::recordSceneBatches(VkCommandBuffer inCmd, uint32_t inFirst, uint32_t inCount)
+{
+  uint32_t   binds    = 0;
+  VkPipeline bound    = VK_NULL_HANDLE;
+  uint32_t   sliceEnd = inFirst + inCount;
+
+  for(uint32_t b = 0; b < uint32_t(m_draw_batches.size()); ++b)
+  {
+    const DrawBatch& batch = m_draw_batches[b];
+    uint32_t         first = std::max(inFirst, batch.first);
+    uint32_t         end   = std::min(sliceEnd, batch.first + batch.count);
+    if(first >= end)
+      continue;
+
+    VkPipeline pipeline = m_pass_pipelines[batch.pass];
+    if(pipeline != bound)
+    {
+      vkCmdBindPipeline(inCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+      bound = pipeline;
+      ++binds;
+    }
+
+    recordSceneDraw(inCmd, b, first, end - first);
+  }
+
+  return binds;
+}
+
+/*
+	Scene draws of batch inBatch, nodes inFirst to
+	inFirst + inCount. With GPU culling the commands
+	and the batch's count come from the cull pass.
+	The count covers the batch's packed commands, so
+	a slice past their end draws the empty commands
+	the cull pass leaves there.
+*/
+void vkeGameRendererDynamic::recordSceneDraw(VkCommandBuffer inCmd, uint32_t inBatch, uint32_t inFirst, uint32_t inCount)
+{
+  VkDeviceSize offset = sizeof(VkDrawIndexedIndirectCommand) * inFirst;
+
+  DrawParams params = {inFirst, m_instance_count};
+  vkCmdPushConstants(inCmd, m_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawParams), &params);
+
+  if(m_gpu_cull)
+  {
+    VulkanDC::Device* device    = VulkanDC::Get()->getDefaultDevice();
+    uint32_t          nodeCount = uint32_t(m_node_data->count());
+    device->getDrawIndexedIndirectCount()(inCmd, m_cull_draw_buffer, offset, m_cull_count_buffer,
+                                          sizeof(uint32_t) * (nodeCount + 4 + inBatch), inCount,
+                                          sizeof(VkDrawIndexedIndirectCommand));
+    return;
+  }
+
+  vkCmdDrawIndexedIndirect(inCmd, m_scene_indirect_buffer, offset, inCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+/*
+	Patches instanceCount in the indirect commands
+	when the number of instances to draw changes.
+	firstInstance stays at each node's block, so
+	the shader still finds its node record. The
+	impostor draw starts after the mesh instances
+	and is rewritten every frame.
+*/
+void vkeGameRendererDynamic::recordInstanceCounts(VkCommandBuffer inCmd)
+{
+  if(m_impostors)
+  {
+    VkDrawIndirectCommand impostorDraw = {4, m_impostor_instance_count, 0, m_draw_instance_count};
+
+    VkBufferMemoryBarrier impostorBarrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    impostorBarrier.srcAccessMask         = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    impostorBarrier.dstAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+    impostorBarrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    impostorBarrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    impostorBarrier.buffer                = m_impostor_indirect_buffer;
+    impostorBarrier.offset                = 0;
+    impostorBarrier.size                  = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1,
+                         &impostorBarrier, 0, NULL);
+    vkCmdUpdateBuffer(inCmd, m_impostor_indirect_buffer, 0, sizeof(impostorDraw), &impostorDraw);
+
+    impostorBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    impostorBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, NULL, 1,
+                         &impostorBarrier, 0, NULL);
+  }
+
+  if(m_indirect_commands.empty() || m_draw_instance_count == m_patched_instance_count)
+    return;
+
+  for(size_t i = 0; i < m_indirect_commands.size(); ++i)
+  {
+    m_indirect_commands[i].instanceCount = m_draw_instance_count;
+  }
+
+  VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+  barrier.srcAccessMask         = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  barrier.dstAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer                = m_scene_indirect_buffer;
+  barrier.offset                = 0;
+  barrier.size                  = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+
+  /*
+	vkCmdUpdateBuffer takes at most 64KB at a time.
+	*/
+  const uint8_t* data = (const uint8_t*)m_indirect_commands.data();
+  VkDeviceSize   size = sizeof(VkDrawIndexedIndirectCommand) * m_indirect_commands.size();
+  for(VkDeviceSize offset = 0; offset < size; offset += 65536)
+  {
+    VkDeviceSize chunk = std::min<VkDeviceSize>(65536, size - offset);
+    vkCmdUpdateBuffer(inCmd, m_scene_indirect_buffer, offset, chunk, data + offset);
+  }
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+
+  /*
+	The first frame is recorded but not submitted.
+	*/
+  if(!m_is_first_frame)
+    m_patched_instance_count = m_draw_instance_count;
+}
+
+/*
+	Accumulates the per frame counters and
+	logs their averages once a second.
+*/
+void vkeGameRendererDynamic::reportStats(float inDeltaTime)
+{
+  m_stats_accum.upload_bytes += m_stats.upload_bytes;
+  m_stats_accum.upload_ranges += m_stats.upload_ranges;
+  m_stats_accum.visible_instances += m_stats.visible_instances;
+  m_stats_accum.culled_instances += m_stats.culled_instances;
+  m_stats_accum.occluded_instances += m_stats.occluded_instances;
+  m_stats_accum.recovered_instances += m_stats.recovered_instances;
+  m_stats_accum.scene_gpu_ms += m_stats.scene_gpu_ms;
+  m_stats_accum.occlusion_gpu_ms += m_stats.occlusion_gpu_ms;
+  m_stats_accum.saved_gpu_ms += m_stats.saved_gpu_ms;
+  m_stats_accum.mesh_instances += m_stats.mesh_instances;
+  m_stats_accum.impostor_instances += m_stats.impostor_instances;
+  m_stats_accum.rerecorded_commands += m_stats.rerecorded_commands;
+  m_stats_accum.fence_wait_ms += m_stats.fence_wait_ms;
+  m_stats_accum.record_ms += m_stats.record_ms;
+  m_stats_accum.scene_draws += m_stats.scene_draws;
+  m_stats_accum.pipeline_binds += m_stats.pipeline_binds;
+  m_stats_frames++;
+  m_stats_time += inDeltaTime;
+
+  if(m_stats_time < 1.0f)
+    return;
+
+  LOGI("Frame stats (%u frames): upload %llu bytes/frame in %u ranges/frame, %u/%u instances visible, %u culled\n",
+       m_stats_frames, (unsigned long long)(m_stats_accum.upload_bytes / m_stats_frames),
+       m_stats_accum.upload_ranges / m_stats_frames, m_stats_accum.visible_instances / m_stats_frames, m_instance_count,
+       m_stats_accum.culled_instances / m_stats_frames);
+
+  LOGI("Command stats: %.1f scene secondaries re-recorded/s\n", float(m_stats_accum.rerecorded_commands) / m_stats_time);
+
+  /*
+	Each secondary binds the pipeline of every
+	batch it overlaps, so the binds are at least
+	the secondaries and at most that plus the
+	batch boundaries.
+	*/
+  LOGI("State stats: %u draw batches, %.1f scene pipeline binds/frame\n", uint32_t(m_draw_batches.size()),
+       float(m_stats_accum.pipeline_binds) / float(m_stats_frames));
+
+  /*
+	The CPU only waits once it is m_frame_count
+	frames ahead, so the wait shrinks as the ring
+	gets deeper until the GPU is the bottleneck.
+	*/
+  LOGI("Frame pacing: %u frames in flight, %.3f ms/frame CPU frame time, %.3f ms/frame waiting on the GPU\n",
+       m_frame_count, 1000.0f * m_stats_time / float(m_stats_frames), m_stats_accum.fence_wait_ms / float(m_stats_frames));
+
+  if(m_occlusion_cull)
+  {
+    float    frames   = float(m_stats_frames);
+    uint32_t occluded = m_stats_accum.occluded_instances - m_stats_accum.recovered_instances;
+    uint32_t frustum  = m_stats_accum.culled_instances - occluded;
+    float    total    = float(m_instance_count) * frames;
+
+    LOGI("Occlusion stats: %.1f%% frustum culled, %.1f%% occluded, %u/frame recovered by the second pass; "
+         "scene %.3f ms, Hi-Z and re-test %.3f ms, ~%.3f ms/frame saved\n",
+         100.0f * float(frustum) / total, 100.0f * float(occluded) / total, m_stats_accum.recovered_instances / m_stats_frames,
+         m_stats_accum.scene_gpu_ms / frames, m_stats_accum.occlusion_gpu_ms / frames, m_stats_accum.saved_gpu_ms / frames);
+  }
+
+  /*
+	The GPU time is the whole main pass, so the
+	terrain and impostor draws are in it too.
+	*/
+  if(m_draw_benchmark && m_stats_accum.scene_draws > 0)
+  {
+    float draws = float(m_stats_accum.scene_draws);
+
+    LOGI("Draw benchmark: %u draws/frame, %.3f us CPU and %.3f us GPU per draw, %s\n", m_stats_accum.scene_draws / m_stats_frames,
+         1000.0f * m_stats_accum.record_ms / draws, 1000.0f * m_stats_accum.scene_gpu_ms / draws,
+         VulkanDC::Get()->getDefaultDevice()->hasShaderDrawParameters() ? "draw parameters" : "instance divide");
+  }
+
+  if(m_impostors)
+  {
+    uint32_t band = m_stats_accum.mesh_instances + m_stats_accum.impostor_instances - m_stats_accum.visible_instances;
+
+    LOGI("Impostor stats: %u meshes/frame, %u impostors/frame, %u/frame in the fade band\n",
+         m_stats_accum.mesh_instances / m_stats_frames, m_stats_accum.impostor_instances / m_stats_frames, band / m_stats_frames);
+  }
+
+  m_stats_accum  = Stats();
+  m_stats_frames = 0;
+  m_stats_time   = 0.0f;
+}
 
 void vkeGameRendererDynamic::present()
 {
   glDisable(GL_DEPTH_TEST);
 
+  VkeFrameContext& frame = m_frames[m_current_buffer_index];
+
 #if defined(WIN32)
-  glWaitVkSemaphoreNV((GLuint64)m_render_done[m_current_buffer_index]);
+  glWaitVkSemaphoreNV((GLuint64)frame.getRenderDone());
 #endif
 
-  glDrawVkImageNV((GLuint64)m_resolve_attachment[m_current_buffer_index].image, 0, 0, 0, float(m_width),
-                  float(m_height), 0, 0, 1, 1, 0);
+  glDrawVkImageNV((GLuint64)frame.m_resolve_attachment.image, 0, 0, 0, float(m_width), float(m_height), 0, 0, 1, 1, 0);
 
   glEnable(GL_DEPTH_TEST);
 #if defined(WIN32)
-  glSignalVkSemaphoreNV((GLuint64)m_present_done[m_current_buffer_index]);
+  glSignalVkSemaphoreNV((GLuint64)frame.getPresentDone());
 #endif
 }
 
@@ -604,7 +2121,7 @@ void vkeGameRendererDynamic::initDescriptorLayout()
   VkDescriptorSetLayoutBinding sceneLayoutBindings[4];
   VkDescriptorSetLayoutBinding textureLayoutBindings[1];
 
-  VkDescriptorSetLayoutBinding transformLayoutBinding;
+  VkDescriptorSetLayoutBinding transformLayoutBindings[2];
   VkDescriptorSetLayoutBinding quadBinding[3];
   VkDescriptorSetLayoutBinding terrainBinding[5];
 
@@ -616,43 +2133,177 @@ void vkeGameRendererDynamic::initDescriptorLayout()
   /*
 	Scene layout bindings (set 0)
 	Binding 0:		Environment Cube Map
-	Binding 1:		Camera Matrix
-	Binding 2:		Model Matrix
+	Binding 1:		Camera Matrix, dynamic offset selects the frame's ring region
+	Binding 2:		Node Records (storage)
 	Binding 3:		Material
 	*/
 
   layoutBinding(&sceneLayoutBindings[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
-  layoutBinding(&sceneLayoutBindings[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+  layoutBinding(&sceneLayoutBindings[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 1);
-  layoutBinding(&sceneLayoutBindings[2], 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1);
+  layoutBinding(&sceneLayoutBindings[2], 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1);
   layoutBinding(&sceneLayoutBindings[3], 3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
 
 
   /*
-	Transform layout binding (set 2)
-	Binding 1:	Transform Matrix
+	Transform layout bindings (set 2)
+	Binding 0:	Transforms, dynamic offset selects the frame's ring region
+	Binding 1:	Visible instance lists
 	*/
-  layoutBinding(&transformLayoutBinding, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1);
+  layoutBinding(&transformLayoutBindings[0], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1);
+  layoutBinding(&transformLayoutBindings[1], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1);
 
 
   /*
 	Texture Layout Bindings (Set 1)
-	Binding 0:		Diffuse Texture.
+	Binding 0:		Diffuse Texture array, one slot per material.
 	*/
-  assert(m_materials->count() == 6);  // We include 6 slots for textures in the shader
-  layoutBinding(&textureLayoutBindings[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 6);
+  if(!m_bindless_textures)
+    m_texture_slots = uint32_t(m_materials->count());
+  layoutBinding(&textureLayoutBindings[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT,
+                m_texture_slots);
+
+
+  descriptorSetLayoutCreate(&m_transform_descriptor_layout, 2, transformLayoutBindings);
+
+  /*
+	Flight simulation layout (compute)
+	Binding 0:	Flight records
+	Binding 1:	Transforms
+	Push constant: delta time, instance count
+	*/
+  VkDescriptorSetLayoutBinding flightBindings[2];
+  layoutBinding(&flightBindings[0], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+  layoutBinding(&flightBindings[1], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+  descriptorSetLayoutCreate(&m_flight_descriptor_layout, 2, flightBindings);
+
+  VkPushConstantRange flightConstants = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(float) + sizeof(uint32_t)};
+  pipelineLayoutCreate(&m_flight_pipeline_layout, 1, &m_flight_descriptor_layout, 1, &flightConstants);
+
+  /*
+	Instance culling layout (compute)
+	Binding 0:	Node records
+	Binding 1:	Transforms
+	Binding 2:	Visible instance lists
+	Binding 3:	Counts
+	Binding 4:	Indirect command templates
+	Binding 5:	Packed indirect commands
+	Binding 6:	Draw batch ends
+	Push constant: frustum, chopper sphere, counts, pass
+	*/
+  VkDescriptorSetLayoutBinding cullBindings[7];
+  for(uint32_t i = 0; i < 7; ++i)
+  {
+    layoutBinding(&cullBindings[i], i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+  }
+  cullBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+  descriptorSetLayoutCreate(&m_cull_descriptor_layout, 7, cullBindings);
+
+  VkPushConstantRange cullConstants = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(glm::vec4) * 7 + sizeof(uint32_t) * 3};
+
+  if(m_occlusion_cull)
+  {
+    /*
+		Occlusion layout (set 1 of the cull pass)
+		Binding 0:	Depth pyramid
+		Binding 1:	Cameras and pyramid size
+		Binding 2:	Occluded instances
+		*/
+    VkDescriptorSetLayoutBinding occlusionBindings[3];
+    layoutBinding(&occlusionBindings[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+    layoutBinding(&occlusionBindings[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+    layoutBinding(&occlusionBindings[2], 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+    descriptorSetLayoutCreate(&m_occlusion_descriptor_layout, 3, occlusionBindings);
 
+    VkDescriptorSetLayout cullLayouts[2] = {m_cull_descriptor_layout, m_occlusion_descriptor_layout};
+    pipelineLayoutCreate(&m_cull_pipeline_layout, 2, cullLayouts, 1, &cullConstants);
 
-  descriptorSetLayoutCreate(&m_transform_descriptor_layout, 1, &transformLayoutBinding);
+    /*
+		Hi-Z build layout (compute)
+		Binding 0:	Depth attachment
+		Binding 1:	Source level
+		Binding 2:	Destination level
+		Push constant: depth size, level, sample count
+		*/
+    VkDescriptorSetLayoutBinding hizBindings[3];
+    layoutBinding(&hizBindings[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+    layoutBinding(&hizBindings[1], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+    layoutBinding(&hizBindings[2], 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+    descriptorSetLayoutCreate(&m_hiz_descriptor_layout, 3, hizBindings);
+
+    VkPushConstantRange hizConstants = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t) * 4};
+    pipelineLayoutCreate(&m_hiz_pipeline_layout, 1, &m_hiz_descriptor_layout, 1, &hizConstants);
+  }
+  else
+  {
+    pipelineLayoutCreate(&m_cull_pipeline_layout, 1, &m_cull_descriptor_layout, 1, &cullConstants);
+  }
   descriptorSetLayoutCreate(&m_scene_descriptor_layout, 4, sceneLayoutBindings);
-  descriptorSetLayoutCreate(&m_texture_descriptor_set_layout, 1, textureLayoutBindings);
+  if(m_bindless_textures)
+  {
+    /*
+		Slots past the last material stay unwritten,
+		and new materials can be written while frames
+		using the set are in flight.
+		*/
+    VkDescriptorBindingFlagsEXT textureFlags =
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT textureFlagsInfo = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT};
+    textureFlagsInfo.bindingCount  = 1;
+    textureFlagsInfo.pBindingFlags = &textureFlags;
+
+    VkDescriptorSetLayoutCreateInfo textureLayoutInfo;
+    descriptorSetLayoutCreateInfo(&textureLayoutInfo, 1, textureLayoutBindings);
+    textureLayoutInfo.pNext = &textureFlagsInfo;
+    textureLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+
+    VKA_CHECK_ERROR(vkCreateDescriptorSetLayout(getDefaultDevice(), &textureLayoutInfo, NULL, &m_texture_descriptor_set_layout),
+                    "Could not create texture descriptor set layout.\n");
+  }
+  else
+  {
+    descriptorSetLayoutCreate(&m_texture_descriptor_set_layout, 1, textureLayoutBindings);
+  }
 
   VkDescriptorSetLayout layouts[3] = {m_scene_descriptor_layout, m_texture_descriptor_set_layout, m_transform_descriptor_layout};
 
   /*
-	Create pipeline layout for the scene.
+	Create pipeline layout for the scene. The
+	per draw values are push constants, so no
+	draw touches uniform memory.
 	*/
-  pipelineLayoutCreate(&m_pipeline_layout, 3, layouts);
+  VkPushConstantRange drawConstants = {VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawParams)};
+  pipelineLayoutCreate(&m_pipeline_layout, 3, layouts, 1, &drawConstants);
+
+  if(m_impostors)
+  {
+    /*
+		Impostor layout bindings (set 0)
+		Binding 0:	Camera Matrix
+		Binding 1:	Albedo atlas
+		Binding 2:	Normal atlas
+		Set 1 is the transform layout.
+		Push constant: chopper sphere, atlas grid
+		*/
+    VkDescriptorSetLayoutBinding impostorBindings[3];
+    layoutBinding(&impostorBindings[0], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1);
+    layoutBinding(&impostorBindings[1], 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
+    layoutBinding(&impostorBindings[2], 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
+    descriptorSetLayoutCreate(&m_impostor_descriptor_layout, 3, impostorBindings);
+
+    VkDescriptorSetLayout impostorLayouts[2] = {m_impostor_descriptor_layout, m_transform_descriptor_layout};
+    VkPushConstantRange   impostorConstants  = {VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::vec4) + sizeof(uint32_t)};
+    pipelineLayoutCreate(&m_impostor_pipeline_layout, 2, impostorLayouts, 1, &impostorConstants);
+
+    /*
+		The bake reads the scene and texture sets.
+		Push constant: view projection of the cell
+		*/
+    VkPushConstantRange bakeConstants = {VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4)};
+    pipelineLayoutCreate(&m_impostor_bake_pipeline_layout, 2, layouts, 1, &bakeConstants);
+  }
 
 
   /*----------------------------------------------------------
@@ -660,7 +2311,7 @@ void vkeGameRendererDynamic::initDescriptorLayout()
 	----------------------------------------------------------*/
 
   layoutBinding(&quadBinding[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
-  layoutBinding(&quadBinding[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1);
+  layoutBinding(&quadBinding[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1);
 
 
   //descriptor layout describing the bindings.
@@ -675,7 +2326,7 @@ void vkeGameRendererDynamic::initDescriptorLayout()
 	----------------------------------------------------------*/
 
   layoutBinding(&terrainBinding[0], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1);
-  layoutBinding(&terrainBinding[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+  layoutBinding(&terrainBinding[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT
                     | VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 1);
@@ -690,7 +2341,25 @@ void vkeGameRendererDynamic::initDescriptorLayout()
   pipelineLayoutCreate(&m_terrain_pipeline_layout, 1, &m_terrain_descriptor_set_layout);
 }
 
+/*
+	Sets are allocated and written once. Per frame
+	data is picked by dynamic offsets when they are
+	bound, so a resize only records the size
+	dependent commands again.
+*/
 void vkeGameRendererDynamic::initDescriptorSets()
+{
+  if(!m_descriptor_sets_ready)
+  {
+    allocateDescriptorSets();
+    m_descriptor_sets_ready = true;
+  }
+
+  initTerrainCommand();
+  initImpostorCommand();
+}
+
+void vkeGameRendererDynamic::allocateDescriptorSets()
 {
   VulkanDC* dc = VulkanDC::Get();
   if(!dc)
@@ -699,9 +2368,7 @@ void vkeGameRendererDynamic::initDescriptorSets()
 
   initCamera();
 
-  vkResetDescriptorPool(device->getVKDevice(), getDescriptorPool(), 0);
-
-  VkWriteDescriptorSet writes[6]{};
+  VkWriteDescriptorSet writes[7]{};
 
   /*----------------------------------------------------------
 	Get the resource data for the bindings.
@@ -714,9 +2381,9 @@ void vkeGameRendererDynamic::initDescriptorSets()
   VkeTexture::Data terrain = m_textures.getTexture(0)->getData();
 
   /*
-	Camera uniform
+	Camera uniform, in the frame ring.
 	*/
-  VkDescriptorBufferInfo camInfo = m_camera->getDescriptor();
+  VkDescriptorBufferInfo camInfo = m_camera_descriptor;
 
   /*
 	Cube map texture.
@@ -732,24 +2399,6 @@ void vkeGameRendererDynamic::initDescriptorSets()
 
   VkeMaterial* material = m_materials->getMaterial(0);
 
-
-  /*
-	Create descriptor image info array
-	for the scene textures.
-	*/
-  size_t texCount = m_materials->count();
-
-  VkDescriptorImageInfo* texImageInfo = (VkDescriptorImageInfo*)malloc(texCount * sizeof(VkDescriptorImageInfo));
-
-  for(size_t i = 0; i < texCount; ++i)
-  {
-    VkeMaterial*     mtrl       = m_materials->getMaterial(i);
-    VkeTexture::Data texData    = mtrl->getTextures().getTexture(0)->getData();
-    texImageInfo[i].imageView   = texData.view;
-    texImageInfo[i].sampler     = texData.sampler;
-    texImageInfo[i].imageLayout = texData.imageLayout;
-  }
-
   /*
 	Create descriptor image info for
 	the cube map texture.
@@ -791,10 +2440,14 @@ void vkeGameRendererDynamic::initDescriptorSets()
 	*/
   descAlloc.pSetLayouts        = &m_texture_descriptor_set_layout;
   descAlloc.descriptorSetCount = 1;
+  if(m_bindless_textures)
+    descAlloc.descriptorPool = m_texture_descriptor_pool;
 
   VKA_CHECK_ERROR(vkAllocateDescriptorSets(device->getVKDevice(), &descAlloc, m_texture_descriptor_sets),
                   "Could not allocate texture descriptor sets.\n");
 
+  descAlloc.descriptorPool = getDescriptorPool();
+
   /*
 	Set up the skybox descriptor sets.
 	*/
@@ -832,15 +2485,16 @@ void vkeGameRendererDynamic::initDescriptorSets()
 	Scene layout bindings (set 0)
 	Binding 0:		Environment Cube Map
 	Binding 1:		Camera Matrix
-	Binding 2:		Model Matrix
+	Binding 2:		Node Records (storage)
 	Binding 3:		Material
 	*/
 
   descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &cubeTexture, 0,
                      m_scene_descriptor_set);  //cubemap
-  descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &camInfo, VK_NULL_HANDLE, 0, m_scene_descriptor_set);  //Camera
-  descriptorSetWrite(&writes[2], 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &m_uniforms_descriptor, VK_NULL_HANDLE, 0,
-                     m_scene_descriptor_set);  //modelview
+  descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &camInfo, VK_NULL_HANDLE, 0,
+                     m_scene_descriptor_set);  //Camera
+  descriptorSetWrite(&writes[2], 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &m_uniforms_descriptor, VK_NULL_HANDLE, 0,
+                     m_scene_descriptor_set);  //node records
   descriptorSetWrite(&writes[3], 3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &material->getDescriptor(), VK_NULL_HANDLE, 0,
                      m_scene_descriptor_set);  //material
 
@@ -851,21 +2505,18 @@ void vkeGameRendererDynamic::initDescriptorSets()
 	Binding 0:		Transform
 	*/
 
-  descriptorSetWrite(&writes[4], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &m_transforms_descriptor, VK_NULL_HANDLE, 0,
+  descriptorSetWrite(&writes[4], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, &m_transforms_descriptor, VK_NULL_HANDLE, 0,
                      m_transform_descriptor_set);  //transform
-  vkUpdateDescriptorSets(device->getVKDevice(), 1, writes, 0, NULL);
+  descriptorSetWrite(&writes[5], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &m_visible_descriptor, VK_NULL_HANDLE, 0,
+                     m_transform_descriptor_set);  //visible lists
+  vkUpdateDescriptorSets(device->getVKDevice(), 2, &writes[4], 0, NULL);
 
 
   /*
 	Scene layout bindings (set 1)
 	Binding 0:		Scene texture array
 	*/
-  descriptorSetWrite(&writes[5], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, uint32_t(texCount), VK_NULL_HANDLE,
-                     texImageInfo, 0, m_texture_descriptor_sets[0]);  //cubemap
-
-  vkUpdateDescriptorSets(device->getVKDevice(), 6, writes, 0, NULL);
-  //Free the texture image info allocated earlier.
-  free(texImageInfo);
+  writeMaterialTextures(0, uint32_t(m_materials->count()));
 
 
   /*
@@ -875,7 +2526,8 @@ void vkeGameRendererDynamic::initDescriptorSets()
 	*/
 
   descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &cubeTexture, 0, m_quad_descriptor_set);
-  descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &camInfo, VK_NULL_HANDLE, 0, m_quad_descriptor_set);
+  descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &camInfo, VK_NULL_HANDLE, 0,
+                     m_quad_descriptor_set);
 
   vkUpdateDescriptorSets(device->getVKDevice(), 2, writes, 0, NULL);
 
@@ -889,7 +2541,8 @@ void vkeGameRendererDynamic::initDescriptorSets()
 
   descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &m_terrain_quad.getData().descriptor,
                      VK_NULL_HANDLE, 0, m_terrain_descriptor_set);
-  descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &camInfo, VK_NULL_HANDLE, 0, m_terrain_descriptor_set);
+  descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &camInfo, VK_NULL_HANDLE, 0,
+                     m_terrain_descriptor_set);
   descriptorSetWrite(&writes[2], 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &fpSampler, 0, m_terrain_descriptor_set);
   descriptorSetWrite(&writes[3], 3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &cubeTexture, 0,
                      m_terrain_descriptor_set);
@@ -897,15 +2550,123 @@ void vkeGameRendererDynamic::initDescriptorSets()
   vkUpdateDescriptorSets(device->getVKDevice(), 4, writes, 0, NULL);
 
 
-  /*----------------------------------------------------------
-	Initialise the terrain and scene command buffers.
-	----------------------------------------------------------*/
-  initTerrainCommand();
+  /*
+	Flight simulation bindings (compute)
+	Binding 0:		Flight records
+	Binding 1:		Transforms
+	*/
+  if(m_gpu_flight)
+  {
+    descAlloc.pSetLayouts        = &m_flight_descriptor_layout;
+    descAlloc.descriptorSetCount = 1;
 
-  for(uint32_t i = 0; i < m_max_draw_calls; ++i)
+    VKA_CHECK_ERROR(vkAllocateDescriptorSets(device->getVKDevice(), &descAlloc, &m_flight_descriptor_set),
+                    "Could not allocate descriptor sets.\n");
+
+    VkDescriptorBufferInfo flightInfo = {m_flight_buffer, 0, VK_WHOLE_SIZE};
+
+    descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &flightInfo, VK_NULL_HANDLE, 0, m_flight_descriptor_set);
+    descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &m_transforms_descriptor, VK_NULL_HANDLE, 0,
+                       m_flight_descriptor_set);
+
+    vkUpdateDescriptorSets(device->getVKDevice(), 2, writes, 0, NULL);
+  }
+
+  /*
+	Instance culling bindings (compute)
+	Binding 0:		Node records
+	Binding 1:		Transforms
+	Binding 2:		Visible instance lists
+	Binding 3:		Counts
+	Binding 4:		Indirect command templates
+	Binding 5:		Packed indirect commands
+	Binding 6:		Draw batch ends
+	*/
+  if(m_gpu_cull)
+  {
+    descAlloc.pSetLayouts        = &m_cull_descriptor_layout;
+    descAlloc.descriptorSetCount = 1;
+
+    VKA_CHECK_ERROR(vkAllocateDescriptorSets(device->getVKDevice(), &descAlloc, &m_cull_descriptor_set),
+                    "Could not allocate descriptor sets.\n");
+
+    VkDescriptorBufferInfo countInfo    = {m_cull_count_buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo templateInfo = {m_scene_indirect_buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo drawInfo     = {m_cull_draw_buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo batchInfo    = {m_cull_batch_buffer, 0, VK_WHOLE_SIZE};
+
+    descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &m_uniforms_descriptor, VK_NULL_HANDLE, 0,
+                       m_cull_descriptor_set);
+    descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, &m_transforms_descriptor, VK_NULL_HANDLE, 0,
+                       m_cull_descriptor_set);
+    descriptorSetWrite(&writes[2], 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &m_visible_descriptor, VK_NULL_HANDLE, 0,
+                       m_cull_descriptor_set);
+    descriptorSetWrite(&writes[3], 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &countInfo, VK_NULL_HANDLE, 0, m_cull_descriptor_set);
+    descriptorSetWrite(&writes[4], 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &templateInfo, VK_NULL_HANDLE, 0, m_cull_descriptor_set);
+    descriptorSetWrite(&writes[5], 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &drawInfo, VK_NULL_HANDLE, 0, m_cull_descriptor_set);
+    descriptorSetWrite(&writes[6], 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &batchInfo, VK_NULL_HANDLE, 0, m_cull_descriptor_set);
+
+    vkUpdateDescriptorSets(device->getVKDevice(), 7, writes, 0, NULL);
+  }
+
+  /*
+	Impostor bindings (set 0)
+	Binding 0:		Camera Uniforms
+	Binding 1:		Albedo atlas
+	Binding 2:		Normal atlas
+	*/
+  if(m_impostors)
   {
-    m_draw_calls[i]->initDescriptor();
+    descAlloc.pSetLayouts        = &m_impostor_descriptor_layout;
+    descAlloc.descriptorSetCount = 1;
+
+    VKA_CHECK_ERROR(vkAllocateDescriptorSets(device->getVKDevice(), &descAlloc, &m_impostor_descriptor_set),
+                    "Could not allocate descriptor sets.\n");
+
+    VkDescriptorImageInfo albedoInfo = {m_impostor_sampler, m_impostor_albedo_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkDescriptorImageInfo normalInfo = {m_impostor_sampler, m_impostor_normal_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+    descriptorSetWrite(&writes[0], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &camInfo, VK_NULL_HANDLE, 0,
+                       m_impostor_descriptor_set);
+    descriptorSetWrite(&writes[1], 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &albedoInfo, 0,
+                       m_impostor_descriptor_set);
+    descriptorSetWrite(&writes[2], 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_NULL_HANDLE, &normalInfo, 0,
+                       m_impostor_descriptor_set);
+
+    vkUpdateDescriptorSets(device->getVKDevice(), 3, writes, 0, NULL);
+  }
+}
+
+/*
+	Only the given slots are written, so with the
+	update after bind array the other slots can be
+	in use by frames in flight meanwhile.
+*/
+void vkeGameRendererDynamic::writeMaterialTextures(uint32_t inFirst, uint32_t inCount)
+{
+  if(inFirst + inCount > m_texture_slots)
+  {
+    LOGE("Materials up to %u exceed the %u texture slots, the rest are not bound.\n", inFirst + inCount, m_texture_slots);
+    inCount = inFirst < m_texture_slots ? m_texture_slots - inFirst : 0;
+  }
+
+  if(inCount == 0)
+    return;
+
+  std::vector<VkDescriptorImageInfo> texImageInfo(inCount);
+  for(uint32_t i = 0; i < inCount; ++i)
+  {
+    VkeMaterial*     mtrl       = m_materials->getMaterial(inFirst + i);
+    VkeTexture::Data texData    = mtrl->getTextures().getTexture(0)->getData();
+    texImageInfo[i].imageView   = texData.view;
+    texImageInfo[i].sampler     = texData.sampler;
+    texImageInfo[i].imageLayout = texData.imageLayout;
   }
+
+  VkWriteDescriptorSet write;
+  descriptorSetWrite(&write, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, inCount, VK_NULL_HANDLE, texImageInfo.data(), inFirst,
+                     m_texture_descriptor_sets[0]);
+  vkUpdateDescriptorSets(getDefaultDevice(), 1, &write, 0, NULL);
 }
 
 
@@ -962,11 +2723,13 @@ void vkeGameRendererDynamic::initPipeline()
   rasterStateInfo(&rasterState, VK_POLYGON_MODE_FILL);
 
   /*
-	Create the color blend state.
+	Create the color blend state. Opaque
+	first, blending is turned on for the
+	transparent pass below.
 	*/
   VkPipelineColorBlendAttachmentState attState[1];
   uint32_t                            sampleMask = 0xFF;
-  blendAttachmentStateN(1, attState);
+  blendAttachmentStateN(1, attState, VK_FALSE);
   blendStateInfo(&blendState, 1, attState);
 
   /*
@@ -992,6 +2755,37 @@ void vkeGameRendererDynamic::initPipeline()
   createShaderStage(&shaderStages[0], VK_SHADER_STAGE_VERTEX_BIT, m_shaders.scene_vertex);
   createShaderStage(&shaderStages[1], VK_SHADER_STAGE_FRAGMENT_BIT, m_shaders.scene_fragment);
 
+  /*
+	INSTANCE_FORMAT is constant_id 0 in std_vertex.glsl
+	and the compute shaders, INSTANCE_LIST constant_id 1
+	in std_vertex.glsl. The impostor fade band is
+	constant_id 2 and 3 in the scene and impostor
+	shaders, and 0 turns the fade off. The texture
+	array size is constant_id 4 in the fragment
+	shaders that read it, and the alpha test
+	cutoff constant_id 5 in std_fragment.glsl.
+	*/
+  struct
+  {
+    int32_t  format;
+    VkBool32 list;
+    float    impostorNear;
+    float    impostorFar;
+    int32_t  textureCount;
+    float    alphaCutoff;
+  } instanceConstants = {int32_t(m_instance_format), VkBool32(m_gpu_cull), m_impostor_near, m_impostor_far,
+                         int32_t(m_texture_slots), 0.0f};
+
+  VkSpecializationMapEntry instanceEntries[6] = {{0, 0, sizeof(int32_t)},
+                                                 {1, sizeof(int32_t), sizeof(VkBool32)},
+                                                 {2, sizeof(int32_t) + sizeof(VkBool32), sizeof(float)},
+                                                 {3, sizeof(int32_t) + sizeof(VkBool32) + sizeof(float), sizeof(float)},
+                                                 {4, sizeof(int32_t) + sizeof(VkBool32) + sizeof(float) * 2, sizeof(int32_t)},
+                                                 {5, sizeof(int32_t) * 2 + sizeof(VkBool32) + sizeof(float) * 2, sizeof(float)}};
+  VkSpecializationInfo     formatInfo         = {6, instanceEntries, sizeof(instanceConstants), &instanceConstants};
+  shaderStages[0].pSpecializationInfo         = &formatInfo;
+  shaderStages[1].pSpecializationInfo         = &formatInfo;
+
 
   /*
 	Create the graphics pipeline.
@@ -999,6 +2793,32 @@ void vkeGameRendererDynamic::initPipeline()
   graphicsPipelineCreate(&m_pipeline, &m_pipeline_cache, m_pipeline_layout, 2, shaderStages, &vertexState, &inputState,
                          &rasterState, &blendState, &multisampleState, &viewportState, &depthState, &m_render_pass, 0,
                          VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT);
+  m_pass_pipelines[VkeDrawKeys::PASS_OPAQUE] = m_pipeline;
+
+  /*
+	The alpha tested pipeline only differs in
+	the cutoff, so it gets its own constants.
+	*/
+  auto alphaTestConstants             = instanceConstants;
+  alphaTestConstants.alphaCutoff      = 0.5f;
+  VkSpecializationInfo alphaTestInfo  = {6, instanceEntries, sizeof(alphaTestConstants), &alphaTestConstants};
+  shaderStages[1].pSpecializationInfo = &alphaTestInfo;
+
+  graphicsPipelineCreate(&m_pass_pipelines[VkeDrawKeys::PASS_ALPHA_TEST], &m_pipeline_cache, m_pipeline_layout, 2, shaderStages,
+                         &vertexState, &inputState, &rasterState, &blendState, &multisampleState, &viewportState,
+                         &depthState, &m_render_pass, 0, VK_PIPELINE_CREATE_DERIVATIVE_BIT, m_pipeline);
+
+  /*
+	Transparent draws blend over what is already
+	there and test depth without writing it.
+	*/
+  shaderStages[1].pSpecializationInfo = &formatInfo;
+  blendAttachmentStateN(1, attState);
+  depthStateInfo(&depthState, VK_TRUE, VK_FALSE);
+
+  graphicsPipelineCreate(&m_pass_pipelines[VkeDrawKeys::PASS_TRANSPARENT], &m_pipeline_cache, m_pipeline_layout, 2,
+                         shaderStages, &vertexState, &inputState, &rasterState, &blendState, &multisampleState,
+                         &viewportState, &depthState, &m_render_pass, 0, VK_PIPELINE_CREATE_DERIVATIVE_BIT, m_pipeline);
 
   /*----------------------------------------------------------
 	Create the skybox pipeline.
@@ -1055,6 +2875,102 @@ void vkeGameRendererDynamic::initPipeline()
   graphicsPipelineCreate(&m_terrain_pipeline, &m_pipeline_cache, m_terrain_pipeline_layout, 4, shaderStages,
                          &vertexState, &inputState, &rasterState, &blendState, &multisampleState, &viewportState,
                          &depthState, &m_render_pass, 0, VK_PIPELINE_CREATE_DERIVATIVE_BIT, m_pipeline);
+
+  /*----------------------------------------------------------
+	Create the impostor pipelines.
+	----------------------------------------------------------*/
+  if(m_impostors)
+  {
+    /*
+		One quad per impostor, built in the vertex
+		shader from the vertex index.
+		*/
+    vertexStateInfo(&vertexState, 0, 0, NULL, NULL);
+    inputAssemblyStateInfo(&inputState, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+    rasterStateInfo(&rasterState, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE);
+
+    createShaderStage(&shaderStages[0], VK_SHADER_STAGE_VERTEX_BIT, m_shaders.impostor_vertex);
+    createShaderStage(&shaderStages[1], VK_SHADER_STAGE_FRAGMENT_BIT, m_shaders.impostor_fragment);
+    shaderStages[0].pSpecializationInfo = &formatInfo;
+
+    graphicsPipelineCreate(&m_impostor_pipeline, &m_pipeline_cache, m_impostor_pipeline_layout, 2, shaderStages,
+                           &vertexState, &inputState, &rasterState, &blendState, &multisampleState, &viewportState,
+                           &depthState, &m_render_pass);
+
+    /*
+		The bake draws the scene geometry into the two
+		single sampled atlas targets.
+		*/
+    vertexBinding(&binding, 0, sizeof(VertexObject), VK_VERTEX_INPUT_RATE_VERTEX);
+    vertexAttributef(&attrs[0], 0, binding.binding, VK_FORMAT_R32G32B32A32_SFLOAT, 0);
+    vertexAttributef(&attrs[1], 1, binding.binding, VK_FORMAT_R32G32B32A32_SFLOAT, 4);
+    vertexStateInfo(&vertexState, 1, 2, &binding, attrs);
+    inputAssemblyStateInfo(&inputState, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE);
+    rasterStateInfo(&rasterState, VK_POLYGON_MODE_FILL);
+
+    VkPipelineColorBlendAttachmentState bakeAttState[2];
+    blendAttachmentStateN(2, bakeAttState, VK_FALSE);
+    blendStateInfo(&blendState, 2, bakeAttState);
+    multisampleStateInfo(&multisampleState, VK_SAMPLE_COUNT_1_BIT, &sampleMask);
+
+    createShaderStage(&shaderStages[0], VK_SHADER_STAGE_VERTEX_BIT, m_shaders.impostor_bake_vertex);
+    createShaderStage(&shaderStages[1], VK_SHADER_STAGE_FRAGMENT_BIT, m_shaders.impostor_bake_fragment);
+    shaderStages[1].pSpecializationInfo = &formatInfo;
+
+    graphicsPipelineCreate(&m_impostor_bake_pipeline, &m_pipeline_cache, m_impostor_bake_pipeline_layout, 2, shaderStages,
+                           &vertexState, &inputState, &rasterState, &blendState, &multisampleState, &viewportState,
+                           &depthState, &m_impostor_render_pass);
+  }
+
+  /*----------------------------------------------------------
+	Create the flight simulation pipeline.
+	----------------------------------------------------------*/
+  if(m_gpu_flight)
+  {
+    VkComputePipelineCreateInfo computeInfo = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    createShaderStage(&computeInfo.stage, VK_SHADER_STAGE_COMPUTE_BIT, m_shaders.flight_compute);
+    computeInfo.stage.pSpecializationInfo = &formatInfo;
+    computeInfo.layout                    = m_flight_pipeline_layout;
+
+    VKA_CHECK_ERROR(vkCreateComputePipelines(device->getVKDevice(), m_pipeline_cache, 1, &computeInfo, NULL, &m_flight_pipeline),
+                    "Could not create flight simulation pipeline.\n");
+  }
+
+  /*----------------------------------------------------------
+	Create the instance culling pipeline.
+	----------------------------------------------------------*/
+  if(m_gpu_cull)
+  {
+    VkComputePipelineCreateInfo computeInfo = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    createShaderStage(&computeInfo.stage, VK_SHADER_STAGE_COMPUTE_BIT,
+                      m_occlusion_cull ? m_shaders.occlusion_cull : m_shaders.instance_cull);
+    computeInfo.stage.pSpecializationInfo = &formatInfo;
+    computeInfo.layout                    = m_cull_pipeline_layout;
+
+    VKA_CHECK_ERROR(vkCreateComputePipelines(device->getVKDevice(), m_pipeline_cache, 1, &computeInfo, NULL, &m_cull_pipeline),
+                    "Could not create instance culling pipeline.\n");
+  }
+
+  /*----------------------------------------------------------
+	Create the depth pyramid pipeline.
+	----------------------------------------------------------*/
+  if(m_occlusion_cull)
+  {
+    VkComputePipelineCreateInfo computeInfo = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    createShaderStage(&computeInfo.stage, VK_SHADER_STAGE_COMPUTE_BIT, m_shaders.hiz_build);
+    computeInfo.layout = m_hiz_pipeline_layout;
+
+    VKA_CHECK_ERROR(vkCreateComputePipelines(device->getVKDevice(), m_pipeline_cache, 1, &computeInfo, NULL, &m_hiz_pipeline),
+                    "Could not create depth pyramid pipeline.\n");
+  }
+
+  /*
+	New pipelines may reuse old handles.
+	*/
+  for(auto& drawCall : m_draw_calls)
+  {
+    drawCall->invalidate();
+  }
 }
 
 
@@ -1103,6 +3019,53 @@ void vkeGameRendererDynamic::initRenderPass()
 	Create the render pass.
 	*/
   renderPassCreate(&m_render_pass, 3, attachments, 1, subpass);  // , 1, &dep);
+
+  /*
+	The second occlusion pass draws over the first,
+	so it loads color and depth. Only the load ops
+	differ, so it works with the same framebuffers.
+	*/
+  if(m_occlusion_cull)
+  {
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    renderPassCreate(&m_occlusion_render_pass, 3, attachments, 1, subpass);
+  }
+
+  /*
+	The impostor bake renders albedo and normals
+	single sampled and leaves both ready for the
+	mip chain blits.
+	*/
+  if(m_impostors)
+  {
+    VkAttachmentDescription bakeAttachments[3];
+    attachmentDescription(&bakeAttachments[0], VK_FORMAT_R8G8B8A8_UNORM, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR,
+                          VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    attachmentDescription(&bakeAttachments[1], VK_FORMAT_R8G8B8A8_UNORM, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR,
+                          VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    depthStencilAttachmentDescription(&bakeAttachments[2], VK_FORMAT_D24_UNORM_S8_UINT, VK_SAMPLE_COUNT_1_BIT,
+                                      VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_UNDEFINED);
+
+    VkAttachmentReference bakeColorReferences[2] = {{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+                                                    {1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL}};
+    VkAttachmentReference bakeDepthReference     = {2, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    VkSubpassDescription bakeSubpass;
+    subpassDescription(&bakeSubpass, 2, bakeColorReferences, &bakeDepthReference);
+
+    VkSubpassDependency bakeDependency = {0,
+                                          VK_SUBPASS_EXTERNAL,
+                                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                          VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                          VK_ACCESS_TRANSFER_READ_BIT,
+                                          0};
+
+    renderPassCreate(&m_impostor_render_pass, 3, bakeAttachments, 1, &bakeSubpass, 1, &bakeDependency);
+
+    initImpostors();
+  }
 }
 
 void vkeGameRendererDynamic::initFramebuffer(uint32_t inWidth, uint32_t inHeight)
@@ -1123,7 +3086,7 @@ void vkeGameRendererDynamic::initFramebuffer(uint32_t inWidth, uint32_t inHeight
   /*
 	If framebuffers already exist, release them.
 	*/
-  if(m_framebuffers[0] != VK_NULL_HANDLE)
+  if(m_frames[0].m_framebuffer != VK_NULL_HANDLE)
   {
     releaseFramebuffer();
   }
@@ -1142,12 +3105,18 @@ void vkeGameRendererDynamic::initFramebuffer(uint32_t inWidth, uint32_t inHeight
   /*
 	Create the depth attachment image and image view.
 	*/
+  VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  if(m_occlusion_cull)
+    depthUsage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+
   m_depth_attachment.format = depthFmt;
   imageCreateAndBind(&m_depth_attachment.image, &m_depth_attachment.memory, depthFmt, VK_IMAGE_TYPE_2D, m_width,
-                     m_height, 1, 1, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-                     VK_IMAGE_TILING_OPTIMAL, getSamples());
+                     m_height, 1, 1, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthUsage, VK_IMAGE_TILING_OPTIMAL, getSamples());
   imageViewCreate(&m_depth_attachment.view, m_depth_attachment.image, VK_IMAGE_VIEW_TYPE_2D, depthFmt, VK_IMAGE_ASPECT_DEPTH_BIT);
 
+  if(m_occlusion_cull)
+    initHiZ();
+
   /*
 	Create the color attachment image and image view.
 	*/
@@ -1160,13 +3129,15 @@ void vkeGameRendererDynamic::initFramebuffer(uint32_t inWidth, uint32_t inHeight
   /*
 	Create the resolve attachment image and image view.
 	*/
-  for(uint32_t i = 0; i < 2; ++i)
+  for(uint32_t i = 0; i < m_frame_count; ++i)
   {
-    m_resolve_attachment[i].format = colorFmt;
-    imageCreateAndBind(&m_resolve_attachment[i].image, &m_resolve_attachment[i].memory, colorFmt, VK_IMAGE_TYPE_2D,
+    ColorImageView& resolve = m_frames[i].m_resolve_attachment;
+
+    resolve.format = colorFmt;
+    imageCreateAndBind(&resolve.image, &resolve.memory, colorFmt, VK_IMAGE_TYPE_2D,
                        m_width, m_height, 1, 1, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                        gBufferUsage | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT);
-    imageViewCreate(&m_resolve_attachment[i].view, m_resolve_attachment[i].image, VK_IMAGE_VIEW_TYPE_2D, colorFmt);
+    imageViewCreate(&resolve.view, resolve.image, VK_IMAGE_VIEW_TYPE_2D, colorFmt);
   }
 
   /* Start a small command buffer to set the layouts of the images to their correct values. */
@@ -1185,10 +3156,41 @@ void vkeGameRendererDynamic::initFramebuffer(uint32_t inWidth, uint32_t inHeight
                    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
     imageSetLayout(&cmd, m_color_attachment.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    imageSetLayout(&cmd, m_resolve_attachment[0].image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-                   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    imageSetLayout(&cmd, m_resolve_attachment[1].image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-                   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    for(uint32_t i = 0; i < m_frame_count; ++i)
+    {
+      imageSetLayout(&cmd, m_frames[i].m_resolve_attachment.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    }
+
+    /*
+		The pyramid stays in the general layout. It
+		starts out at the far plane so the first frame
+		hides nothing.
+		*/
+    if(m_occlusion_cull)
+    {
+      VkImageSubresourceRange hizRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_hiz_levels, 0, 1};
+
+      VkImageMemoryBarrier hizBarrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+      hizBarrier.srcAccessMask        = 0;
+      hizBarrier.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+      hizBarrier.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+      hizBarrier.newLayout            = VK_IMAGE_LAYOUT_GENERAL;
+      hizBarrier.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+      hizBarrier.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+      hizBarrier.image                = m_hiz_image;
+      hizBarrier.subresourceRange     = hizRange;
+      vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &hizBarrier);
+
+      VkClearColorValue farDepth = {{1.0f, 1.0f, 1.0f, 1.0f}};
+      vkCmdClearColorImage(cmd, m_hiz_image, VK_IMAGE_LAYOUT_GENERAL, &farDepth, 1, &hizRange);
+
+      hizBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      hizBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      hizBarrier.oldLayout     = VK_IMAGE_LAYOUT_GENERAL;
+      vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1,
+                           &hizBarrier);
+    }
     VKA_CHECK_ERROR(vkEndCommandBuffer(cmd), "Could not end command buffer.");
     VkSubmitInfo subInfo       = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
     subInfo.commandBufferCount = 1;
@@ -1205,9 +3207,9 @@ void vkeGameRendererDynamic::initFramebuffer(uint32_t inWidth, uint32_t inHeight
   /*
 	Setup the framebuffer create info struct.
 	*/
-  for(uint32_t i = 0; i < 2; ++i)
+  for(uint32_t i = 0; i < m_frame_count; ++i)
   {
-    VkImageView             views[] = {m_color_attachment.view, m_depth_attachment.view, m_resolve_attachment[i].view};
+    VkImageView             views[] = {m_color_attachment.view, m_depth_attachment.view, m_frames[i].m_resolve_attachment.view};
     VkFramebufferCreateInfo fbInfo  = {VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
     fbInfo.renderPass               = m_render_pass;
     fbInfo.attachmentCount          = 3;
@@ -1217,9 +3219,10 @@ void vkeGameRendererDynamic::initFramebuffer(uint32_t inWidth, uint32_t inHeight
     fbInfo.layers                   = 1;
 
     /*
-		Create 2 framebuffers for ping pong.
+		One framebuffer per frame in flight.
 		*/
-    VKA_CHECK_ERROR(vkCreateFramebuffer(device->getVKDevice(), &fbInfo, NULL, &m_framebuffers[i]), "Could not create framebuffer.\n");
+    VKA_CHECK_ERROR(vkCreateFramebuffer(device->getVKDevice(), &fbInfo, NULL, &m_frames[i].m_framebuffer),
+                    "Could not create framebuffer.\n");
   }
 }
 
@@ -1230,13 +3233,14 @@ void vkeGameRendererDynamic::initTerrainCommand()
   VulkanDC::Device*        device = dc->getDefaultDevice();
   VulkanDC::Device::Queue* queue  = dc->getDefaultQueue();
 
-  for(uint32_t i = 0; i < 2; ++i)
+  for(uint32_t i = 0; i < m_frame_count; ++i)
   {
+    uint32_t frameOffset = getFrameOffset(i);
 
-    if(m_terrain_command[i] != VK_NULL_HANDLE)
+    if(m_frames[i].m_terrain_command != VK_NULL_HANDLE)
     {
-      vkFreeCommandBuffers(device->getVKDevice(), queue->getCommandPool(), 1, &m_terrain_command[i]);
-      m_terrain_command[i] = VK_NULL_HANDLE;
+      vkFreeCommandBuffers(device->getVKDevice(), queue->getCommandPool(), 1, &m_frames[i].m_terrain_command);
+      m_frames[i].m_terrain_command = VK_NULL_HANDLE;
     }
 
     {
@@ -1246,7 +3250,7 @@ void vkeGameRendererDynamic::initTerrainCommand()
       cmdBufInfo.commandPool                 = queue->getCommandPool();
       cmdBufInfo.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
 
-      VKA_CHECK_ERROR(vkAllocateCommandBuffers(device->getVKDevice(), &cmdBufInfo, &m_terrain_command[i]),
+      VKA_CHECK_ERROR(vkAllocateCommandBuffers(device->getVKDevice(), &cmdBufInfo, &m_frames[i].m_terrain_command),
                       "vkAllocateCommandBuffers failed");
 
       VkCommandBufferInheritanceInfo cmdInheritanceInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
@@ -1256,27 +3260,236 @@ void vkeGameRendererDynamic::initTerrainCommand()
       cmdBeginInfo.flags                                = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
       cmdBeginInfo.pInheritanceInfo                     = &cmdInheritanceInfo;
 
-      VKA_CHECK_ERROR(vkBeginCommandBuffer(m_terrain_command[i], &cmdBeginInfo), "vkBeginCommandBuffer failed");
+      VKA_CHECK_ERROR(vkBeginCommandBuffer(m_frames[i].m_terrain_command, &cmdBeginInfo), "vkBeginCommandBuffer failed");
 
       // TODO: Switch to using VkCommandBufferInheritanceViewportScissorInfoNV here
-      setDefaultViewportAndScissor(m_terrain_command[i], m_width, m_height);
-      vkCmdBindPipeline(m_terrain_command[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_quad_pipeline);
-      vkCmdBindDescriptorSets(m_terrain_command[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_quad_pipeline_layout, 0, 1,
-                              &m_quad_descriptor_set, 0, NULL);
-      m_screen_quad.bind(&m_terrain_command[i]);
-      m_screen_quad.draw(&m_terrain_command[i]);
+      setDefaultViewportAndScissor(m_frames[i].m_terrain_command, m_width, m_height);
+      vkCmdBindPipeline(m_frames[i].m_terrain_command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_quad_pipeline);
+      vkCmdBindDescriptorSets(m_frames[i].m_terrain_command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_quad_pipeline_layout, 0, 1,
+                              &m_quad_descriptor_set, 1, &frameOffset);
+      m_screen_quad.bind(&m_frames[i].m_terrain_command);
+      m_screen_quad.draw(&m_frames[i].m_terrain_command);
+
+      vkCmdBindPipeline(m_frames[i].m_terrain_command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_terrain_pipeline);
+
+      vkCmdBindDescriptorSets(m_frames[i].m_terrain_command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_terrain_pipeline_layout, 0, 1,
+                              &m_terrain_descriptor_set, 1, &frameOffset);
+
+      m_terrain_quad.bind(&m_frames[i].m_terrain_command);
+      m_terrain_quad.draw(&m_frames[i].m_terrain_command);
+
+      vkEndCommandBuffer(m_frames[i].m_terrain_command);
+    }
+  }
+}
+
+/*
+	Records the impostor draw for each framebuffer.
+	The count and first instance come from
+	m_impostor_indirect_buffer, so like the terrain
+	it only needs recording when the frame size or
+	the descriptor sets change, and once the chopper
+	sphere is known.
+*/
+void vkeGameRendererDynamic::initImpostorCommand()
+{
+  if(!m_impostors || m_impostor_bounds.w <= 0.0f)
+    return;
+
+  VulkanDC*                dc     = VulkanDC::Get();
+  VulkanDC::Device*        device = dc->getDefaultDevice();
+  VulkanDC::Device::Queue* queue  = dc->getDefaultQueue();
+
+  struct
+  {
+    glm::vec4 centerRadius;
+    uint32_t  grid;
+  } params = {m_impostor_bounds, IMPOSTOR_GRID};
+
+  VkDescriptorSet sets[2] = {m_impostor_descriptor_set, m_transform_descriptor_set};
+
+  for(uint32_t i = 0; i < m_frame_count; ++i)
+  {
+    if(m_frames[i].m_impostor_command != VK_NULL_HANDLE)
+    {
+      vkFreeCommandBuffers(device->getVKDevice(), queue->getCommandPool(), 1, &m_frames[i].m_impostor_command);
+      m_frames[i].m_impostor_command = VK_NULL_HANDLE;
+    }
+
+    VkCommandBufferAllocateInfo cmdBufInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    cmdBufInfo.commandBufferCount          = 1;
+    cmdBufInfo.commandPool                 = queue->getCommandPool();
+    cmdBufInfo.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+    VKA_CHECK_ERROR(vkAllocateCommandBuffers(device->getVKDevice(), &cmdBufInfo, &m_frames[i].m_impostor_command),
+                    "vkAllocateCommandBuffers failed");
+
+    VkCommandBufferInheritanceInfo cmdInheritanceInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+    cmdInheritanceInfo.renderPass                     = m_render_pass;
+    cmdInheritanceInfo.subpass                        = 0;
+    VkCommandBufferBeginInfo cmdBeginInfo             = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    cmdBeginInfo.flags                                = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    cmdBeginInfo.pInheritanceInfo                     = &cmdInheritanceInfo;
+
+    VKA_CHECK_ERROR(vkBeginCommandBuffer(m_frames[i].m_impostor_command, &cmdBeginInfo), "vkBeginCommandBuffer failed");
+
+    setDefaultViewportAndScissor(m_frames[i].m_impostor_command, m_width, m_height);
+    vkCmdBindPipeline(m_frames[i].m_impostor_command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_impostor_pipeline);
+    uint32_t offsets[2] = {getFrameOffset(i), getTransformsOffset(i)};
+    vkCmdBindDescriptorSets(m_frames[i].m_impostor_command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_impostor_pipeline_layout, 0, 2,
+                            sets, 2, offsets);
+    vkCmdPushConstants(m_frames[i].m_impostor_command, m_impostor_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                       sizeof(glm::vec4) + sizeof(uint32_t), &params);
+    vkCmdDrawIndirect(m_frames[i].m_impostor_command, m_impostor_indirect_buffer, 0, 1, sizeof(VkDrawIndirectCommand));
+
+    vkEndCommandBuffer(m_frames[i].m_impostor_command);
+  }
+}
+
+/*
+	Bakes the chopper into the impostor atlases, one
+	orthographic view per cell looking back along the
+	octahedral direction at the cell's centre, then
+	blits the mip chain. Recorded each frame until a
+	frame carrying it is submitted.
+*/
+void vkeGameRendererDynamic::recordImpostorBake(VkCommandBuffer inCmd)
+{
+  if(!m_impostors || m_impostors_baked)
+    return;
+
+  VulkanAppContext* ctxt = VulkanAppContext::GetInstance();
+
+  /*
+	The chopper's bounds are known once its nodes
+	have been updated. The quads are sized from
+	the same sphere, so record them now; nothing
+	has been submitted yet.
+	*/
+  if(m_impostor_bounds.w <= 0.0f)
+  {
+    AABB sceneBounds  = m_node_data->getBounds();
+    m_impostor_bounds = glm::vec4(sceneBounds.getCenter(), glm::length(sceneBounds.getExtent()));
+    initImpostorCommand();
+  }
+
+  const uint32_t atlasSize = IMPOSTOR_GRID * IMPOSTOR_TILE_SIZE;
+  glm::vec3      center    = glm::vec3(m_impostor_bounds);
+  float          radius    = m_impostor_bounds.w;
+
+  VkClearValue clearValues[3];
+  colorClearValues(&clearValues[0], 0.0, 0.0, 0.0, 0.0);
+  colorClearValues(&clearValues[1], 0.0, 0.0, 0.0, 0.0);
+  depthStencilClearValues(&clearValues[2]);
+
+  renderPassBegin(&inCmd, m_impostor_render_pass, m_impostor_framebuffer, 0, 0, atlasSize, atlasSize, clearValues, 3);
+
+  vkCmdBindPipeline(inCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_impostor_bake_pipeline);
+
+  VkDescriptorSet sets[2]     = {m_scene_descriptor_set, m_texture_descriptor_sets[0]};
+  uint32_t        frameOffset = getFrameOffset(m_current_buffer_index);
+  vkCmdBindDescriptorSets(inCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_impostor_bake_pipeline_layout, 0, 2, sets, 1, &frameOffset);
+
+  ctxt->getVBO()->bind(&inCmd);
+  ctxt->getIBO()->bind(&inCmd);
+
+  /*
+	y is flipped like the scene camera, so the
+	winding and the quad's v match.
+	*/
+  glm::mat4 projection = glm::orthoRH_ZO(-radius, radius, -radius, radius, 0.0f, radius * 2.0f);
+  projection[1][1] *= -1.0f;
+
+  for(uint32_t v = 0; v < IMPOSTOR_GRID; ++v)
+  {
+    for(uint32_t u = 0; u < IMPOSTOR_GRID; ++u)
+    {
+      glm::vec2 coord = (glm::vec2(float(u), float(v)) + 0.5f) / float(IMPOSTOR_GRID) * 2.0f - 1.0f;
+      glm::vec3 dir   = octahedralDecode(coord);
+      glm::vec3 up    = fabsf(dir.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+      glm::mat4 viewProj = projection * glm::lookAt(center + dir * radius, center, up);
+
+      VkViewport vp = {float(u * IMPOSTOR_TILE_SIZE), float(v * IMPOSTOR_TILE_SIZE), float(IMPOSTOR_TILE_SIZE),
+                       float(IMPOSTOR_TILE_SIZE), 0.0f, 1.0f};
+      VkRect2D   sc = {{int32_t(u * IMPOSTOR_TILE_SIZE), int32_t(v * IMPOSTOR_TILE_SIZE)}, {IMPOSTOR_TILE_SIZE, IMPOSTOR_TILE_SIZE}};
+      vkCmdSetViewport(inCmd, 0, 1, &vp);
+      vkCmdSetScissor(inCmd, 0, 1, &sc);
+      vkCmdPushConstants(inCmd, m_impostor_bake_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &viewProj);
+
+      for(size_t i = 0; i < m_indirect_commands.size(); ++i)
+      {
+        const VkDrawIndexedIndirectCommand& cmd = m_indirect_commands[i];
+        vkCmdDrawIndexed(inCmd, cmd.indexCount, 1, cmd.firstIndex, cmd.vertexOffset, uint32_t(i));
+      }
+    }
+  }
+
+  vkCmdEndRenderPass(inCmd);
+
+  /*
+	Both atlases leave the pass in the transfer
+	source layout. Each level is blitted from the
+	one above and becomes a source in turn, then
+	the whole chain goes to the fragment shader.
+	*/
+  VkImage atlases[2] = {m_impostor_albedo, m_impostor_normal};
 
-      vkCmdBindPipeline(m_terrain_command[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_terrain_pipeline);
+  VkImageMemoryBarrier barriers[2];
+  for(uint32_t i = 0; i < 2; ++i)
+  {
+    barriers[i]                     = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barriers[i].srcAccessMask       = 0;
+    barriers[i].dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[i].oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[i].newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[i].image               = atlases[i];
+    barriers[i].subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 1, IMPOSTOR_LEVELS - 1, 0, 1};
+  }
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 2, barriers);
 
-      vkCmdBindDescriptorSets(m_terrain_command[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_terrain_pipeline_layout, 0, 1,
-                              &m_terrain_descriptor_set, 0, NULL);
+  for(uint32_t level = 1; level < IMPOSTOR_LEVELS; ++level)
+  {
+    int32_t srcSize = int32_t(atlasSize >> (level - 1));
+    int32_t dstSize = int32_t(atlasSize >> level);
 
-      m_terrain_quad.bind(&m_terrain_command[i]);
-      m_terrain_quad.draw(&m_terrain_command[i]);
+    VkImageBlit blit    = {};
+    blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+    blit.srcOffsets[1]  = {srcSize, srcSize, 1};
+    blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+    blit.dstOffsets[1]  = {dstSize, dstSize, 1};
 
-      vkEndCommandBuffer(m_terrain_command[i]);
+    for(uint32_t i = 0; i < 2; ++i)
+    {
+      vkCmdBlitImage(inCmd, atlases[i], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, atlases[i],
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+      barriers[i].srcAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barriers[i].dstAccessMask    = VK_ACCESS_TRANSFER_READ_BIT;
+      barriers[i].oldLayout        = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barriers[i].newLayout        = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      barriers[i].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
     }
+    vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 2, barriers);
+  }
+
+  for(uint32_t i = 0; i < 2; ++i)
+  {
+    barriers[i].srcAccessMask    = VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[i].dstAccessMask    = VK_ACCESS_SHADER_READ_BIT;
+    barriers[i].oldLayout        = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barriers[i].newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[i].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, IMPOSTOR_LEVELS, 0, 1};
   }
+  vkCmdPipelineBarrier(inCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 2, barriers);
+
+  /*
+	The first frame is recorded but not submitted.
+	*/
+  if(!m_is_first_frame)
+    m_impostors_baked = true;
 }
 
 void vkeGameRendererDynamic::initCamera()
@@ -1293,11 +3506,18 @@ void vkeGameRendererDynamic::initCamera()
 
 void vkeGameRendererDynamic::initDrawCalls()
 {
-  m_max_draw_calls = 1;
+  m_max_draw_calls = std::min(m_thread_pool.getThreadCount(), uint32_t(MAX_DRAW_CALLS));
+
+  for(uint32_t i = 0; i < m_frame_count; ++i)
+  {
+    m_frames[i].init(m_max_draw_calls);
+  }
+
   m_draw_calls.resize(m_max_draw_calls);
+  m_secondary_commands.reserve(m_max_draw_calls + 2);
   for(uint32_t i = 0; i < m_max_draw_calls; ++i)
   {
-    m_draw_calls[i] = std::make_unique<VkeDrawCall>(this);
+    m_draw_calls[i] = std::make_unique<VkeDrawCall>(this, i);
   }
 }
 
@@ -1313,13 +3533,56 @@ void vkeGameRendererDynamic::generateDrawCommands()
   colorClearValues(&clearValues[2], 0.0, 0.0, 0.0);
 
   /*
-	Dispatch threads to create the secondary
-	command buffers.
+	update() already waited for this frame's last
+	submit, so its primary pool can be reset.
 	*/
-  m_calls_generated = 0;
-  for(uint32_t i = 0; i < m_max_draw_calls; ++i)
+  VkeFrameContext& frame = m_frames[m_current_buffer_index];
+  VkCommandBuffer  cmd   = frame.begin();
+  m_stats.fence_wait_ms  = frame.getWaitMs();
+
+  /*
+	Split the nodes into one contiguous slice per
+	draw call and record the slices on the thread
+	pool. run() returns once every slice is done,
+	so the secondaries are complete before the
+	primary executes them.
+	*/
+  uint32_t nodeCount  = uint32_t(m_node_data->count());
+  uint32_t sliceSize  = (nodeCount + m_max_draw_calls - 1) / m_max_draw_calls;
+  uint32_t sliceCount = sliceSize > 0 ? (nodeCount + sliceSize - 1) / sliceSize : 0;
+
+  std::atomic<uint32_t> rerecorded(0);
+
+  /*
+	The draw benchmark records every slice each
+	frame, so the time below is the full cost.
+	*/
+  if(m_draw_benchmark)
+  {
+    for(uint32_t i = 0; i < sliceCount; ++i)
+    {
+      m_draw_calls[i]->invalidate();
+    }
+  }
+
+  typedef std::chrono::high_resolution_clock Clock;
+
+  Clock::time_point recordStart = Clock::now();
+
+  m_thread_pool.run(sliceCount, [&](uint32_t inSlice) {
+    uint32_t first = inSlice * sliceSize;
+    if(m_draw_calls[inSlice]->initDrawCommands(first, std::min(sliceSize, nodeCount - first), m_current_buffer_index,
+                                               m_render_pass, m_width, m_height))
+      ++rerecorded;
+  });
+
+  m_stats.record_ms           = std::chrono::duration<float, std::milli>(Clock::now() - recordStart).count();
+  m_stats.scene_draws         = nodeCount;
+  m_stats.rerecorded_commands = rerecorded;
+  m_stats.pipeline_binds      = 0;
+  for(uint32_t i = 0; i < sliceCount; ++i)
   {
-    m_draw_calls[i]->initDrawCommands(uint32_t(m_node_data->count()), m_current_buffer_index, m_render_pass, m_width, m_height);
+    m_stats.pipeline_binds += m_draw_calls[i]->getPipelineBinds(m_current_buffer_index);
   }
 
   /*
@@ -1328,35 +3591,45 @@ void vkeGameRendererDynamic::generateDrawCommands()
   VkCommandBufferBeginInfo cmdBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
   cmdBeginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-  VkCommandBuffer cmd = m_primary_commands[m_current_buffer_index];
-  VKA_CHECK_ERROR(vkResetCommandBuffer(cmd, 0), "Could not reset primary command buffer");
   VKA_CHECK_ERROR(vkBeginCommandBuffer(cmd, &cmdBeginInfo), "Could not begin primary command buffer.\n");
 
-  size_t       cnt = m_node_data->count();
-  VkDeviceSize sz  = (sizeof(VkeNodeUniform) * cnt) + (m_instance_count * 64);
-  vkCmdUpdateBuffer(cmd, m_uniforms_buffer, 0, sz, (const uint32_t*)m_uniforms_local);
-  m_camera->updateCameraCmd(cmd);
+  recordUploads(cmd);
+  recordFlightSimulation(cmd);
+  recordGPUCulling(cmd);
+  recordInstanceCounts(cmd);
+  recordImpostorBake(cmd);
 
+  readTimestamps();
 
-  renderPassBegin(&cmd, m_render_pass, m_framebuffers[m_current_buffer_index], 0, 0, m_width, m_height, clearValues, 3,
-                  VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+  if(m_timestamp_pool != VK_NULL_HANDLE)
+  {
+    vkCmdResetQueryPool(cmd, m_timestamp_pool, m_current_buffer_index * 4, 4);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_pool, m_current_buffer_index * 4);
+  }
 
+  renderPassBegin(&cmd, m_render_pass, frame.m_framebuffer, 0, 0, m_width, m_height, clearValues, 3,
+                  VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-  /*
-	Wait here until the secondary commands are ready.
-	*/
 
-  VkCommandBuffer secondaryCommands[11];
-  secondaryCommands[0] = m_terrain_command[m_current_buffer_index];
-  for(uint32_t i = 0; i < m_max_draw_calls; ++i)
+  m_secondary_commands.clear();
+  m_secondary_commands.push_back(frame.m_terrain_command);
+  for(uint32_t i = 0; i < sliceCount; ++i)
   {
-    secondaryCommands[i + 1] = m_draw_calls[i]->getDrawCommand(m_current_buffer_index);
+    m_secondary_commands.push_back(m_draw_calls[i]->getDrawCommand(m_current_buffer_index));
   }
+  if(m_impostors)
+    m_secondary_commands.push_back(frame.m_impostor_command);
+
+
+  vkCmdExecuteCommands(cmd, uint32_t(m_secondary_commands.size()),
+                       m_secondary_commands.data());
 
+  vkCmdEndRenderPass(cmd);
 
-  vkCmdExecuteCommands(m_primary_commands[m_current_buffer_index], 1 + m_max_draw_calls, secondaryCommands);
+  if(m_timestamp_pool != VK_NULL_HANDLE)
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_pool, m_current_buffer_index * 4 + 1);
 
-  vkCmdEndRenderPass(m_primary_commands[m_current_buffer_index]);
+  recordOcclusionPass(cmd);
 
   VkImageResolve blitInfo;
   blitInfo.srcOffset.x                   = 0;
@@ -1379,18 +3652,18 @@ void vkeGameRendererDynamic::generateDrawCommands()
 
   imageSetLayout(&cmd, m_color_attachment.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-  imageSetLayout(&cmd, m_resolve_attachment[m_current_buffer_index].image, VK_IMAGE_ASPECT_COLOR_BIT,
+  imageSetLayout(&cmd, frame.m_resolve_attachment.image, VK_IMAGE_ASPECT_COLOR_BIT,
                  VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-  vkCmdResolveImage(m_primary_commands[m_current_buffer_index], m_color_attachment.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    m_resolve_attachment[m_current_buffer_index].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blitInfo);
+  vkCmdResolveImage(cmd, m_color_attachment.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    frame.m_resolve_attachment.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blitInfo);
 
   imageSetLayout(&cmd, m_color_attachment.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                  VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-  imageSetLayout(&cmd, m_resolve_attachment[m_current_buffer_index].image, VK_IMAGE_ASPECT_COLOR_BIT,
+  imageSetLayout(&cmd, frame.m_resolve_attachment.image, VK_IMAGE_ASPECT_COLOR_BIT,
                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 
-  VKA_CHECK_ERROR(vkEndCommandBuffer(m_primary_commands[m_current_buffer_index]), "Could not end command buffer for draw command.\n");
+  VKA_CHECK_ERROR(vkEndCommandBuffer(cmd), "Could not end command buffer for draw command.\n");
 }
 
 
@@ -1398,8 +3671,21 @@ void vkeGameRendererDynamic::initShaders(nvvk::ShaderModuleManager& inShaderModu
 {
   VulkanAppContext* ctxt = VulkanAppContext::GetInstance();
 
-  m_shaders.scene_vertex   = inShaderModuleManager.get(ctxt->getModuleIDs().scene_vs);
-  m_shaders.scene_fragment = inShaderModuleManager.get(ctxt->getModuleIDs().scene_fs);
+  /*
+	The draw parameters variant finds each draw's
+	node without the per vertex divide. The
+	bindless variants index the partially bound
+	material texture array.
+	*/
+  if(VulkanDC::Get()->getDefaultDevice()->hasShaderDrawParameters())
+    m_shaders.scene_vertex = inShaderModuleManager.get(ctxt->getModuleIDs().scene_draw_params_vs);
+  else
+    m_shaders.scene_vertex = inShaderModuleManager.get(ctxt->getModuleIDs().scene_vs);
+
+  if(m_bindless_textures)
+    m_shaders.scene_fragment = inShaderModuleManager.get(ctxt->getModuleIDs().scene_bindless_fs);
+  else
+    m_shaders.scene_fragment = inShaderModuleManager.get(ctxt->getModuleIDs().scene_fs);
 
   m_shaders.quad_vertex   = inShaderModuleManager.get(ctxt->getModuleIDs().scene_quad_vs);
   m_shaders.quad_fragment = inShaderModuleManager.get(ctxt->getModuleIDs().scene_quad_fs);
@@ -1408,6 +3694,20 @@ void vkeGameRendererDynamic::initShaders(nvvk::ShaderModuleManager& inShaderModu
   m_shaders.terrain_fragment = inShaderModuleManager.get(ctxt->getModuleIDs().scene_terrain_fs);
   m_shaders.terrain_tcs      = inShaderModuleManager.get(ctxt->getModuleIDs().scene_terrain_tcs);
   m_shaders.terrain_tes      = inShaderModuleManager.get(ctxt->getModuleIDs().scene_terrain_tes);
+
+  m_shaders.flight_compute = inShaderModuleManager.get(ctxt->getModuleIDs().flight_cs);
+  m_shaders.instance_cull  = inShaderModuleManager.get(ctxt->getModuleIDs().cull_cs);
+  m_shaders.occlusion_cull = inShaderModuleManager.get(ctxt->getModuleIDs().occlusion_cs);
+  m_shaders.hiz_build      = inShaderModuleManager.get(ctxt->getModuleIDs().hiz_cs);
+
+  m_shaders.impostor_vertex        = inShaderModuleManager.get(ctxt->getModuleIDs().impostor_vs);
+  m_shaders.impostor_fragment      = inShaderModuleManager.get(ctxt->getModuleIDs().impostor_fs);
+  m_shaders.impostor_bake_vertex   = inShaderModuleManager.get(ctxt->getModuleIDs().impostor_bake_vs);
+
+  if(m_bindless_textures)
+    m_shaders.impostor_bake_fragment = inShaderModuleManager.get(ctxt->getModuleIDs().impostor_bake_bindless_fs);
+  else
+    m_shaders.impostor_bake_fragment = inShaderModuleManager.get(ctxt->getModuleIDs().impostor_bake_fs);
 }
 
 
@@ -1421,38 +3721,38 @@ void vkeGameRendererDynamic::releaseFramebuffer()
 
   vkDestroyImageView(device->getVKDevice(), m_depth_attachment.view, NULL);
   vkDestroyImageView(device->getVKDevice(), m_color_attachment.view, NULL);
-  vkDestroyImageView(device->getVKDevice(), m_resolve_attachment[0].view, NULL);
-  vkDestroyImageView(device->getVKDevice(), m_resolve_attachment[1].view, NULL);
 
-  m_depth_attachment.view      = NULL;
-  m_color_attachment.view      = NULL;
-  m_resolve_attachment[0].view = NULL;
-  m_resolve_attachment[1].view = NULL;
+  m_depth_attachment.view = NULL;
+  m_color_attachment.view = NULL;
 
   vkDestroyImage(device->getVKDevice(), m_depth_attachment.image, NULL);
   vkDestroyImage(device->getVKDevice(), m_color_attachment.image, NULL);
-  vkDestroyImage(device->getVKDevice(), m_resolve_attachment[0].image, NULL);
-  vkDestroyImage(device->getVKDevice(), m_resolve_attachment[1].image, NULL);
 
-  m_depth_attachment.image      = NULL;
-  m_color_attachment.image      = NULL;
-  m_resolve_attachment[0].image = NULL;
-  m_resolve_attachment[1].image = NULL;
+  m_depth_attachment.image = NULL;
+  m_color_attachment.image = NULL;
 
   vkFreeMemory(device->getVKDevice(), m_depth_attachment.memory, NULL);
   vkFreeMemory(device->getVKDevice(), m_color_attachment.memory, NULL);
-  vkFreeMemory(device->getVKDevice(), m_resolve_attachment[0].memory, NULL);
-  vkFreeMemory(device->getVKDevice(), m_resolve_attachment[1].memory, NULL);
-
-  m_depth_attachment.memory      = NULL;
-  m_color_attachment.memory      = NULL;
-  m_resolve_attachment[0].memory = NULL;
-  m_resolve_attachment[1].memory = NULL;
-
-  vkDestroyFramebuffer(device->getVKDevice(), m_framebuffers[0], NULL);
-  vkDestroyFramebuffer(device->getVKDevice(), m_framebuffers[1], NULL);
-  m_framebuffers[0] = NULL;
-  m_framebuffers[1] = NULL;
+
+  m_depth_attachment.memory = NULL;
+  m_color_attachment.memory = NULL;
+
+  for(uint32_t i = 0; i < m_frame_count; ++i)
+  {
+    ColorImageView& resolve = m_frames[i].m_resolve_attachment;
+
+    vkDestroyImageView(device->getVKDevice(), resolve.view, NULL);
+    vkDestroyImage(device->getVKDevice(), resolve.image, NULL);
+    vkFreeMemory(device->getVKDevice(), resolve.memory, NULL);
+    resolve.view   = NULL;
+    resolve.image  = NULL;
+    resolve.memory = NULL;
+
+    vkDestroyFramebuffer(device->getVKDevice(), m_frames[i].m_framebuffer, NULL);
+    m_frames[i].m_framebuffer = NULL;
+  }
+
+  releaseHiZ();
 }
 
 void vkeGameRendererDynamic::setCameraLookAt(glm::mat4& inMat)
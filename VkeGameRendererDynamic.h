@@ -21,101 +21,92 @@
 
 #pragma once
 
+#include "Bounds.h"
 #include "VkeCubeTexture.h"
+#include "VkeDrawKeys.h"
+#include "VkeFlightPaths.h"
+#include "VkeFrameContext.h"
 #include "VkeMaterial.h"
 #include "VkeRenderer.h"
 #include "VkeScreenQuad.h"
 #include "VkeTerrainQuad.h"
+#include "VkeThreadPool.h"
 
 #include <memory>
 #include <stdint.h>
 
 class VkeCamera;
 
-#define COMMAND_BUFFER_COUNT 2
-
-struct FlightPath
-{
-
-  glm::vec2 m_start_position;
-  glm::vec2 m_end_position;
-  glm::vec2 m_position;
-  glm::vec2 m_direction;
-  glm::vec2 m_range{};
-  float     m_t;
-
-  float m_velocity;
-  float m_altitude;
-
-  FlightPath()
-      : m_start_position(0.0, 0.0)
-      , m_end_position(0.0, 0.0)
-      , m_position(0.0, 0.0)
-      , m_direction(0.0, 1.0)
-      , m_velocity(0.06f)
-      , m_altitude(10.0f)
-      , m_t(0.0f)
-  {
-  }
-
-  FlightPath(glm::vec2& initialPosition, glm::vec2& endPosition, float startT = 0.0, float inAltitude = 10, float inVelocity = 0.06)
-      : m_start_position(initialPosition)
-      , m_end_position(endPosition)
-      , m_position(0.0, 0.0)
-      , m_velocity(inVelocity)
-      , m_altitude(inAltitude)
-  {
-
-    m_t         = startT;
-    m_range     = m_end_position - m_start_position;
-    m_direction = glm::normalize(m_range);
-  }
-
-  ~FlightPath() {}
-
-  void update(glm::mat4* inMat, float deltaTime)
-  {
-    m_t = fmodf(m_t + m_velocity * deltaTime, 1.f);
-
-    m_position = (m_range * m_t) + m_start_position;
-
-    float yRot = atan2(m_range.x, m_range.y);
-
-    glm::mat4 translation(1);
-    translation = glm::translate(translation, glm::vec3(m_position.x, m_altitude, m_position.y));
-
-    glm::mat4 rotation(1);
-    rotation = glm::rotate(rotation, yRot, glm::vec3(0.0, 1.0, 0.0));
-    rotation = glm::rotate(rotation, glm::radians(-90.f), glm::vec3(1.0, 0.0, 0.0));
-    *inMat   = translation * rotation;
-  }
-};
-
 class vkeGameRendererDynamic;
 
 class VkeDrawCall
 {
 public:
-  VkeDrawCall(vkeGameRendererDynamic* inRenderer);
+  VkeDrawCall(vkeGameRendererDynamic* inRenderer, uint32_t inThread);
   ~VkeDrawCall();
 
   VkCommandBuffer getDrawCommand(const uint32_t inFrameIndex);
 
-  void initDescriptorPool();
-  void initDescriptor();
-  void initCommandPool();
-  void initDrawCommands(const uint32_t inCount, const uint32_t inBufferIndex, VkRenderPass parentRenderPass, uint32_t viewportWidth, uint32_t viewportHeight);
+  void initCommandBuffers();
+
+  /*
+		Records inCount node draws starting at
+		inFirst. Only touches this call's pools, so
+		calls can record on different threads. The
+		buffer is kept while nothing it was recorded
+		against changes; returns true if it was
+		recorded again.
+	*/
+  bool initDrawCommands(const uint32_t inFirst,
+                        const uint32_t inCount,
+                        const uint32_t inBufferIndex,
+                        VkRenderPass   parentRenderPass,
+                        uint32_t       viewportWidth,
+                        uint32_t       viewportHeight);
+
+  /*
+		Forces every buffer to be recorded again,
+		for changes the handles do not show.
+	*/
+  void invalidate();
+
+  /*
+		Pipelines bound by the buffer for inFrameIndex,
+		one per draw batch it touches.
+	*/
+  uint32_t getPipelineBinds(const uint32_t inFrameIndex) const { return m_pipeline_binds[inFrameIndex]; }
 
 private:
+  /*
+		Everything a recorded buffer depends on.
+		Handles can be reused after a destroy, so
+		rebuilds also call invalidate().
+	*/
+  struct RecordState
+  {
+    VkPipeline       pipeline    = VK_NULL_HANDLE;
+    VkPipelineLayout layout      = VK_NULL_HANDLE;
+    VkDescriptorSet  sets[3]     = {};
+    uint32_t         offsets[2]  = {};
+    VkRenderPass     render_pass = VK_NULL_HANDLE;
+    VkBuffer         indirect    = VK_NULL_HANDLE;
+    uint32_t         first       = 0;
+    uint32_t         count       = 0;
+    uint32_t         width       = 0;
+    uint32_t         height      = 0;
+
+    bool operator==(const RecordState& inOther) const;
+  };
+
   vkeGameRendererDynamic* m_renderer;
-  VkDescriptorSet         m_transform_descriptor_set;
-  VkDescriptorPool        m_descriptor_pool;
-  VkCommandBuffer         m_draw_command[COMMAND_BUFFER_COUNT];
-  VkCommandPool           m_command_pool;
+  uint32_t                m_thread;
+  RecordState             m_recorded[MAX_FRAMES_IN_FLIGHT];
+  VkCommandBuffer         m_draw_command[MAX_FRAMES_IN_FLIGHT];
+  uint32_t                m_pipeline_binds[MAX_FRAMES_IN_FLIGHT]{};
 
   glm::mat4 m_draw_transform;
 
-  bool m_buffer_ready;
+  bool m_buffer_ready[MAX_FRAMES_IN_FLIGHT];
 };
 
 class vkeGameRendererDynamic : public VkeRenderer
@@ -141,11 +132,12 @@ public:
   void generateDrawCommands();
 
   void           setNodeData(VkeNodeData::List* inData);
+  void           setIndirectCommands(const VkDrawIndexedIndirectCommand* inCommands) { m_cached_commands = inCommands; }
   void           setMaterialData(VkeMaterial::List* inData);
   virtual size_t getRequiredDescriptorCount();
 
   void         initCamera();
-  virtual void update();
+  virtual void update(float inDeltaTime);
 
   virtual void present();
   virtual void initShaders(nvvk::ShaderModuleManager& inShaderModuleManager);
@@ -155,48 +147,378 @@ public:
 
   VkDescriptorSet* getTextureDescriptorSets() { return m_texture_descriptor_sets; }
 
+  /*
+		Writes the textures of materials inFirst to
+		inFirst + inCount - 1 into the texture array.
+		With bindless textures the array has room for
+		materials added after the layouts are built.
+	*/
+  void     writeMaterialTextures(uint32_t inFirst, uint32_t inCount);
+  uint32_t getTextureSlotCount() const { return m_texture_slots; }
+
   VkBuffer getSceneIndirectBuffer() { return m_scene_indirect_buffer; }
 
-  VkDescriptorSetLayout* getTransformDescriptorLayout() { return &m_transform_descriptor_layout; }
+  /*
+		Indirect buffer the scene draws read,
+		the cull output with GPU culling.
+	*/
+  VkBuffer getSceneDrawBuffer() { return m_gpu_cull ? m_cull_draw_buffer : m_scene_indirect_buffer; }
 
-  VkDescriptorBufferInfo* getTransformsDescriptor() { return &m_transforms_descriptor; }
+  VkDescriptorSet getTransformDescriptorSet() { return m_transform_descriptor_set; }
 
-  bool drawCallsReady() { return (m_calls_generated == m_max_draw_calls); }
+  /*
+		Dynamic offsets of inFrame's ring region for
+		the camera bindings, and for the transforms,
+		which is always 0 when the GPU writes them.
+	*/
+  uint32_t getFrameOffset(uint32_t inFrame) const { return uint32_t(m_frame_ring_stride * inFrame); }
+  uint32_t getTransformsOffset(uint32_t inFrame) const { return m_gpu_flight ? 0 : getFrameOffset(inFrame); }
 
-  void incrementDrawCallsGenerated() { ++m_calls_generated; }
+  /*
+		Nodes with the same pass in a row, drawn
+		as one indirect range with that pass's
+		pipeline. The sort puts passes together
+		unless the draw key order says otherwise.
+	*/
+  struct DrawBatch
+  {
+    uint32_t first;
+    uint32_t count;
+    uint32_t pass;  //VkeDrawKeys::Pass
+  };
+
+  /*
+		Draws nodes inFirst to inFirst + inCount, one
+		range per batch they overlap, binding each
+		batch's pipeline. Returns the pipelines bound.
+	*/
+  uint32_t recordSceneBatches(VkCommandBuffer inCmd, uint32_t inFirst, uint32_t inCount);
+  void     recordSceneDraw(VkCommandBuffer inCmd, uint32_t inBatch, uint32_t inFirst, uint32_t inCount);
 
   const uint32_t getCurrentBufferIndex() { return m_current_buffer_index; }
 
+  VkeFrameContext& getFrameContext(uint32_t inIndex) { return m_frames[inIndex]; }
+  uint32_t         getFrameCount() const { return m_frame_count; }
+
   bool primaryCommandReady() { return m_primary_cmd_ready; }
 
+  /*
+		Layout of one instance in the transforms buffer.
+		MATRIX is a full mat4, COMPACT a VkeInstanceRecord.
+	*/
+  enum InstanceFormat
+  {
+    INSTANCE_FORMAT_MATRIX  = 0,
+    INSTANCE_FORMAT_COMPACT = 1
+  };
+
+  InstanceFormat getInstanceFormat() const { return m_instance_format; }
+
+  /*
+		Push constants of the scene draws. With shader
+		draw parameters, node_base plus gl_DrawIDARB
+		is the node, so the vertex shader no longer
+		divides gl_InstanceIndex by instance_count.
+	*/
+  struct DrawParams
+  {
+    uint32_t node_base;
+    uint32_t instance_count;
+  };
+
+  /*
+		Per frame counters, reported once a second.
+	*/
+  struct Stats
+  {
+    uint64_t upload_bytes      = 0;
+    uint32_t upload_ranges     = 0;
+    uint32_t visible_instances = 0;
+    uint32_t culled_instances  = 0;
+
+    /*
+			Occlusion culling. occluded_instances failed
+			the first phase, recovered_instances of them
+			were drawn by the second. Times are in ms.
+		*/
+    uint32_t occluded_instances  = 0;
+    uint32_t recovered_instances = 0;
+    float    scene_gpu_ms        = 0.0f;
+    float    occlusion_gpu_ms    = 0.0f;
+    float    saved_gpu_ms        = 0.0f;
+
+    /*
+			Impostors. Instances in the crossfade band
+			count towards both.
+		*/
+    uint32_t mesh_instances     = 0;
+    uint32_t impostor_instances = 0;
+
+    /*
+			Scene secondaries recorded again because
+			something they depend on changed.
+		*/
+    uint32_t rerecorded_commands = 0;
+
+    /*
+			CPU time spent waiting for the oldest
+			frame in flight to finish, in ms.
+		*/
+    float fence_wait_ms = 0.0f;
+
+    /*
+			Draw benchmark. CPU time spent recording
+			the scene secondaries, in ms, and the node
+			draws they hold.
+		*/
+    float    record_ms   = 0.0f;
+    uint32_t scene_draws = 0;
+
+    /*
+			Scene pipelines bound across the secondaries
+			and the occlusion pass.
+		*/
+    uint32_t pipeline_binds = 0;
+  };
+
+  const Stats& getStats() const { return m_stats; }
+
 protected:
+  void allocateDescriptorSets();
+  void addUploadRange(VkDeviceSize inOffset, VkDeviceSize inSize);
+  void recordUploads(VkCommandBuffer inCmd);
+  void reportStats(float inDeltaTime);
+  void cullInstances();
+  void recordInstanceCounts(VkCommandBuffer inCmd);
+  void initDrawBatches();
+  void initGPUCulling();
+  void recordGPUCulling(VkCommandBuffer inCmd);
+  void readCullStats();
+  void initTimestamps();
+  void readTimestamps();
+  void recordCullReadback(VkCommandBuffer inCmd);
+  void pushCullParams(VkCommandBuffer inCmd, uint32_t inPass);
+  void initHiZ();
+  void releaseHiZ();
+  void recordHiZBuild(VkCommandBuffer inCmd);
+  void recordOcclusionPass(VkCommandBuffer inCmd);
+  void initImpostors();
+  void initImpostorCommand();
+  void recordImpostorBake(VkCommandBuffer inCmd);
+  void initFlightSimulation();
+  void updateFlightPaths(float inDeltaTime, uint8_t* outInstances);
+  void recordFlightSimulation(VkCommandBuffer inCmd);
+  void validateFlightSimulation();
+
   bool m_primary_cmd_ready;
 
 
+  /*
+		Only for one off setup commands, the frame
+		contexts own the per frame pools.
+	*/
   VkCommandPool   m_primary_buffer_cmd_pool;
-  VkCommandBuffer m_primary_commands[2];
-  VkCommandBuffer m_update_commands[2];
+  VkeFrameContext m_frames[MAX_FRAMES_IN_FLIGHT];
+  uint32_t        m_frame_count = 2;
+
+  VkeFlightPaths m_flight_paths;
+  float          m_delta_time = 0.0f;
+  float          m_total_time = 0.0f;
+
+  InstanceFormat m_instance_format = INSTANCE_FORMAT_MATRIX;
+  uint32_t       m_instance_stride = sizeof(glm::mat4);
 
-  std::vector<std::unique_ptr<FlightPath>> m_flight_paths;
+  /*
+		GPU flight simulation. The path records are
+		uploaded once and a compute dispatch at the
+		start of each frame advances them and writes
+		the transforms in place. When validating, the
+		CPU paths still run into m_flight_reference and
+		each frame's transforms are read back to compare.
+	*/
+  bool                   m_gpu_flight             = false;
+  bool                   m_validate_flight        = false;
+  bool                   m_flight_upload_pending  = false;
+  VkBuffer               m_flight_buffer          = VK_NULL_HANDLE;
+  VkDeviceMemory         m_flight_memory          = VK_NULL_HANDLE;
+  VkBuffer               m_flight_buffer_staging  = VK_NULL_HANDLE;
+  VkDeviceMemory         m_flight_staging         = VK_NULL_HANDLE;
+  VkBuffer               m_flight_readback        = VK_NULL_HANDLE;
+  VkDeviceMemory         m_flight_readback_memory = VK_NULL_HANDLE;
+  uint8_t*               m_flight_readback_ptr    = nullptr;
+  VkDescriptorSetLayout  m_flight_descriptor_layout;
+  VkDescriptorSet        m_flight_descriptor_set;
+  VkPipelineLayout       m_flight_pipeline_layout;
+  VkPipeline             m_flight_pipeline = VK_NULL_HANDLE;
+  std::vector<uint8_t>   m_flight_reference[MAX_FRAMES_IN_FLIGHT];
+  bool                   m_flight_readback_ready[MAX_FRAMES_IN_FLIGHT]{};
+
+  /*
+		Frustum culling of the CPU flight instances.
+		Each one is bounded by a sphere about its
+		origin; chunks are culled on the thread pool
+		and the visible transforms packed to the front
+		of the transforms block. The indirect commands
+		are then patched to draw only that many.
+	*/
+  VkeThreadPool         m_thread_pool;
+  bool                  m_cull_instances = true;
+  std::vector<float>    m_cull_x;
+  std::vector<float>    m_cull_y;
+  std::vector<float>    m_cull_z;
+  std::vector<float>    m_cull_radius;
+  std::vector<uint32_t> m_cull_chunk_counts;
+  std::vector<uint32_t> m_visible_instances;
+  uint32_t              m_draw_instance_count    = 0;
+  uint32_t              m_patched_instance_count = 0;
+
+  std::vector<VkDrawIndexedIndirectCommand> m_indirect_commands;
+
+  /*
+		Draw batches of the sorted nodes, and the scene
+		pipelines by VkeDrawKeys::Pass. Opaque is
+		m_pipeline, without blending; alpha test adds
+		a discard and transparent blends without
+		writing depth.
+	*/
+  std::vector<DrawBatch> m_draw_batches;
+  VkPipeline             m_pass_pipelines[VkeDrawKeys::PASS_COUNT] = {};
+
+  /*
+		GPU culling. A compute pass tests each instance
+		and then each of its nodes against the frustum,
+		writes per node visible lists and packs the non
+		empty draw commands to the front of each draw
+		batch; the draws take the batch's count from
+		m_cull_count_buffer. Needs
+		VK_KHR_draw_indirect_count, the CPU path above
+		is used without it.
+	*/
+  bool                   m_gpu_cull             = false;
+  VkBuffer               m_cull_visible_buffer  = VK_NULL_HANDLE;
+  VkDeviceMemory         m_cull_visible_memory  = VK_NULL_HANDLE;
+  VkBuffer               m_cull_count_buffer    = VK_NULL_HANDLE;
+  VkDeviceMemory         m_cull_count_memory    = VK_NULL_HANDLE;
+  VkBuffer               m_cull_draw_buffer     = VK_NULL_HANDLE;
+  VkDeviceMemory         m_cull_draw_memory     = VK_NULL_HANDLE;
+  VkBuffer               m_cull_batch_buffer    = VK_NULL_HANDLE;
+  VkDeviceMemory         m_cull_batch_memory    = VK_NULL_HANDLE;
+  VkBuffer               m_cull_readback        = VK_NULL_HANDLE;
+  VkDeviceMemory         m_cull_readback_memory = VK_NULL_HANDLE;
+  uint32_t*              m_cull_readback_ptr    = nullptr;
+  bool                   m_cull_readback_ready[MAX_FRAMES_IN_FLIGHT]{};
+  VkDescriptorBufferInfo m_visible_descriptor{};
+  VkDescriptorSetLayout  m_cull_descriptor_layout;
+  VkDescriptorSet        m_cull_descriptor_set;
+  VkPipelineLayout       m_cull_pipeline_layout;
+  VkPipeline             m_cull_pipeline = VK_NULL_HANDLE;
+
+  /*
+		Two phase occlusion culling on the GPU path.
+		The first phase also tests each instance
+		against a farthest depth pyramid of the last
+		frame and sets aside the ones it hides. After
+		the main pass the pyramid is rebuilt from this
+		frame's depth, the set aside instances are
+		tested again and those now visible are drawn
+		in a second pass that loads the attachments,
+		so nothing pops in. The pyramid then serves
+		the next frame.
+	*/
+  bool                         m_occlusion_cull           = false;
+  VkImage                      m_hiz_image                = VK_NULL_HANDLE;
+  VkDeviceMemory               m_hiz_memory               = VK_NULL_HANDLE;
+  VkImageView                  m_hiz_view                 = VK_NULL_HANDLE;
+  VkSampler                    m_hiz_sampler              = VK_NULL_HANDLE;
+  VkDescriptorPool             m_hiz_descriptor_pool      = VK_NULL_HANDLE;
+  uint32_t                     m_hiz_width                = 0;
+  uint32_t                     m_hiz_height               = 0;
+  uint32_t                     m_hiz_levels               = 0;
+  std::vector<VkImageView>     m_hiz_level_views;
+  std::vector<VkDescriptorSet> m_hiz_level_sets;
+  VkDescriptorSetLayout        m_hiz_descriptor_layout;
+  VkPipelineLayout             m_hiz_pipeline_layout;
+  VkPipeline                   m_hiz_pipeline             = VK_NULL_HANDLE;
+  VkBuffer                     m_occluded_buffer          = VK_NULL_HANDLE;
+  VkDeviceMemory               m_occluded_memory          = VK_NULL_HANDLE;
+  VkBuffer                     m_occlusion_params_buffer  = VK_NULL_HANDLE;
+  VkDeviceMemory               m_occlusion_params_memory  = VK_NULL_HANDLE;
+  VkDescriptorSetLayout        m_occlusion_descriptor_layout;
+  VkDescriptorSet              m_occlusion_descriptor_set = VK_NULL_HANDLE;
+  VkRenderPass                 m_occlusion_render_pass    = VK_NULL_HANDLE;
+  glm::mat4                    m_hiz_view_projection;
+
+  /*
+		Timestamps per command buffer: before the
+		main pass, after it, after the Hi-Z build and
+		re-test, and after the second pass. Only with
+		occlusion culling or the draw benchmark.
+	*/
+  VkQueryPool m_timestamp_pool   = VK_NULL_HANDLE;
+  float       m_timestamp_period = 0.0f;
+  bool        m_timestamps_ready[MAX_FRAMES_IN_FLIGHT]{};
+  bool        m_draw_benchmark = false;
+
+  /*
+		Impostors for distant instances on the CPU cull
+		path. The chopper is baked once, on the first
+		submitted frame, into an octahedral atlas of
+		views holding albedo and chopper space normals.
+		Culling packs the instances beyond the fade
+		band's far edge out of the mesh draws and copies
+		those beyond its near edge after them, where an
+		instanced quad per impostor picks the nearest
+		baked view. Both sides dither by the same fade.
+	*/
+  bool                  m_impostors                = false;
+  bool                  m_impostors_baked          = false;
+  float                 m_impostor_near            = 0.0f;
+  float                 m_impostor_far             = 0.0f;
+  uint32_t              m_impostor_instance_count  = 0;
+  glm::vec4             m_impostor_bounds          = glm::vec4(0.0f);  //center and radius, 0 until baked
+  std::vector<uint8_t>  m_impostor_transforms;
+  VkImage               m_impostor_albedo          = VK_NULL_HANDLE;
+  VkImage               m_impostor_normal          = VK_NULL_HANDLE;
+  VkImage               m_impostor_depth           = VK_NULL_HANDLE;
+  VkDeviceMemory        m_impostor_albedo_memory   = VK_NULL_HANDLE;
+  VkDeviceMemory        m_impostor_normal_memory   = VK_NULL_HANDLE;
+  VkDeviceMemory        m_impostor_depth_memory    = VK_NULL_HANDLE;
+  VkImageView           m_impostor_albedo_view     = VK_NULL_HANDLE;
+  VkImageView           m_impostor_normal_view     = VK_NULL_HANDLE;
+  VkImageView           m_impostor_target_views[3] = {};
+  VkSampler             m_impostor_sampler         = VK_NULL_HANDLE;
+  VkRenderPass          m_impostor_render_pass     = VK_NULL_HANDLE;
+  VkFramebuffer         m_impostor_framebuffer     = VK_NULL_HANDLE;
+  VkBuffer              m_impostor_indirect_buffer = VK_NULL_HANDLE;
+  VkDeviceMemory        m_impostor_indirect_memory = VK_NULL_HANDLE;
+  VkDescriptorSetLayout m_impostor_descriptor_layout;
+  VkDescriptorSet       m_impostor_descriptor_set  = VK_NULL_HANDLE;
+  VkPipelineLayout      m_impostor_pipeline_layout;
+  VkPipeline            m_impostor_pipeline        = VK_NULL_HANDLE;
+  VkPipelineLayout      m_impostor_bake_pipeline_layout;
+  VkPipeline            m_impostor_bake_pipeline   = VK_NULL_HANDLE;
 
   uint32_t m_current_buffer_index;
 
   uint32_t m_max_draw_calls;
-  uint32_t m_calls_generated;
+
+  /*
+		Secondaries executed in the scene pass,
+		rebuilt each frame.
+	*/
+  std::vector<VkCommandBuffer> m_secondary_commands;
 
   DepthImageView m_depth_attachment;
   ColorImageView m_color_attachment;
-  ColorImageView m_resolve_attachment[2];
 
   VkeNodeData::List* m_node_data;
   VkeMaterial::List* m_materials;
 
-  VkCommandBuffer m_scene_command[2];
-  VkCommandBuffer m_terrain_command[2];
-
-  VkSemaphore m_present_done[2];
-  VkSemaphore m_render_done[2];
-  VkFence     m_update_fence[2];
+  /*
+		Indirect commands from the scene cache, if
+		any. Only the index ranges are used.
+	*/
+  const VkDrawIndexedIndirectCommand* m_cached_commands = nullptr;
 
 
   /*
@@ -212,9 +534,22 @@ protected:
   VkDescriptorSet       m_scene_descriptor_set;
   VkDescriptorSetLayout m_scene_descriptor_layout;
 
+  bool m_descriptor_sets_ready = false;
+
   VkDescriptorSet*      m_texture_descriptor_sets;
   VkDescriptorSetLayout m_texture_descriptor_set_layout;
 
+  /*
+		Material texture array. Bindless, it is a
+		partially bound, update after bind array from
+		its own pool, sized by the device rather than
+		the materials. Otherwise it has one slot per
+		material.
+	*/
+  bool             m_bindless_textures       = false;
+  uint32_t         m_texture_slots           = 0;
+  VkDescriptorPool m_texture_descriptor_pool = VK_NULL_HANDLE;
+
 
   VkPipeline            m_quad_pipeline;
   VkPipelineLayout      m_quad_pipeline_layout;
@@ -226,8 +561,22 @@ protected:
   VkDescriptorSetLayout m_terrain_descriptor_set_layout;
   VkDescriptorSet       m_terrain_descriptor_set;
 
-  VkBuffer       m_uniforms_buffer_staging;
-  VkDeviceMemory m_uniforms_staging;
+  /*
+		Host visible staging for m_uniforms_buffer, one
+		region per frame in flight. Only dirty ranges are
+		copied from here into the device local buffer.
+	*/
+  VkBuffer                  m_uniforms_buffer_staging;
+  VkDeviceMemory            m_uniforms_staging;
+  uint8_t*                  m_uniforms_staging_ptr = nullptr;
+  VkDeviceSize              m_uniforms_size        = 0;
+  std::vector<VkBufferCopy> m_upload_ranges;
+  bool                      m_force_full_upload = true;
+
+  Stats    m_stats;
+  Stats    m_stats_accum;
+  uint32_t m_stats_frames = 0;
+  float    m_stats_time   = 0.0f;
 
   VkBuffer       m_uniforms_buffer;
   VkDeviceMemory m_uniforms_memory;
@@ -235,6 +584,33 @@ protected:
 
   VkDescriptorBufferInfo m_uniforms_descriptor;
 
+  /*
+		With GPU flight, node records and flight
+		transforms share m_uniforms_buffer. Transforms
+		start at this offset, aligned for use as a
+		storage buffer.
+	*/
+  VkDeviceSize m_transforms_offset = 0;
+
+  /*
+		Per frame data the CPU writes in place into a
+		persistently mapped ring, one region per frame
+		in flight: the camera, then the transforms
+		unless the GPU writes them. The frame's fence
+		guards its region and the shaders select it
+		with dynamic offsets. Culling packs the
+		visible transforms from m_flight_transforms.
+	*/
+  VkBuffer               m_frame_ring        = VK_NULL_HANDLE;
+  VkDeviceMemory         m_frame_ring_memory = VK_NULL_HANDLE;
+  uint8_t*               m_frame_ring_ptr    = nullptr;
+  VkDeviceSize           m_frame_ring_stride = 0;
+  VkDescriptorBufferInfo m_camera_descriptor = {};
+  std::vector<uint8_t>   m_flight_transforms;
+
+  uint8_t* getFrameRegion(uint32_t inFrame) { return m_frame_ring_ptr + m_frame_ring_stride * inFrame; }
+  uint8_t* getTransformRegion(uint32_t inFrame) { return getFrameRegion(inFrame) + m_transforms_descriptor.offset; }
+
   float* m_uniforms_local;
 
   VkBuffer       m_material_buffer_staging;
@@ -263,6 +639,8 @@ protected:
   struct
   {
     VkShaderModule scene_vertex, scene_fragment, quad_vertex, quad_fragment, terrain_vertex, terrain_fragment, terrain_tcs, terrain_tes;
+    VkShaderModule flight_compute, instance_cull, occlusion_cull, hiz_build;
+    VkShaderModule impostor_vertex, impostor_fragment, impostor_bake_vertex, impostor_bake_fragment;
   } m_shaders;
 
 
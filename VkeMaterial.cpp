@@ -60,6 +60,11 @@ void VkeMaterial::updateVKBufferData(VkeMaterialUniform* inData)
 void VkeMaterial::bind(VkCommandBuffer* inBuffer) {}
 
 void VkeMaterial::initFromData(VKSFile* inFile, VKSMaterialRecord* inMaterial)
+{
+  initFromData(inFile->textures.data(), inMaterial);
+}
+
+void VkeMaterial::initFromData(const VKSTextureRecord* inTextures, const VKSMaterialRecord* inMaterial)
 {
   m_backing_store->reflectivity = inMaterial->reflectivity;
   m_backing_store->opacity      = inMaterial->opacity;
@@ -71,7 +76,7 @@ void VkeMaterial::initFromData(VKSFile* inFile, VKSMaterialRecord* inMaterial)
 
   for(uint32_t i = 0; i < texCount; ++i)
   {
-    VKSTextureRecord& tex = inFile->textures.data()[i + inMaterial->firstTexture];
+    const VKSTextureRecord& tex = inTextures[i + inMaterial->firstTexture];
     if(tex.type == meshimport::DIFFUSE)
     {
 
@@ -116,13 +121,19 @@ void VkeMaterial::initWithDefaults()
   m_backing_store->shininess = 1.0;
 }
 
-VkeMaterial::~VkeMaterial() {}
+VkeMaterial::~VkeMaterial()
+{
+  deleteBackingStore();
+}
 
 VkeMaterial::List::List()
     : m_default(NULL)
 {
 }
-VkeMaterial::List::~List() {}
+VkeMaterial::List::~List()
+{
+  clear();
+}
 
 VkeMaterial::ID VkeMaterial::List::nextID()
 {
@@ -147,7 +158,11 @@ VkeMaterial* VkeMaterial::List::newMaterial()
 
 VkeMaterial* VkeMaterial::List::newMaterial(const VkeMaterial::ID& inID)
 {
-  VkeMaterial* outMaterial = new VkeMaterial(inID);
+  VkeMaterial::Map::iterator itr = m_data.find(inID);
+  if(itr != m_data.end() && m_pool.owns(itr->second))
+    m_pool.deleteObject(itr->second);
+
+  VkeMaterial* outMaterial = m_pool.newObject(inID);
   m_data[inID]             = outMaterial;
   return outMaterial;
 }
@@ -164,6 +179,25 @@ VkeMaterial* VkeMaterial::List::getMaterial(const VkeMaterial::ID& inID)
   return m_data[inID];
 }
 
+void VkeMaterial::List::deleteMaterial(const VkeMaterial::ID& inID)
+{
+  VkeMaterial::Map::iterator itr = m_data.find(inID);
+  if(itr == m_data.end())
+    return;
+
+  if(m_pool.owns(itr->second))
+    m_pool.deleteObject(itr->second);
+  m_data.erase(itr);
+  m_deleted_keys.push_back(inID);
+}
+
+void VkeMaterial::List::clear()
+{
+  m_data.clear();
+  m_deleted_keys.clear();
+  m_pool.clear();
+}
+
 size_t VkeMaterial::List::getTextureCount()
 {
   size_t                     outCount = 0;
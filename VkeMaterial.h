@@ -22,6 +22,7 @@
 #pragma once
 
 #include "MeshUtils.h"
+#include "ObjectPool.h"
 #include "VkeBuffer.h"
 #include "VkeTexture.h"
 #include <map>
@@ -44,6 +45,7 @@ typedef struct VkeMaterialUniform
 
 struct VKSFile;
 struct VKSMaterialRecord;
+struct VKSTextureRecord;
 
 class VkeMaterial : public VkeBuffer<VkeMaterialUniform>
 {
@@ -62,6 +64,8 @@ public:
     VkeMaterial* newMaterial(const VkeMaterial::ID& inID);
     void         addMaterial(VkeMaterial* const inMaterial);
     VkeMaterial* getMaterial(const ID& inID);
+    void         deleteMaterial(const ID& inID);
+    void         clear();
 
     ID    nextID();
     Count count();
@@ -84,6 +88,7 @@ public:
     VkeMaterial::Map             m_data;
     std::vector<VkeMaterial::ID> m_deleted_keys;
     VkeMaterial*                 m_default;
+    ObjectPool<VkeMaterial>      m_pool;
   };
 
 
@@ -98,6 +103,7 @@ public:
 
   void initFromData(meshimport::MaterialDataf* inData);
   void initFromData(VKSFile* inFile, VKSMaterialRecord* inMaterial);
+  void initFromData(const VKSTextureRecord* inTextures, const VKSMaterialRecord* inMaterial);
   void initWithDefaults();
 
   void updateVKBufferData(VkeMaterialUniform* inData);
@@ -41,13 +41,28 @@ void VkeMesh::initVKBuffers()
   m_ibo.initVKBufferData();
 }
 
-void VkeMesh::initFromMesh(VKSFile* inFile, VKSMeshRecord* inMesh)
+void VkeMesh::initFromMesh(VKSFile* inFile, const VKSMeshRecord* inMesh)
 {
   m_vertex_count = inMesh->vertexCount;
   m_index_count  = inMesh->indexCount;
   m_material_id  = inMesh->materialID;
 }
 
+/*
+	Bounds over the vertices referenced by this
+	mesh's index range. Vertices are 8 floats,
+	position first.
+*/
+void VkeMesh::computeBounds(const float* inVertices, const uint32_t* inIndices)
+{
+  m_bounds = AABB();
+  for(uint32_t i = 0; i < m_index_count; ++i)
+  {
+    const float* pos = inVertices + size_t(m_first_vertex + inIndices[m_first_index + i]) * 8;
+    m_bounds.expand(glm::vec3(pos[0], pos[1], pos[2]));
+  }
+}
+
 void VkeMesh::initFromMesh(Mesh* const inMesh)
 {
 
@@ -174,7 +189,10 @@ void VkeMesh::draw(VkCommandBuffer* inCommand)
 }
 
 VkeMesh::List::List() {}
-VkeMesh::List::~List() {}
+VkeMesh::List::~List()
+{
+  clear();
+}
 
 VkeMesh::ID VkeMesh::List::nextID()
 {
@@ -199,12 +217,16 @@ VkeMesh* VkeMesh::List::newMesh()
 
 VkeMesh* VkeMesh::List::newMesh(const VkeMesh::ID& inID)
 {
-  VkeMesh* outMesh = new VkeMesh(inID);
+  VkeMesh::Map::iterator itr = m_data.find(inID);
+  if(itr != m_data.end() && m_pool.owns(itr->second))
+    m_pool.deleteObject(itr->second);
+
+  VkeMesh* outMesh = m_pool.newObject(inID);
   m_data[inID]     = outMesh;
   return outMesh;
 }
 
-VkeMesh* VkeMesh::List::newMesh(const VkeMesh::ID& inID, VKSFile* inFile, VKSMeshRecord* inData)
+VkeMesh* VkeMesh::List::newMesh(const VkeMesh::ID& inID, VKSFile* inFile, const VKSMeshRecord* inData)
 {
   VkeMesh* outMesh = newMesh(inID);
   if(!outMesh)
@@ -232,3 +254,22 @@ VkeMesh* VkeMesh::List::getMesh(const VkeMesh::ID& inID)
 {
   return m_data[inID];
 }
+
+void VkeMesh::List::deleteMesh(const VkeMesh::ID& inID)
+{
+  VkeMesh::Map::iterator itr = m_data.find(inID);
+  if(itr == m_data.end())
+    return;
+
+  if(m_pool.owns(itr->second))
+    m_pool.deleteObject(itr->second);
+  m_data.erase(itr);
+  m_deleted_keys.push_back(inID);
+}
+
+void VkeMesh::List::clear()
+{
+  m_data.clear();
+  m_deleted_keys.clear();
+  m_pool.clear();
+}
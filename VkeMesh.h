@@ -25,7 +25,9 @@
 #define USE_SINGLE_VBO 1
 #endif
 
+#include "Bounds.h"
 #include "Mesh.h"
+#include "ObjectPool.h"
 #include "VkeIBO.h"
 #include "VkeVBO.h"
 #include <map>
@@ -48,10 +50,12 @@ public:
 
     VkeMesh* newMesh();
     VkeMesh* newMesh(const VkeMesh::ID& inID);
-    VkeMesh* newMesh(const VkeMesh::ID& inID, VKSFile* inFile, VKSMeshRecord* inData);
+    VkeMesh* newMesh(const VkeMesh::ID& inID, VKSFile* inFile, const VKSMeshRecord* inData);
     VkeMesh* newMesh(const VkeMesh::ID& inID, Mesh* const inMesh);
     void     addMesh(VkeMesh* const inMesh);
     VkeMesh* getMesh(const ID& inID);
+    void     deleteMesh(const ID& inID);
+    void     clear();
 
     ID    nextID();
     Count count();
@@ -59,6 +63,7 @@ public:
   private:
     VkeMesh::Map             m_data;
     std::vector<VkeMesh::ID> m_deleted_keys;
+    ObjectPool<VkeMesh>      m_pool;
   };
 
 
@@ -67,7 +72,7 @@ public:
   ~VkeMesh();
 
   void initFromMesh(Mesh* const inMesh);
-  void initFromMesh(VKSFile* inFile, VKSMeshRecord* inMesh);
+  void initFromMesh(VKSFile* inFile, const VKSMeshRecord* inMesh);
 
   void initVKBuffers();
 
@@ -91,6 +96,8 @@ public:
 
   const uint32_t getIndexCount() { return m_index_count; }
 
+  void        computeBounds(const float* inVertices, const uint32_t* inIndices);
+  const AABB& getBounds() const { return m_bounds; }
 
 protected:
   ID m_id;
@@ -118,4 +125,10 @@ protected:
   VkCommandBuffer m_bind_cmd = nullptr;
 
   int32_t m_material_id = -1;
+
+  /*
+		Object space bounds of the mesh's
+		range in the global VBO.
+	*/
+  AABB m_bounds;
 };
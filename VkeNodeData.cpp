@@ -21,6 +21,7 @@
 
 #include "VkeNodeData.h"
 #include "VulkanAppContext.h"
+#include <glm/gtc/packing.hpp>
 #include <iostream>
 
 VkeNodeData::VkeNodeData()
@@ -43,72 +44,132 @@ VkeNodeData::VkeNodeData(const ID& inID)
   //initNodeData();
 }
 
-bool sortByMatFunc(VkeNodeData* lhs, VkeNodeData* rhs)
-{
-  return (lhs->getMesh()->getMaterialID() < rhs->getMesh()->getMaterialID());
-}
-
-bool sortByMeshFunc(VkeNodeData* lhs, VkeNodeData* rhs)
-{
-  return (lhs->getMesh()->getID() < rhs->getMesh()->getID());
-}
-
-bool sortByOpacityFunc(VkeNodeData* lhs, VkeNodeData* rhs)
+/*
+	Builds a key per node from its pass, opacity,
+	material and mesh and radix sorts them, so a
+	re-sort after nodes are added or materials
+	change stays linear in the node count.
+	Each material is looked up once. There is one
+	scene pipeline per pass, so the pipeline field
+	is the pass.
+*/
+void VkeNodeData::List::sortByDrawKeys()
 {
   VulkanAppContext* ctxt = VulkanAppContext::GetInstance();
-  return (ctxt->getOpacity(lhs->getMesh()->getMaterialID()) > ctxt->getOpacity(rhs->getMesh()->getMaterialID()));
-}
+  size_t            sz   = m_data.size();
+
+  struct MaterialKey
+  {
+    float    opacity = -1.0f;
+    uint32_t pass    = 0;
+  };
+  std::vector<MaterialKey> materials;
 
+  m_keys.resize(sz);
+  m_order.resize(sz);
 
-void VkeNodeData::List::sortByMaterialID()
-{
-  std::sort(m_data.begin(), m_data.end(), sortByMatFunc);
-  size_t sz = m_data.size();
   for(size_t i = 0; i < sz; ++i)
   {
-    m_data[i]->setIndex(i);
+    VkeMesh* mesh     = m_data[i]->getMesh();
+    uint32_t material = uint32_t(mesh->getMaterialID());
+    if(material >= materials.size())
+      materials.resize(material + 1);
+    if(materials[material].opacity < 0.0f)
+    {
+      materials[material].opacity = ctxt->getOpacity(material);
+      materials[material].pass    = ctxt->getDrawPass(material);
+    }
+
+    VkeDrawKeys::Inputs inputs;
+    inputs.opacity  = materials[material].opacity;
+    inputs.pass     = materials[material].pass;
+    inputs.pipeline = inputs.pass;
+    inputs.material = material;
+    inputs.mesh     = mesh->getID();
+    m_keys[i]       = m_draw_keys.makeKey(inputs);
   }
+
+  m_draw_keys.sort(m_keys.data(), uint32_t(sz), m_order.data());
+  reorder(m_order.data());
 }
 
-void VkeNodeData::List::sortByOpacity()
+/*
+	Applies a previously computed order, where
+	inOrder[slot] is the current index of the
+	node data that should move into slot.
+*/
+void VkeNodeData::List::reorder(const uint32_t* inOrder)
 {
-  std::sort(m_data.begin(), m_data.end(), sortByOpacityFunc);
-  size_t sz = m_data.size();
+  VkeNodeData::Map sorted(m_data.size());
+  size_t           sz = m_data.size();
   for(size_t i = 0; i < sz; ++i)
   {
-    m_data[i]->setIndex(i);
+    sorted[i] = m_data[inOrder[i]];
+    sorted[i]->setIndex(i);
   }
-}
-
-void VkeNodeData::List::sortByMeshID()
-{
-  std::sort(m_data.begin(), m_data.end(), sortByMeshFunc);
+  m_data.swap(sorted);
+  m_all_dirty = true;
 }
 
 void VkeNodeData::initNodeData()
 {
 
 
-  m_usage_flags  = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+  m_usage_flags  = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
   m_memory_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
   m_use_staging  = true;
 
 
-  initBackingStore(sizeof(VkeNodeUniform));
+  initBackingStore(sizeof(VkeNodeRecord));
   initVKBufferData();
 }
 
 void VkeNodeData::initNodeDataSubAlloc()
 {
-  initBackingStore(sizeof(VkeNodeUniform));
+  initBackingStore(sizeof(VkeNodeRecord));
 }
 
 void VkeNodeData::bind(VkCommandBuffer* inCmd) {}
 
-void VkeNodeData::updateVKBufferData(VkeNodeUniform* inData)
+/*
+	Copies the record into its slot and
+	returns true if the slot changed.
+*/
+bool VkeNodeData::updateVKBufferData(VkeNodeRecord* inData)
+{
+  uint8_t* ptr = (uint8_t*)inData + (sizeof(VkeNodeRecord) * m_index);
+  if(memcmp(ptr, (void*)m_backing_store, sizeof(VkeNodeRecord)) == 0)
+    return false;
+
+  memcpy(ptr, (void*)m_backing_store, sizeof(VkeNodeRecord));
+  return true;
+}
+
+/*
+	Packs the world matrix as three rows and the
+	normal matrix as halfs into the node record.
+*/
+static void packNodeRecord(VkeNodeRecord* outRecord, const glm::mat4& inMatrix, const glm::mat4& inInverse)
 {
-  uint8_t* ptr = (uint8_t*)inData + (sizeof(VkeNodeUniform) * m_index);
-  memcpy(ptr, (void*)m_backing_store, sizeof(VkeNodeUniform));
+  glm::mat4 rows = glm::transpose(inMatrix);
+  outRecord->world_rows[0] = rows[0];
+  outRecord->world_rows[1] = rows[1];
+  outRecord->world_rows[2] = rows[2];
+
+  float nml[10];
+  for(int c = 0; c < 3; ++c)
+  {
+    for(int r = 0; r < 3; ++r)
+    {
+      nml[c * 3 + r] = inInverse[c][r];
+    }
+  }
+  nml[9] = 0.0f;
+
+  for(int i = 0; i < 5; ++i)
+  {
+    outRecord->normal_packed[i] = glm::packHalf2x16(glm::vec2(nml[i * 2], nml[i * 2 + 1]));
+  }
 }
 
 void VkeNodeData::updateFromNode(Node* const inNode, VkCommandBuffer* inBuffer)
@@ -118,11 +179,12 @@ void VkeNodeData::updateFromNode(Node* const inNode, VkCommandBuffer* inBuffer)
   inNode->update();
   Transform transform = inNode->GetTransform();
 
-  m_backing_store->node_matrix         = transform.getTransform();
-  m_backing_store->inverse_node_matrix = transform.getInverse();
+  packNodeRecord(m_backing_store, transform.getTransform(), transform.getInverse());
+  if(m_mesh)
+    m_world_bounds = m_mesh->getBounds().transformed(transform.getTransform());
 }
 
-void VkeNodeData::updateFromNode(Node* const inNode, VkeNodeUniform* inData, uint32_t inInstanceCount)
+bool VkeNodeData::updateFromNode(Node* const inNode, VkeNodeRecord* inData, uint32_t inInstanceCount)
 {
 
   m_node = inNode;
@@ -130,12 +192,15 @@ void VkeNodeData::updateFromNode(Node* const inNode, VkeNodeUniform* inData, uin
   inNode->update();
   Transform transform = inNode->GetTransform();
 
-  m_backing_store->node_matrix         = transform.getTransform();
-  m_backing_store->inverse_node_matrix = transform.getInverse();
-  m_backing_store->lookup.x            = m_mesh->getMaterialID();
-  m_backing_store->lookup.y            = inInstanceCount;
+  packNodeRecord(m_backing_store, transform.getTransform(), transform.getInverse());
+  m_world_bounds = m_mesh->getBounds().transformed(transform.getTransform());
 
-  updateVKBufferData(inData);
+  m_backing_store->material_id     = uint32_t(m_mesh->getMaterialID());
+  m_backing_store->instance_count  = inInstanceCount;
+  m_backing_store->padding         = 0;
+  m_backing_store->bounding_sphere = glm::vec4(m_world_bounds.getCenter(), glm::length(m_world_bounds.getExtent()));
+
+  return updateVKBufferData(inData);
 }
 
 void VkeNodeData::updateConstantVKBufferData(VkCommandBuffer* inBuffer)
@@ -144,9 +209,9 @@ void VkeNodeData::updateConstantVKBufferData(VkCommandBuffer* inBuffer)
   vkCmdUpdateBuffer(*inBuffer, m_data.buffer, 0, m_data_size, (const uint32_t*)&m_backing_store[0]);
 }
 
-void VkeNodeData::updateFromNode(VkeNodeUniform* inData, uint32_t inInstanceCount)
+bool VkeNodeData::updateFromNode(VkeNodeRecord* inData, uint32_t inInstanceCount)
 {
-  updateFromNode(m_node, inData, inInstanceCount);
+  return updateFromNode(m_node, inData, inInstanceCount);
 }
 
 void VkeNodeData::updateFromNode()
@@ -154,10 +219,16 @@ void VkeNodeData::updateFromNode()
   updateFromNode(m_node);
 }
 
-VkeNodeData::~VkeNodeData() {}
+VkeNodeData::~VkeNodeData()
+{
+  deleteBackingStore();
+}
 
 VkeNodeData::List::List() {}
-VkeNodeData::List::~List() {}
+VkeNodeData::List::~List()
+{
+  clear();
+}
 
 VkeNodeData::ID VkeNodeData::List::nextID()
 {
@@ -182,11 +253,27 @@ VkeNodeData* VkeNodeData::List::newData()
 
 VkeNodeData* VkeNodeData::List::newData(const VkeNodeData::ID& inID)
 {
-  VkeNodeData* outData = new VkeNodeData(inID);
+  VkeNodeData* outData = m_pool.newObject(inID);
   m_data.push_back(outData);
   return outData;
 }
 
+/*
+	Node data is handed out by index, so there is
+	no per-entry delete. The whole list is released
+	together when a scene is unloaded.
+*/
+void VkeNodeData::List::clear()
+{
+  m_data.clear();
+  m_deleted_keys.clear();
+  m_dirty_slots.clear();
+  m_dirty_ranges.clear();
+  m_all_dirty = true;
+  m_bounds    = AABB();
+  m_pool.clear();
+}
+
 
 void VkeNodeData::List::addData(VkeNodeData* const inData)
 {
@@ -210,14 +297,53 @@ void VkeNodeData::List::update()
   }
 }
 
-void VkeNodeData::List::update(VkeNodeUniform* inData, uint32_t inInstanceCount)
+/*
+	Writes every node record into inData and
+	gathers the slots that changed into
+	coalesced ranges for upload.
+*/
+void VkeNodeData::List::update(VkeNodeRecord* inData, uint32_t inInstanceCount)
 {
-  VkeNodeData::Map::iterator itr;
+  m_dirty_slots.clear();
+  m_dirty_ranges.clear();
 
   size_t sz = m_data.size();
   for(size_t i = 0; i < sz; ++i)
   {
-    m_data[i]->updateFromNode(inData, inInstanceCount);
+    bool changed = m_data[i]->updateFromNode(inData, inInstanceCount);
+    if(changed || m_all_dirty)
+    {
+      m_dirty_slots.push_back(uint32_t(m_data[i]->getIndex()));
+    }
+  }
+  m_all_dirty = false;
+
+  std::sort(m_dirty_slots.begin(), m_dirty_slots.end());
+
+  /*
+	Only the box around all nodes is read, so it
+	is gathered again whenever one of them moves.
+	*/
+  if(!m_dirty_slots.empty())
+  {
+    m_bounds = AABB();
+    for(size_t i = 0; i < sz; ++i)
+    {
+      m_bounds.expand(m_data[i]->getWorldBounds());
+    }
+  }
+
+  size_t dirtyCount = m_dirty_slots.size();
+  for(size_t i = 0; i < dirtyCount; ++i)
+  {
+    size_t slot = m_dirty_slots[i];
+    if(!m_dirty_ranges.empty() && m_dirty_ranges.back().first + m_dirty_ranges.back().count == slot)
+    {
+      m_dirty_ranges.back().count++;
+      continue;
+    }
+    DirtyRange range = {slot, 1};
+    m_dirty_ranges.push_back(range);
   }
 }
 
@@ -21,28 +21,55 @@
 
 #pragma once
 
+#include "Bounds.h"
 #include "Node.h"
+#include "ObjectPool.h"
 #include "VkeBuffer.h"
+#include "VkeDrawKeys.h"
 #include "VkeMesh.h"
 #include <algorithm>
 #include <map>
 
-struct VkeNodeUniform
+/*
+	Compact per node GPU record, laid out
+	for a std430 storage buffer (96 bytes).
+	world_rows		: rows of the 3x4 world matrix.
+	normal_packed	: upper 3x3 of the inverse node
+					  matrix, column major, as 9 halfs.
+	material_id		: material lookup.
+	instance_count	: instances drawn per node.
+	bounding_sphere	: centre and radius of the world
+					  bounds, for GPU culling.
+*/
+struct VkeNodeRecord
 {
-  glm::mat4  node_matrix;
-  glm::mat4  inverse_node_matrix;
-  glm::ivec4 lookup;
-  glm::vec4  padding[3];
+  glm::vec4 world_rows[3];
+  uint32_t  normal_packed[5];
+  uint32_t  material_id;
+  uint32_t  instance_count;
+  uint32_t  padding;
+  glm::vec4 bounding_sphere;
 };
 
 
-class VkeNodeData : public VkeBuffer<VkeNodeUniform>
+class VkeNodeData : public VkeBuffer<VkeNodeRecord>
 {
 public:
   typedef size_t                    ID;
   typedef std::vector<VkeNodeData*> Map;
   typedef size_t                    Count;
 
+  /*
+		Run of consecutive node slots
+		that changed since the last update.
+	*/
+  struct DirtyRange
+  {
+    size_t first;
+    size_t count;
+  };
+  typedef std::vector<DirtyRange> DirtyRanges;
+
   class List
   {
   public:
@@ -54,21 +81,47 @@ public:
     void         addData(VkeNodeData* const inData);
     VkeNodeData* getData(const ID& inID);
     void         update();
-    void         update(VkeNodeUniform* inData, uint32_t inInstanceCount = 1);
+    void         update(VkeNodeRecord* inData, uint32_t inInstanceCount = 1);
+    void         clear();
+
+    void               markAllDirty() { m_all_dirty = true; }
+    const DirtyRanges& getDirtyRanges() const { return m_dirty_ranges; }
+
+    /*
+			World bounds around every node, updated
+			in update() when any node has moved.
+		*/
+    const AABB& getBounds() const { return m_bounds; }
 
     ID    nextID();
     Count count();
 
     void getDescriptors(VkDescriptorBufferInfo* outDescriptor);
     void getMeshes(VkeMesh** outMeshes);
-    void sortByMaterialID();
-    void sortByOpacity();
-    void sortByMeshID();
+    void reorder(const uint32_t* inOrder);
+
+    /*
+			Orders the node slots by their draw keys,
+			see VkeDrawKeys for what goes into a key.
+		*/
+    void         sortByDrawKeys();
+    VkeDrawKeys& getDrawKeys() { return m_draw_keys; }
 
 
   private:
     VkeNodeData::Map             m_data;
     std::vector<VkeNodeData::ID> m_deleted_keys;
+    ObjectPool<VkeNodeData>      m_pool;
+
+    std::vector<uint32_t> m_dirty_slots;
+    DirtyRanges           m_dirty_ranges;
+    bool                  m_all_dirty = true;
+
+    AABB m_bounds;
+
+    VkeDrawKeys           m_draw_keys;
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_order;
   };
 
 
@@ -89,11 +142,15 @@ public:
   void updateFromNode();
   void updateFromNode(Node* const inNode, VkCommandBuffer* inBuffer = NULL);
   void updateFromNode(VkCommandBuffer* inBuffer);
-  void updateFromNode(Node* const inNode, VkeNodeUniform* inData, uint32_t inInstanceCount = 1);
-  void updateFromNode(VkeNodeUniform* inData, uint32_t inInstanceCount = 1);
+  bool updateFromNode(Node* const inNode, VkeNodeRecord* inData, uint32_t inInstanceCount = 1);
+  bool updateFromNode(VkeNodeRecord* inData, uint32_t inInstanceCount = 1);
   void updateConstantVKBufferData(VkCommandBuffer* inBuffer = NULL);
 
-  void updateVKBufferData(VkeNodeUniform* inData);
+  bool updateVKBufferData(VkeNodeRecord* inData);
+
+  size_t getIndex() const { return m_index; }
+
+  const AABB& getWorldBounds() const { return m_world_bounds; }
 
   void bind(VkCommandBuffer* inBuffer);
 
@@ -106,5 +163,7 @@ public:
 
   uint32_t m_layer;
 
+  AABB m_world_bounds;
+
   bool m_needs_buffer_update;
 };
@@ -41,15 +41,14 @@ public:
   virtual void initDescriptorPool();
   void         releaseDescriptorPool();
 
-  virtual void update() = 0;
+  virtual void update(float inDeltaTime) = 0;
 
   virtual void resize(uint32_t inWidth, uint32_t inHeight);
 
   inline VkSampleCountFlagBits getSamples() { return m_samples; }
 
 
-  VkFramebuffer getFramebuffer(uint32_t inIdx) { return m_framebuffers[inIdx]; }
-  VkRenderPass  getRenderPass() { return m_render_pass; }
+  VkRenderPass getRenderPass() { return m_render_pass; }
 
 
   virtual void initDescriptorLayout() = 0;
@@ -82,8 +81,7 @@ protected:
   VkPipelineCache  m_pipeline_cache  = VK_NULL_HANDLE;
   VkRenderPass     m_render_pass     = VK_NULL_HANDLE;
 
-  uint32_t      m_descriptor_set_count = 0;
-  VkFramebuffer m_framebuffers[2]{};
+  uint32_t m_descriptor_set_count = 0;
 
   virtual size_t getRequiredDescriptorCount() = 0;
 
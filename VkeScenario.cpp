@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#include "VkeScenario.h"
+#include "VkeFlightPaths.h"
+#include <nvh/nvprint.hpp>
+
+#define FRAME_STREAM_MAGIC 0x4d525453
+#define FRAME_STREAM_VERSION 2
+
+struct VkeFrameStreamHeader
+{
+  uint32_t    magic;
+  uint32_t    version;
+  VkeScenario scenario;
+};
+
+void VkeScenario::generatePaths(VkeFlightPaths& outPaths, VkeRandom& inRandom) const
+{
+  outPaths.resize(instance_count);
+
+  for(uint32_t i = 0; i < instance_count; ++i)
+  {
+    glm::vec2 initPos(inRandom.signedUniform() * lane_width, -path_length + inRandom.signedUniform() * path_jitter);
+    glm::vec2 endPos(inRandom.signedUniform() * lane_width, path_length + inRandom.signedUniform() * path_jitter);
+    float     startT = inRandom.uniform();
+    float     alt    = altitude + inRandom.signedUniform() * altitude_jitter;
+    outPaths.setPath(i, initPos, endPos, startT, alt, velocity);
+  }
+}
+
+VkeFrameStream::VkeFrameStream() {}
+
+VkeFrameStream::~VkeFrameStream()
+{
+  finish();
+}
+
+bool VkeFrameStream::startRecording(const std::string& inPath, const VkeScenario& inScenario)
+{
+  finish();
+
+  m_record = fopen(inPath.c_str(), "wb");
+  if(!m_record)
+  {
+    LOGE("Could not open %s for recording.\n", inPath.c_str());
+    return false;
+  }
+
+  VkeFrameStreamHeader header{};
+  header.magic    = FRAME_STREAM_MAGIC;
+  header.version  = FRAME_STREAM_VERSION;
+  header.scenario = inScenario;
+  fwrite(&header, sizeof(header), 1, m_record);
+
+  LOGI("Recording frames to %s\n", inPath.c_str());
+  return true;
+}
+
+bool VkeFrameStream::startReplay(const std::string& inPath, VkeScenario& outScenario)
+{
+  finish();
+
+  FILE* fp = fopen(inPath.c_str(), "rb");
+  if(!fp)
+  {
+    LOGE("Could not open replay %s.\n", inPath.c_str());
+    return false;
+  }
+
+  VkeFrameStreamHeader header;
+  if(fread(&header, sizeof(header), 1, fp) != 1 || header.magic != FRAME_STREAM_MAGIC || header.version != FRAME_STREAM_VERSION)
+  {
+    LOGE("%s is not a frame recording.\n", inPath.c_str());
+    fclose(fp);
+    return false;
+  }
+
+  VkeFrameInput frame;
+  while(fread(&frame, sizeof(frame), 1, fp) == 1)
+  {
+    m_frames.push_back(frame);
+  }
+  fclose(fp);
+
+  outScenario = header.scenario;
+  m_replaying = true;
+  m_frame     = 0;
+
+  LOGI("Replaying %zu frames from %s\n", m_frames.size(), inPath.c_str());
+  return true;
+}
+
+void VkeFrameStream::finish()
+{
+  if(m_record)
+  {
+    fclose(m_record);
+    m_record = nullptr;
+  }
+  m_replaying = false;
+  m_frames.clear();
+}
+
+bool VkeFrameStream::next(float& ioDeltaTime, glm::mat4& ioView)
+{
+  if(m_replaying)
+  {
+    if(m_frame >= m_frames.size())
+      return false;
+
+    ioDeltaTime = m_frames[m_frame].delta_time;
+    ioView      = m_frames[m_frame].view;
+  }
+  else if(m_record)
+  {
+    VkeFrameInput frame{};
+    frame.delta_time = ioDeltaTime;
+    frame.view       = ioView;
+    fwrite(&frame, sizeof(frame), 1, m_record);
+  }
+
+  m_frame++;
+  return true;
+}
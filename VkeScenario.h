@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class VkeFlightPaths;
+
+/*
+	Small xorshift generator. Each consumer owns
+	one seeded from the scenario, so the generated
+	scene does not depend on the C runtime or on
+	what else has called rand().
+*/
+class VkeRandom
+{
+public:
+  explicit VkeRandom(uint32_t inSeed)
+      : m_state(inSeed ? inSeed : 0x9e3779b9)
+  {
+  }
+
+  uint32_t next()
+  {
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+    return m_state;
+  }
+
+  //[0, 1)
+  float uniform() { return float(next() >> 8) * (1.0f / 16777216.0f); }
+
+  //[-1, 1)
+  float signedUniform() { return uniform() * 2.0f - 1.0f; }
+
+private:
+  uint32_t m_state;
+};
+
+/*
+	Everything that decides what a run looks like.
+	Paths start in a lane around z = -path_length
+	and end around z = +path_length, both spread
+	over +-lane_width in x.
+*/
+struct VkeScenario
+{
+  uint32_t seed           = 1;
+  uint32_t instance_count = 128;
+  float    duration       = 0.0f;  //seconds, 0 runs until closed
+
+  float lane_width      = 100.0f;
+  float path_length     = 200.0f;
+  float path_jitter     = 20.0f;
+  float altitude        = 10.0f;
+  float altitude_jitter = 4.0f;
+  float velocity        = 0.06f;
+  float swarm_radius    = 0.0f;  //paths keep this far apart, 0 flies straight lines
+
+  void generatePaths(VkeFlightPaths& outPaths, VkeRandom& inRandom) const;
+};
+
+/*
+	Inputs that drive one frame.
+*/
+struct VkeFrameInput
+{
+  float     delta_time;
+  uint32_t  padding[3];
+  glm::mat4 view;
+};
+
+/*
+	Per frame time and camera, either taken live
+	and optionally recorded, or replayed from a
+	recording. A recording starts with the scenario
+	it was made with, so a replay rebuilds the same
+	scene and steps it frame for frame.
+*/
+class VkeFrameStream
+{
+public:
+  VkeFrameStream();
+  ~VkeFrameStream();
+
+  bool startRecording(const std::string& inPath, const VkeScenario& inScenario);
+  bool startReplay(const std::string& inPath, VkeScenario& outScenario);
+  void finish();
+
+  bool isReplaying() const { return m_replaying; }
+
+  /*
+		Produces the next frame. Live and recorded
+		frames take inDeltaTime and ioView as given;
+		a replay overwrites both. Returns false once
+		the replay has run out of frames.
+	*/
+  bool next(float& ioDeltaTime, glm::mat4& ioView);
+
+  uint32_t getFrameIndex() const { return m_frame; }
+
+private:
+  FILE*                      m_record    = nullptr;
+  bool                       m_replaying = false;
+  std::vector<VkeFrameInput> m_frames;
+  uint32_t                   m_frame = 0;
+};
@@ -253,6 +253,20 @@ void VkeTexture::loadTextureFloatData(float* inData, uint32_t inWidth, uint32_t
   LOGI("Floating Point Texture Loaded.\n");
 }
 
+bool VkeTexture::hasAlpha() const
+{
+  switch(m_format)
+  {
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+      return true;
+    default:
+      return false;
+  }
+}
+
 VkeTexture::List::List() {}
 VkeTexture::List::~List() {}
 
@@ -296,6 +310,17 @@ VkeTexture* VkeTexture::List::getTexture(const VkeTexture::ID& inID)
   return m_data[inID];
 }
 
+bool VkeTexture::List::hasAlpha()
+{
+  VkeTexture::Map::iterator itr;
+  for(itr = m_data.begin(); itr != m_data.end(); ++itr)
+  {
+    if(itr->second->hasAlpha())
+      return true;
+  }
+  return false;
+}
+
 void VkeTexture::List::getData(VkeTexture::Data* outData, size_t offset)
 {
   VkeTexture::Map::iterator itr;
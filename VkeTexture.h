@@ -62,6 +62,7 @@ public:
     Count count();
 
     void getData(VkeTexture::Data* outDescriptor, size_t offset = 0);
+    bool hasAlpha();
 
 
   private:
@@ -82,6 +83,14 @@ public:
   inline void      setFormat(VkFormat inFormat) { m_format = inFormat; }
   inline VkFormat& getFormat() { return m_format; }
 
+  /*
+		True for the formats that exist to carry an
+		alpha channel. BC1 and the uncompressed RGBA
+		formats are mostly used for opaque textures
+		and do not count.
+	*/
+  bool hasAlpha() const;
+
   Data& getData() { return m_data; }
 
   inline int32_t getWidth() { return m_width; }
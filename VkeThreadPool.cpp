@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#include "VkeThreadPool.h"
+
+VkeThreadPool::VkeThreadPool() {}
+
+VkeThreadPool::~VkeThreadPool()
+{
+  stop();
+}
+
+void VkeThreadPool::start(uint32_t inWorkerCount)
+{
+  stop();
+
+  if(inWorkerCount == 0)
+  {
+    uint32_t hardware = std::thread::hardware_concurrency();
+    inWorkerCount     = hardware > 1 ? hardware - 1 : 0;
+  }
+
+  m_stopping = false;
+  for(uint32_t i = 0; i < inWorkerCount; ++i)
+  {
+    m_workers.push_back(std::thread(&VkeThreadPool::workerLoop, this));
+  }
+}
+
+void VkeThreadPool::stop()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+
+  for(size_t i = 0; i < m_workers.size(); ++i)
+  {
+    m_workers[i].join();
+  }
+  m_workers.clear();
+}
+
+void VkeThreadPool::runTasks(uint32_t inTaskCount, const TaskFunc* inFunc)
+{
+  for(;;)
+  {
+    uint32_t task = m_next_task.fetch_add(1);
+    if(task >= inTaskCount)
+      return;
+    (*inFunc)(task);
+  }
+}
+
+void VkeThreadPool::workerLoop()
+{
+  uint64_t seen = 0;
+
+  for(;;)
+  {
+    uint32_t        taskCount;
+    const TaskFunc* func;
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_wake.wait(lk, [this, seen] { return m_stopping || m_generation != seen; });
+      if(m_stopping)
+        return;
+
+      seen      = m_generation;
+      taskCount = m_task_count;
+      func      = m_func;
+      m_active++;
+    }
+
+    runTasks(taskCount, func);
+
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_active--;
+    }
+    m_done.notify_all();
+  }
+}
+
+void VkeThreadPool::run(uint32_t inTaskCount, const TaskFunc& inFunc)
+{
+  if(inTaskCount == 0)
+    return;
+
+  if(m_workers.empty() || inTaskCount == 1)
+  {
+    for(uint32_t i = 0; i < inTaskCount; ++i)
+    {
+      inFunc(i);
+    }
+    return;
+  }
+
+  /*
+		A worker that woke too late for the last
+		job may still be active. Wait for it, so it
+		cannot claim tasks from this one.
+	*/
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_done.wait(lk, [this] { return m_active == 0; });
+
+    m_func       = &inFunc;
+    m_task_count = inTaskCount;
+    m_next_task.store(0);
+    m_generation++;
+  }
+  m_wake.notify_all();
+
+  runTasks(inTaskCount, &inFunc);
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  m_done.wait(lk, [this] { return m_active == 0; });
+  m_func = nullptr;
+}
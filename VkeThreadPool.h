@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Contact chebert@nvidia.com (Chris Hebert) for feedback */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+/*
+	Fixed set of worker threads for splitting
+	per frame loops. run() hands out task
+	indices to the workers and the calling
+	thread, and returns once every task is done.
+*/
+class VkeThreadPool
+{
+public:
+  typedef std::function<void(uint32_t inTask)> TaskFunc;
+
+  VkeThreadPool();
+  ~VkeThreadPool();
+
+  /*
+		Starts inWorkerCount threads. 0 uses one
+		less than the hardware thread count, since
+		the calling thread works too.
+	*/
+  void start(uint32_t inWorkerCount = 0);
+  void stop();
+
+  /*
+		Threads that take part in run(),
+		the caller included.
+	*/
+  uint32_t getThreadCount() const { return uint32_t(m_workers.size()) + 1; }
+
+  void run(uint32_t inTaskCount, const TaskFunc& inFunc);
+
+private:
+  VkeThreadPool(const VkeThreadPool&) = delete;
+  VkeThreadPool& operator=(const VkeThreadPool&) = delete;
+
+  void workerLoop();
+  void runTasks(uint32_t inTaskCount, const TaskFunc* inFunc);
+
+  std::vector<std::thread> m_workers;
+  std::mutex               m_mutex;
+  std::condition_variable  m_wake;
+  std::condition_variable  m_done;
+
+  const TaskFunc*       m_func       = nullptr;
+  uint32_t              m_task_count = 0;
+  uint64_t              m_generation = 0;
+  uint32_t              m_active     = 0;
+  bool                  m_stopping   = false;
+  std::atomic<uint32_t> m_next_task{0};
+};
@@ -21,11 +21,15 @@
 
 
 #include "VulkanAppContext.h"
+#include "VKSCache.h"
 #include "VKSFile.h"
 #include "vkaUtils.h"
 
+#include <map>
 #include <string>
+#include <string.h>
 
+#include "nvh/nvprint.hpp"
 #include "nvpwindow.hpp"
 
 #include "VkeCreateUtils.h"
@@ -59,87 +63,151 @@ VulkanAppContext* VulkanAppContext::GetInstance()
 
 VulkanAppContext::VulkanAppContext() {}
 
+/*
+	Drops the CPU side scene objects. Node data, meshes
+	and materials are pool allocated, so this is a bulk
+	release rather than a walk over every entry.
+*/
+void VulkanAppContext::releaseScene()
+{
+  m_rotor_node = nullptr;
+  m_node_data.clear();
+  m_mesh_data.clear();
+  m_materials.clear();
+  m_flat_nodes.clear();
+  m_flat_node_data.clear();
+  m_anim_bindings.clear();
+  m_scene_cache.close();
+}
+
+/*
+	Loads a scene, preferring the binary snapshot
+	next to the .vks file when its source hash
+	still matches. A cold load rebuilds the scene
+	from the .vks file and writes a new snapshot.
+*/
 void VulkanAppContext::loadVKSScene(const std::string& inFileName)
 {
-  VKSFile vkFile;
-  vkFile.outputFile = inFileName;
+  releaseScene();
 
+  std::chrono::high_resolution_clock::time_point loadStart = std::chrono::high_resolution_clock::now();
 
-  readVKSFile(&vkFile);
+  std::string sourcePath = findVKSFile(inFileName);
+  uint64_t    sourceHash = sourcePath.empty() ? 0 : hashVKSFile(sourcePath);
+  std::string cachePath  = sourcePath + ".cache";
 
-  /*
-		Unpack meshes
-	*/
+  VkeDrawKeys& drawKeys = m_node_data.getDrawKeys();
+  if(!drawKeys.setOrder(m_settings.draw_key_order))
+  {
+    LOGE("Invalid draw key order %s, ignoring it.\n", m_settings.draw_key_order.c_str());
+  }
 
-  uint32_t meshCnt = vkFile.header.meshCount;
+  bool warm = m_scene_cache.open(cachePath, sourceHash, drawKeys.getOrderCode());
+  if(warm)
+  {
+    loadSceneCache();
+  }
+  else
+  {
+    VKSFile vkFile;
+    vkFile.outputFile = inFileName;
+
+    readVKSFile(&vkFile);
+    buildVKSScene(&vkFile);
 
+    if(sourceHash != 0 && !writeSceneCache(&vkFile, cachePath, sourceHash))
+    {
+      LOGI("Could not write scene cache %s\n", cachePath.c_str());
+    }
+  }
+
+  double loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+  LOGI("Scene %s loaded in %.2f ms (%s)\n", inFileName.c_str(), loadMs, warm ? "warm, from cache" : "cold, from vks");
+}
+
+void VulkanAppContext::initGlobalBuffers(const float* inVertices, uint32_t inVertexElementCount, const uint32_t* inIndices, uint32_t inIndexCount)
+{
 #if USE_SINGLE_VBO
 
-  uint32_t vtxStoreSize = size_t(vkFile.vertexCount) * 8 * sizeof(float);
-  uint32_t idxStoreSize = vkFile.indexCount * sizeof(uint32_t);
+  uint32_t vtxStoreSize = inVertexElementCount * sizeof(float);
+  uint32_t idxStoreSize = inIndexCount * sizeof(uint32_t);
 
   m_global_vbo.initBackingStore(vtxStoreSize);
   m_global_ibo.initBackingStore(idxStoreSize);
 
   float* vData = m_global_vbo.getBackingStore();
-  memcpy(vData, vkFile.vertices.data(), vtxStoreSize);
+  memcpy(vData, inVertices, vtxStoreSize);
   uint32_t* iData = m_global_ibo.getBackingStore();
-  memcpy(iData, vkFile.indices.data(), idxStoreSize);
+  memcpy(iData, inIndices, idxStoreSize);
 
 
   m_global_vbo.initVKBufferData();
   m_global_ibo.initVKBufferData();
 
 #endif
+}
 
+void VulkanAppContext::addAnimationNode(const VKSAnimationNodeRecord& inNode, const VKSAnimationKeyRecord* inKeys)
+{
+  std::string newNodeName(inNode.name);
 
-  uint32_t animCount = vkFile.header.animationCount;
+  VkeAnimationNode* vAnimNode = m_animation.newNode(newNodeName);
 
+  uint32_t keyCount = inNode.positionCount;
 
-  if(animCount >= 1)
+  for(size_t k = 0; k < keyCount; ++k)
   {
-    //importing the first animation only at the moment.
-    VKSAnimationRecord animation = vkFile.animations[0];
-    uint32_t           nCnt      = animation.nodecount;
+    VKSAnimationKeyRecord key = inKeys[k + inNode.firstPosition];
+    vAnimNode->Position().newKey(key.time, key.key);
+  }
 
-    for(size_t n = 0; n < nCnt; ++n)
-    {
-      VKSAnimationNodeRecord nodeAnim = vkFile.animationNodes[n + animation.firstNode];
+  keyCount = inNode.rotationCount;
 
-      std::string newNodeName(nodeAnim.name);
+  for(size_t k = 0; k < keyCount; ++k)
+  {
+    VKSAnimationKeyRecord key = inKeys[k + inNode.firstRotation];
+    vAnimNode->Rotation().newKey(key.time, key.key);
+  }
+
+  keyCount = inNode.scaleCount;
+
+  for(size_t k = 0; k < keyCount; ++k)
+  {
+    VKSAnimationKeyRecord key = inKeys[k + inNode.firstScale];
+    vAnimNode->Scale().newKey(key.time, key.key);
+  }
+}
+
+void VulkanAppContext::buildVKSScene(VKSFile* inFile)
+{
+  /*
+		Unpack meshes
+	*/
 
-      VkeAnimationNode* vAnimNode = m_animation.newNode(newNodeName);
+  uint32_t meshCnt = inFile->header.meshCount;
 
-      uint32_t keyCount = nodeAnim.positionCount;
+  initGlobalBuffers(inFile->vertices.data(), uint32_t(inFile->vertices.size()), inFile->indices.data(), inFile->indexCount);
 
-      for(size_t k = 0; k < keyCount; ++k)
-      {
-        VKSAnimationKeyRecord key = vkFile.animationKeys[k + nodeAnim.firstPosition];
-        vAnimNode->Position().newKey(key.time, key.key);
-      }
 
-      keyCount = nodeAnim.rotationCount;
+  uint32_t animCount = inFile->header.animationCount;
 
-      for(size_t k = 0; k < keyCount; ++k)
-      {
-        VKSAnimationKeyRecord key = vkFile.animationKeys[k + nodeAnim.firstRotation];
-        vAnimNode->Rotation().newKey(key.time, key.key);
-      }
 
-      keyCount = nodeAnim.scaleCount;
+  if(animCount >= 1)
+  {
+    //importing the first animation only at the moment.
+    VKSAnimationRecord animation = inFile->animations[0];
+    uint32_t           nCnt      = animation.nodecount;
 
-      for(size_t k = 0; k < keyCount; ++k)
-      {
-        VKSAnimationKeyRecord key = vkFile.animationKeys[k + nodeAnim.firstScale];
-        vAnimNode->Scale().newKey(key.time, key.key);
-      }
+    for(size_t n = 0; n < nCnt; ++n)
+    {
+      addAnimationNode(inFile->animationNodes[n + animation.firstNode], inFile->animationKeys.data());
     }
   }
 
 
   for(uint32_t i = 0; i < meshCnt; ++i)
   {
-    VkeMesh* theMesh = m_mesh_data.newMesh(i, &vkFile, &vkFile.meshes[i]);
+    VkeMesh* theMesh = m_mesh_data.newMesh(i, inFile, &inFile->meshes[i]);
 
 #if USE_SINGLE_VBO
 #else
@@ -147,37 +215,39 @@ void VulkanAppContext::loadVKSScene(const std::string& inFileName)
 #endif
 
 
-    theMesh->setFirstIndex(vkFile.meshes[i].firstIndex);
-    theMesh->setFirstVertex(vkFile.meshes[i].firstVertex);
+    theMesh->setFirstIndex(inFile->meshes[i].firstIndex);
+    theMesh->setFirstVertex(inFile->meshes[i].firstVertex);
+    theMesh->computeBounds(inFile->vertices.data(), inFile->indices.data());
   }
 
-  uint32_t matCnt = vkFile.header.materialCount;
+  uint32_t matCnt = inFile->header.materialCount;
 
 
   for(uint32_t i = 0; i < matCnt; ++i)
   {
-    m_materials.newMaterial(i)->initFromData(&vkFile, &vkFile.materials[i]);
+    m_materials.newMaterial(i)->initFromData(inFile, &inFile->materials[i]);
   }
 
-  uint32_t nodeCnt        = vkFile.header.nodeCount;
+  uint32_t nodeCnt        = inFile->header.nodeCount;
   uint32_t nodesProcessed = 0;
 
 
   while(nodesProcessed < nodeCnt)
   {
-    addVKSNode(&vkFile, nodesProcessed);
+    addVKSNode(inFile, nodesProcessed);
   }
 
 
-  m_node_data.sortByOpacity();
+  m_node_data.sortByDrawKeys();
 }
 
-void VulkanAppContext::addVKSNode(VKSFile* inFile, uint32_t& inNodesProcessed, Node* parentNode)
+void VulkanAppContext::addVKSNode(VKSFile* inFile, uint32_t& inNodesProcessed, Node* parentNode, int32_t inParentIndex)
 {
 
-  uint32_t       nodeID   = inNodesProcessed;
-  VKSNodeRecord* fileNode = &inFile->nodes[inNodesProcessed++];
-  Node*          node     = nullptr;
+  uint32_t       nodeID    = inNodesProcessed;
+  VKSNodeRecord* fileNode  = &inFile->nodes[inNodesProcessed++];
+  Node*          node      = nullptr;
+  int32_t        nodeIndex = -1;  //children attach to the root without a mesh node
 
   uint32_t mshCount = fileNode->meshCount;
 
@@ -201,6 +271,20 @@ void VulkanAppContext::addVKSNode(VKSFile* inFile, uint32_t& inNodesProcessed, N
 
     m_node_data.newData(node->getID())->updateFromNode(node);
     m_node_data.getData(node->getID())->setMesh(m_mesh_data.getMesh(fileNode->meshIndices[i]));
+
+    /*
+			Record the node for the scene cache.
+		*/
+    VKSCacheNodeRecord flatNode = {};
+    flatNode.parent             = inParentIndex;
+    flatNode.nodeID             = nodeID;
+    flatNode.meshIndex          = fileNode->meshIndices[i];
+    flatNode.rotation           = fileNode->rotation;
+    flatNode.position           = glm::vec4(fileNode->position, 1.0f);
+    flatNode.scale              = glm::vec4(fileNode->scale, 0.0f);
+    nodeIndex                   = int32_t(m_flat_nodes.size());
+    m_flat_nodes.push_back(flatNode);
+    m_flat_node_data.push_back(m_node_data.getData(node->getID()));
   }
 
   std::string nameStr = std::string(fileNode->name);
@@ -209,6 +293,7 @@ void VulkanAppContext::addVKSNode(VKSFile* inFile, uint32_t& inNodesProcessed, N
   if(animNode)
   {
     animNode->setNode(m_node_data.getData(node->getID()));
+    m_anim_bindings.push_back(std::make_pair(m_node_data.getData(node->getID()), nameStr));
   }
 
   if(nameStr == "main_rotor_parts02")
@@ -219,10 +304,171 @@ void VulkanAppContext::addVKSNode(VKSFile* inFile, uint32_t& inNodesProcessed, N
   uint32_t childCount = fileNode->childCount;
   for(uint32_t i = 0; i < childCount; ++i)
   {
-    addVKSNode(inFile, inNodesProcessed, node);
+    addVKSNode(inFile, inNodesProcessed, node, nodeIndex);
   }
 }
 
+/*
+	Serialises the built scene: the flattened node
+	hierarchy, the sorted node order, the indirect
+	commands, materials and animation bindings.
+*/
+bool VulkanAppContext::writeSceneCache(VKSFile* inFile, const std::string& inPath, uint64_t inSourceHash)
+{
+  std::map<VkeNodeData*, uint32_t> flatIndex;
+  for(size_t i = 0; i < m_flat_node_data.size(); ++i)
+  {
+    flatIndex[m_flat_node_data[i]] = uint32_t(i);
+  }
+
+  size_t nodeCnt = m_node_data.count();
+  if(nodeCnt != m_flat_nodes.size())
+    return false;
+
+  std::vector<uint32_t>                     order(nodeCnt);
+  std::vector<VkDrawIndexedIndirectCommand> commands(nodeCnt);
+
+  for(size_t i = 0; i < nodeCnt; ++i)
+  {
+    VkeNodeData* data = m_node_data.getData(i);
+    VkeMesh*     mesh = data->getMesh();
+
+    order[i]                  = flatIndex[data];
+    commands[i].indexCount    = mesh->getIndexCount();
+    commands[i].instanceCount = 0;
+    commands[i].firstIndex    = mesh->getFirstIndex();
+    commands[i].vertexOffset  = mesh->getFirstVertex();
+    commands[i].firstInstance = 0;
+  }
+
+  std::vector<VKSCacheBindingRecord> bindings;
+  for(size_t i = 0; i < m_anim_bindings.size(); ++i)
+  {
+    VKSCacheBindingRecord binding = {};
+    binding.node                  = flatIndex[m_anim_bindings[i].first];
+    strncpy(binding.name, m_anim_bindings[i].second.c_str(), sizeof(binding.name) - 1);
+    bindings.push_back(binding);
+  }
+
+  const VKSAnimationNodeRecord* animNodes     = NULL;
+  size_t                        animNodeCount = 0;
+  if(inFile->header.animationCount >= 1)
+  {
+    animNodes     = inFile->animationNodes.data() + inFile->animations[0].firstNode;
+    animNodeCount = inFile->animations[0].nodecount;
+  }
+
+  VKSCacheHeader header = {};
+  header.sourceHash     = inSourceHash;
+  header.rotorNode      = m_rotor_node ? int32_t(flatIndex[m_rotor_node]) : -1;
+  header.drawKeyOrder   = m_node_data.getDrawKeys().getOrderCode();
+
+  VKSCache::Writer writer;
+  header.vertices       = writer.add(inFile->vertices.data(), inFile->vertices.size());
+  header.indices        = writer.add(inFile->indices.data(), inFile->indexCount);
+  header.meshes         = writer.add(inFile->meshes.data(), inFile->meshes.size());
+  header.materials      = writer.add(inFile->materials.data(), inFile->materials.size());
+  header.textures       = writer.add(inFile->textures.data(), inFile->textures.size());
+  header.nodes          = writer.add(m_flat_nodes.data(), m_flat_nodes.size());
+  header.order          = writer.add(order.data(), order.size());
+  header.commands       = writer.add(commands.data(), commands.size());
+  header.animationNodes = writer.add(animNodes, animNodeCount);
+  header.animationKeys  = writer.add(inFile->animationKeys.data(), inFile->animationKeys.size());
+  header.bindings       = writer.add(bindings.data(), bindings.size());
+
+  return writer.save(inPath, header);
+}
+
+/*
+	Rebuilds the scene from the mapped snapshot.
+	No recursion and no sort: nodes are created
+	in the cached order and the sorted slots are
+	applied directly.
+*/
+void VulkanAppContext::loadSceneCache()
+{
+  const VKSCacheHeader* header = m_scene_cache.getHeader();
+
+  initGlobalBuffers(m_scene_cache.get<float>(header->vertices), uint32_t(header->vertices.count),
+                    m_scene_cache.get<uint32_t>(header->indices), uint32_t(header->indices.count));
+
+  const VKSAnimationNodeRecord* animNodes = m_scene_cache.get<VKSAnimationNodeRecord>(header->animationNodes);
+  const VKSAnimationKeyRecord*  animKeys  = m_scene_cache.get<VKSAnimationKeyRecord>(header->animationKeys);
+  for(size_t n = 0; n < header->animationNodes.count; ++n)
+  {
+    addAnimationNode(animNodes[n], animKeys);
+  }
+
+  const VKSMeshRecord* meshes = m_scene_cache.get<VKSMeshRecord>(header->meshes);
+  for(uint32_t i = 0; i < header->meshes.count; ++i)
+  {
+    VkeMesh* theMesh = m_mesh_data.newMesh(i, NULL, &meshes[i]);
+
+#if USE_SINGLE_VBO
+#else
+    theMesh->initVKBuffers();
+#endif
+
+    theMesh->setFirstIndex(meshes[i].firstIndex);
+    theMesh->setFirstVertex(meshes[i].firstVertex);
+    theMesh->computeBounds(m_scene_cache.get<float>(header->vertices), m_scene_cache.get<uint32_t>(header->indices));
+  }
+
+  const VKSMaterialRecord* materials = m_scene_cache.get<VKSMaterialRecord>(header->materials);
+  const VKSTextureRecord*  textures  = m_scene_cache.get<VKSTextureRecord>(header->textures);
+  for(uint32_t i = 0; i < header->materials.count; ++i)
+  {
+    m_materials.newMaterial(i)->initFromData(textures, &materials[i]);
+  }
+
+  const VKSCacheNodeRecord* flatNodes = m_scene_cache.get<VKSCacheNodeRecord>(header->nodes);
+  size_t                    nodeCnt   = size_t(header->nodes.count);
+  std::vector<Node*>        nodes(nodeCnt);
+
+  for(size_t i = 0; i < nodeCnt; ++i)
+  {
+    const VKSCacheNodeRecord& flatNode = flatNodes[i];
+
+    Node* node = nullptr;
+    if(flatNode.parent >= 0)
+    {
+      node = nodes[flatNode.parent]->newChild(flatNode.nodeID);
+    }
+    else
+    {
+      node = m_scene_graph->Nodes().newNode(flatNode.nodeID);
+    }
+
+    glm::quat rotation = flatNode.rotation;
+    node->setPosition(flatNode.position.x, flatNode.position.y, flatNode.position.z);
+    node->setRotation(rotation);
+    node->setScale(flatNode.scale.x, flatNode.scale.y, flatNode.scale.z);
+    nodes[i] = node;
+
+    VkeNodeData* data = m_node_data.newData(flatNode.nodeID);
+    data->updateFromNode(node);
+    data->setMesh(m_mesh_data.getMesh(flatNode.meshIndex));
+    m_flat_node_data.push_back(data);
+  }
+
+  const VKSCacheBindingRecord* bindings = m_scene_cache.get<VKSCacheBindingRecord>(header->bindings);
+  for(size_t i = 0; i < header->bindings.count; ++i)
+  {
+    std::string       nameStr(bindings[i].name, strnlen(bindings[i].name, sizeof(bindings[i].name)));
+    VkeAnimationNode* animNode = m_animation.Nodes().getNode(nameStr);
+    if(animNode)
+    {
+      animNode->setNode(m_flat_node_data[bindings[i].node]);
+    }
+  }
+
+  if(header->rotorNode >= 0)
+  {
+    m_rotor_node = m_flat_node_data[header->rotorNode];
+  }
+
+  m_node_data.reorder(m_scene_cache.get<uint32_t>(header->order));
+}
 
 void VulkanAppContext::initRenderer()
 {
@@ -237,8 +483,21 @@ void VulkanAppContext::initRenderer()
 		Gazelle's rotors.
 	*/
 
-  m_rot_y          = 0.0f;
-  m_clock_at_start = std::chrono::high_resolution_clock::now();
+  m_rot_y      = 0.0f;
+  m_scene_time = 0.0f;
+
+  /*
+		A replay brings its own scenario, which has
+		to be in place before the renderer reads it.
+	*/
+  if(!m_settings.replay_file.empty())
+  {
+    m_frame_stream.startReplay(m_settings.replay_file, m_settings.scenario);
+  }
+  else if(!m_settings.record_file.empty())
+  {
+    m_frame_stream.startRecording(m_settings.record_file, m_settings.scenario);
+  }
 
   /*
 		Create the renderer.
@@ -252,6 +511,11 @@ void VulkanAppContext::initRenderer()
 
 
   ((RENDERER*)m_renderer)->setNodeData(&m_node_data);
+  if(m_scene_cache.isOpen())
+  {
+    ((RENDERER*)m_renderer)->setIndirectCommands(
+        m_scene_cache.get<VkDrawIndexedIndirectCommand>(m_scene_cache.getHeader()->commands));
+  }
   ((RENDERER*)m_renderer)->setMaterialData(&m_materials);
   ((RENDERER*)m_renderer)->initIndirectCommands();
   m_renderer->initShaders(m_shaderModuleManager);
@@ -266,7 +530,8 @@ void VulkanAppContext::initRenderer()
 
   dc->getDefaultQueue()->beginCommandBuffer(cmdID, &cmd, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
   dc->getDefaultQueue()->flushCommandBuffer(cmdID, NULL);
-  m_ready = true;
+  m_ready           = true;
+  m_last_frame_time = std::chrono::high_resolution_clock::now();
 }
 
 void VulkanAppContext::resize(uint32_t inWidth, uint32_t inHeight)
@@ -282,20 +547,59 @@ void VulkanAppContext::resize(uint32_t inWidth, uint32_t inHeight)
 
 void VulkanAppContext::render()
 {
-  if(!m_ready)
+  if(!m_ready || m_finished)
     return;
 
-  double nanoseconds_since_start = double(
-      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - m_clock_at_start).count());
-  double seconds_since_start = nanoseconds_since_start / 1e9f;
-  m_rot_y                    = float(0.75 * seconds_since_start);
+  /*
+		Frame time comes from the wall clock unless a
+		recording is being replayed, in which case the
+		recorded time and view are used instead.
+	*/
+  std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+
+  float deltaTime   = std::chrono::duration<float>(now - m_last_frame_time).count();
+  m_last_frame_time = now;
+
+  if(!m_frame_stream.next(deltaTime, m_view))
+  {
+    LOGI("Replay finished after %u frames.\n", m_frame_stream.getFrameIndex());
+    m_frame_stream.finish();
+    m_finished = true;
+    return;
+  }
+
+  m_scene_time += deltaTime;
+  if(m_settings.scenario.duration > 0.0f && m_scene_time >= m_settings.scenario.duration)
+  {
+    LOGI("Scenario finished after %u frames.\n", m_frame_stream.getFrameIndex());
+    m_frame_stream.finish();
+    m_finished = true;
+    return;
+  }
+
+  m_rot_y = 0.75f * m_scene_time;
 
   if(m_rotor_node)
   {
     m_rotor_node->getNode()->setRotation(0.0, 0.0, -m_rot_y * 32.f);
   }
 
-  m_renderer->update();
+  ((RENDERER*)m_renderer)->setCameraLookAt(m_view);
+  m_renderer->update(deltaTime);
+}
+
+void VulkanAppContext::shutdown()
+{
+  if(!m_ready)
+    return;
+
+  VulkanDC::Get()->getDefaultDevice()->waitIdle();
+
+  m_frame_stream.finish();
+  m_renderer->releaseFramebuffer();
+  releaseScene();
+
+  m_ready = false;
 }
 
 // This is a simple message callback to capture debug messages.
@@ -356,6 +660,21 @@ void VulkanAppContext::initAppContext()
   enabledLayers.push_back("VK_LAYER_KHRONOS_validation");
   enabledExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #endif
+
+  /*
+		Lets the device context query the descriptor
+		indexing features on a 1.0 instance.
+	*/
+  uint32_t instanceExtensionCount = 0;
+  vkEnumerateInstanceExtensionProperties(NULL, &instanceExtensionCount, NULL);
+  std::vector<VkExtensionProperties> instanceExtensions(instanceExtensionCount);
+  vkEnumerateInstanceExtensionProperties(NULL, &instanceExtensionCount, instanceExtensions.data());
+  for(uint32_t i = 0; i < instanceExtensionCount; ++i)
+  {
+    if(strcmp(instanceExtensions[i].extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+      enabledExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  }
+
   createInfo.enabledLayerCount       = uint32_t(enabledLayers.size());
   createInfo.ppEnabledLayerNames     = enabledLayers.data();
   createInfo.enabledExtensionCount   = uint32_t(enabledExtensions.size());
@@ -421,7 +740,17 @@ bool VulkanAppContext::initPrograms()
   m_shaderModuleManager.addDirectory(NVPSystem::exePath() + std::string(PROJECT_RELDIRECTORY) + std::string("shaders"));
 
   m_program_ids.scene_vs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_VERTEX_BIT, "std_vertex.glsl");
+  if(VulkanDC::Get()->getDevice()->hasShaderDrawParameters())
+  {
+    m_program_ids.scene_draw_params_vs =
+        m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_VERTEX_BIT, "std_vertex.glsl", "#define DRAW_PARAMETERS 1\n");
+  }
   m_program_ids.scene_fs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, "std_fragment.glsl");
+  if(VulkanDC::Get()->getDevice()->hasDescriptorIndexing())
+  {
+    m_program_ids.scene_bindless_fs =
+        m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, "std_fragment.glsl", "#define BINDLESS_TEXTURES 1\n");
+  }
 
   m_program_ids.scene_quad_vs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_VERTEX_BIT, "vertexQuad.glsl");
   m_program_ids.scene_quad_fs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentQuad.glsl");
@@ -433,6 +762,24 @@ bool VulkanAppContext::initPrograms()
   m_program_ids.scene_terrain_tes =
       m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT, "tesTerrain.glsl");
 
+  m_program_ids.flight_cs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_COMPUTE_BIT, "flight_compute.glsl");
+  m_program_ids.cull_cs   = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_COMPUTE_BIT, "instance_cull.glsl");
+  m_program_ids.occlusion_cs =
+      m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_COMPUTE_BIT, "instance_cull.glsl", "#define OCCLUSION_CULL 1\n");
+  m_program_ids.hiz_cs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_COMPUTE_BIT, "hiz_build.glsl");
+
+  m_program_ids.impostor_vs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_VERTEX_BIT, "vertexImpostor.glsl");
+  m_program_ids.impostor_fs = m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentImpostor.glsl");
+  m_program_ids.impostor_bake_vs =
+      m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_VERTEX_BIT, "vertexImpostorBake.glsl");
+  m_program_ids.impostor_bake_fs =
+      m_shaderModuleManager.createShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentImpostorBake.glsl");
+  if(VulkanDC::Get()->getDevice()->hasDescriptorIndexing())
+  {
+    m_program_ids.impostor_bake_bindless_fs = m_shaderModuleManager.createShaderModule(
+        VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentImpostorBake.glsl", "#define BINDLESS_TEXTURES 1\n");
+  }
+
 
   /*
 		Check that the programs are valid.
@@ -454,7 +801,21 @@ VkeMaterial* VulkanAppContext::getMaterial(VkeMaterial::ID inID)
   return m_materials.getMaterial(inID);
 }
 
+/*
+	Translucent materials blend, materials with an
+	alpha texture are alpha tested and the rest
+	are opaque.
+*/
+uint32_t VulkanAppContext::getDrawPass(uint32_t inMatID)
+{
+  VkeMaterial* material = m_materials.getMaterial(inMatID);
+  if(material->getBackingStore()->opacity < 1.0f)
+    return VkeDrawKeys::PASS_TRANSPARENT;
+
+  return material->getTextures().hasAlpha() ? VkeDrawKeys::PASS_ALPHA_TEST : VkeDrawKeys::PASS_OPAQUE;
+}
+
 void VulkanAppContext::setCameraMatrix(glm::mat4& inMat)
 {
-  ((RENDERER*)m_renderer)->setCameraLookAt(inMat);
+  m_view = inMat;
 }
\ No newline at end of file
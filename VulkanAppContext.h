@@ -27,9 +27,11 @@
 #include <vulkan/vulkan.h>
 
 #include "RenderContext.h"
+#include "VKSCache.h"
 #include "VkeMaterial.h"
 #include "VkeMesh.h"
 #include "VkeNodeData.h"
+#include "VkeScenario.h"
 #include "VkeSceneAnimation.h"
 #include "vkaUtils.h"
 
@@ -53,10 +55,18 @@ public:
   void initRenderer();
 
   void loadVKSScene(const std::string& inFileName);
-  void addVKSNode(VKSFile* inFile, uint32_t& inNodesProcessed, Node* parentNode = NULL);
+  void releaseScene();
+  void addVKSNode(VKSFile* inFile, uint32_t& inNodesProcessed, Node* parentNode = NULL, int32_t inParentIndex = -1);
 
   void render();
 
+  /*
+		Waits for the frames in flight, closes the
+		frame stream and releases the framebuffer
+		and the scene, unmapping the scene cache.
+	*/
+  void shutdown();
+
   bool initPrograms();
 
   void         resize(uint32_t inWidth, uint32_t inHeight);
@@ -75,7 +85,54 @@ public:
 
   float getOpacity(uint32_t inMatID) { return m_materials.getMaterial(inMatID)->getBackingStore()->opacity; }
 
+  /*
+		Which scene pipeline draws a material, a
+		VkeDrawKeys::Pass.
+	*/
+  uint32_t getDrawPass(uint32_t inMatID);
+
+  /*
+		Startup options, filled in from the command
+		line before initAppContext is called.
+	*/
+  struct Settings
+  {
+    VkeScenario scenario;
+    std::string record_file;  //frame inputs are written here
+    std::string replay_file;  //and replayed from here, scenario included
+
+    std::string draw_key_order = "posmg";  //node draw order, see VkeDrawKeys::setOrder
+
+    int instance_format  = 0;  //see vkeGameRendererDynamic::InstanceFormat
+    int flight_benchmark = 0;
+    int swarm_benchmark  = 0;
+    int gpu_flight       = 0;  //integrate flight paths in a compute shader
+    int validate_flight  = 0;  //check the compute results against the CPU
+    int cull_instances   = 1;  //frustum cull the CPU flight instances
+    int gpu_cull         = 0;  //cull in a compute shader, draw with an indirect count
+    int occlusion_cull   = 0;  //two phase Hi-Z occlusion culling, needs gpu_cull
+    int threads          = 0;  //worker threads, 0 for one per core
+    int frames_in_flight = 2;  //frame contexts in the ring, 1 to MAX_FRAMES_IN_FLIGHT
+    int draw_benchmark   = 0;  //re-record the scene every frame and log the per draw cost
+
+    float impostor_distance = 0.0f;  //instances past this draw as impostors, 0 disables
+  };
+
+  Settings& getSettings() { return m_settings; }
+
+  /*
+		True once the scenario duration has passed
+		or a replay has run out of frames.
+	*/
+  bool isFinished() const { return m_finished; }
+
 private:
+  void buildVKSScene(VKSFile* inFile);
+  void initGlobalBuffers(const float* inVertices, uint32_t inVertexElementCount, const uint32_t* inIndices, uint32_t inIndexCount);
+  void addAnimationNode(const VKSAnimationNodeRecord& inNode, const VKSAnimationKeyRecord* inKeys);
+  bool writeSceneCache(VKSFile* inFile, const std::string& inPath, uint64_t inSourceHash);
+  void loadSceneCache();
+
   VkInstance m_vk_instance = nullptr;
 #ifndef NDEBUG
   VkDebugUtilsMessengerEXT m_debug_messenger = VK_NULL_HANDLE;
@@ -93,8 +150,29 @@ private:
   VkeMaterial::List m_materials;
   VkeNodeData*      m_rotor_node = nullptr;
 
+  /*
+		Scene snapshot state. The flattened nodes and
+		bindings are recorded while building from the
+		.vks file; the cache stays mapped while in use.
+	*/
+  VKSCache                                          m_scene_cache;
+  std::vector<VKSCacheNodeRecord>                   m_flat_nodes;
+  std::vector<VkeNodeData*>                         m_flat_node_data;
+  std::vector<std::pair<VkeNodeData*, std::string>> m_anim_bindings;
+
   float                                          m_rot_y = 0.0f;
-  std::chrono::high_resolution_clock::time_point m_clock_at_start{};
+  std::chrono::high_resolution_clock::time_point m_last_frame_time{};
+
+  /*
+		Frame inputs. The view set by the app is only
+		used when not replaying.
+	*/
+  VkeFrameStream m_frame_stream;
+  glm::mat4      m_view{1.0f};
+  float          m_scene_time = 0.0f;
+  bool           m_finished   = false;
+
+  Settings m_settings;
 
   bool              m_ready = false;
   VkeSceneAnimation m_animation;
@@ -108,13 +186,24 @@ private:
   struct ModuleIDs
   {
     nvvk::ShaderModuleID scene_vs;
+    nvvk::ShaderModuleID scene_draw_params_vs;
     nvvk::ShaderModuleID scene_fs;
+    nvvk::ShaderModuleID scene_bindless_fs;
     nvvk::ShaderModuleID scene_quad_vs;
     nvvk::ShaderModuleID scene_quad_fs;
     nvvk::ShaderModuleID scene_terrain_vs;
     nvvk::ShaderModuleID scene_terrain_fs;
     nvvk::ShaderModuleID scene_terrain_tcs;
     nvvk::ShaderModuleID scene_terrain_tes;
+    nvvk::ShaderModuleID flight_cs;
+    nvvk::ShaderModuleID cull_cs;
+    nvvk::ShaderModuleID occlusion_cs;
+    nvvk::ShaderModuleID hiz_cs;
+    nvvk::ShaderModuleID impostor_vs;
+    nvvk::ShaderModuleID impostor_fs;
+    nvvk::ShaderModuleID impostor_bake_vs;
+    nvvk::ShaderModuleID impostor_bake_fs;
+    nvvk::ShaderModuleID impostor_bake_bindless_fs;
   } m_program_ids;
 
 public:
@@ -23,7 +23,9 @@
 #include "VulkanDeviceContext.h"
 #include "VkeCreateUtils.h"
 #include "vkaUtils.h"
+#include <algorithm>
 #include <iostream>
+#include <string.h>
 VulkanDC::Device::Queue::Queue() {}
 
 VulkanDC::Device::Queue::Queue(VulkanDC::Device::Queue::Name& inName, VulkanDC::Device::Queue::NodeID inNodeID)
@@ -314,8 +316,92 @@ void VulkanDC::Device::initDevice()
   requiredFeatures.depthClamp         = VK_TRUE;
   requiredFeatures.multiDrawIndirect  = VK_TRUE;
 
+  /*
+	Optional extensions, enabled when present.
+	*/
+  uint32_t extensionCount = 0;
+  vkEnumerateDeviceExtensionProperties(m_physical_device, NULL, &extensionCount, NULL);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(m_physical_device, NULL, &extensionCount, extensions.data());
+
+  bool hasDrawIndirectCount   = false;
+  bool hasDescriptorIndexing = false;
+  bool hasMaintenance3       = false;
+  for(uint32_t i = 0; i < extensionCount; ++i)
+  {
+    if(strcmp(extensions[i].extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+    {
+      m_extension_names[m_extension_count++] = (char*)VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+      hasDrawIndirectCount                   = true;
+    }
+    else if(strcmp(extensions[i].extensionName, VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME) == 0)
+    {
+      m_extension_names[m_extension_count++] = (char*)VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME;
+      m_shader_draw_parameters               = true;
+    }
+    else if(strcmp(extensions[i].extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0)
+    {
+      hasDescriptorIndexing = true;
+    }
+    else if(strcmp(extensions[i].extensionName, VK_KHR_MAINTENANCE3_EXTENSION_NAME) == 0)
+    {
+      hasMaintenance3 = true;
+    }
+  }
+
+  /*
+	Descriptor indexing is only enabled with the
+	features the bindless material textures use.
+	Querying them on a 1.0 instance needs
+	VK_KHR_get_physical_device_properties2.
+	*/
+  VkInstance instance = VulkanDC::Get()->getVKInstance();
+  PFN_vkGetPhysicalDeviceFeatures2KHR getFeatures2 =
+      (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+  PFN_vkGetPhysicalDeviceProperties2KHR getProperties2 =
+      (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR");
+
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT};
+  if(hasDescriptorIndexing && hasMaintenance3 && getFeatures2 && getProperties2)
+  {
+    VkPhysicalDeviceFeatures2KHR features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+    features2.pNext                        = &indexingFeatures;
+    getFeatures2(m_physical_device, &features2);
+
+    m_descriptor_indexing = indexingFeatures.shaderSampledImageArrayNonUniformIndexing
+                            && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+                            && indexingFeatures.descriptorBindingPartiallyBound;
+  }
+
+  if(m_descriptor_indexing)
+  {
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT};
+    VkPhysicalDeviceProperties2KHR properties2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR};
+    properties2.pNext                          = &indexingProperties;
+    getProperties2(m_physical_device, &properties2);
+
+    m_max_update_after_bind_textures = std::min(indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                                                indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+
+    m_extension_names[m_extension_count++] = (char*)VK_KHR_MAINTENANCE3_EXTENSION_NAME;
+    m_extension_names[m_extension_count++] = (char*)VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+
+    indexingFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT};
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing    = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound              = VK_TRUE;
+  }
+
   deviceCreate(&m_device, &m_physical_device, m_queue_count, &queueInfo, m_extension_count, m_extension_names, 0,
-               nullptr, &requiredFeatures);
+               nullptr, &requiredFeatures, m_descriptor_indexing ? &indexingFeatures : nullptr);
+
+  if(hasDrawIndirectCount)
+  {
+    m_draw_indexed_indirect_count =
+        (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(m_device, "vkCmdDrawIndexedIndirectCountKHR");
+  }
 
   LOGI("Device ID : %p\n", m_device);
 }
@@ -112,6 +112,31 @@ public:
 
     inline VkDevice& getVKDevice() { return m_device; }
 
+    inline const VkPhysicalDeviceProperties& getProperties() const { return m_device_properties; }
+
+    /*
+			vkCmdDrawIndexedIndirectCountKHR, or null
+			if VK_KHR_draw_indirect_count is missing.
+		*/
+    inline PFN_vkCmdDrawIndexedIndirectCountKHR getDrawIndexedIndirectCount() const { return m_draw_indexed_indirect_count; }
+
+    /*
+			True if VK_KHR_shader_draw_parameters is
+			enabled, so shaders can read gl_DrawIDARB
+			and gl_BaseInstanceARB.
+		*/
+    inline bool hasShaderDrawParameters() const { return m_shader_draw_parameters; }
+
+    /*
+			True if VK_EXT_descriptor_indexing is enabled
+			with non uniform indexing, partially bound and
+			update after bind sampled image arrays. The
+			limit is the most combined image samplers
+			one stage can see in such an array.
+		*/
+    inline bool     hasDescriptorIndexing() const { return m_descriptor_indexing; }
+    inline uint32_t getMaxUpdateAfterBindTextures() const { return m_max_update_after_bind_textures; }
+
     inline uint32_t getQueueCount() const { return m_queue_count; }
 
     VulkanDC::Device::Queue* getQueue(VulkanDC::Device::Queue::Name& inName);
@@ -138,12 +163,19 @@ public:
     char*    m_extension_names[64]{};
     uint32_t m_extension_count = 0;
 
+    PFN_vkCmdDrawIndexedIndirectCountKHR m_draw_indexed_indirect_count    = nullptr;
+    bool                                 m_shader_draw_parameters         = false;
+    bool                                 m_descriptor_indexing            = false;
+    uint32_t                             m_max_update_after_bind_textures = 0;
+
     void initDevice();
   };
 
 
   void initDC(const VkInstance& inInstance);
 
+  inline VkInstance getVKInstance() const { return m_vk_instance; }
+
   uint32_t        getQueueCount(uint32_t inDeviceID = 0);
   inline uint32_t getDeviceCount() const { return m_device_count; }
 
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#version 440 core
+
+layout(local_size_x = 64) in;
+
+// Instance layout, see vkeGameRendererDynamic::InstanceFormat.
+layout(constant_id = 0) const int INSTANCE_FORMAT = 0;
+
+// Flight path, see VkeFlightRecord.
+struct FlightRecord{
+	vec4 path;		// start.xy, range.xy
+	vec4 motion;	// cos heading, sin heading, altitude, velocity
+	float t;
+	float scale;
+	uint rotation_xy;
+	uint rotation_zw;
+};
+
+struct InstanceData{
+	mat4 flight_matrix;
+};
+
+// Compact instance, see VkeInstanceRecord.
+struct InstanceRecord{
+	float position[3];
+	float scale;
+	uint rotation_xy;
+	uint rotation_zw;
+};
+
+layout(std430, set=0, binding = 0) buffer flightBuffer{
+	FlightRecord flights[];
+};
+
+layout(std430, set=0, binding = 1) writeonly buffer transformBuffer{
+	InstanceData instdata[];
+};
+
+layout(std430, set=0, binding = 1) writeonly buffer compactTransformBuffer{
+	InstanceRecord records[];
+};
+
+layout(push_constant) uniform flightParams{
+	float delta_time;
+	uint count;
+} params;
+
+void main(){
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= params.count)
+		return;
+
+	FlightRecord f = flights[i];
+
+	float t = f.t + f.motion.w * params.delta_time;
+	t -= floor(t);
+	flights[i].t = t;
+
+	vec2 pos = f.path.zw * t + f.path.xy;
+
+	if(INSTANCE_FORMAT == 1){
+		records[i].position[0] = pos.x;
+		records[i].position[1] = f.motion.z;
+		records[i].position[2] = pos.y;
+		records[i].scale = f.scale;
+		records[i].rotation_xy = f.rotation_xy;
+		records[i].rotation_zw = f.rotation_zw;
+		return;
+	}
+
+	// Same matrix as VkeFlightPaths::update:
+	// translate(x, altitude, y) * rotateY(heading) * rotateX(-90) * scale.
+	float c = f.motion.x * f.scale;
+	float s = f.motion.y * f.scale;
+
+	instdata[i].flight_matrix = mat4( c,     0.0,        -s,    0.0,
+									 -s,     0.0,        -c,    0.0,
+									  0.0,   f.scale,     0.0,  0.0,
+									  pos.x, f.motion.z,  pos.y, 1.0);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#version 440 core
+
+layout(location=0) in IMPOSTOR_OUT{
+	vec3 wpos;
+	vec2 uv;
+	flat float fade;
+	flat mat3 rotation;
+} fs_in;
+
+layout(set = 0, binding = 1) uniform sampler2D albedoAtlas;
+layout(set = 0, binding = 2) uniform sampler2D normalAtlas;
+
+layout(location = 0) out vec4 out_color;
+
+// Same pattern as std_fragment.glsl. The mesh drops
+// fragments above the fade, the impostor the rest.
+float ditherThreshold(){
+	const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0,
+									  12.0, 4.0, 14.0, 6.0,
+									  3.0, 11.0, 1.0, 9.0,
+									  15.0, 7.0, 13.0, 5.0);
+	ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+	return (bayer[p.y * 4 + p.x] + 0.5) / 16.0;
+}
+
+void main(){
+
+	if(fs_in.fade <= ditherThreshold())
+		discard;
+
+	vec4 albedo = texture(albedoAtlas, fs_in.uv);
+	if(albedo.w < 0.5)
+		discard;
+
+	// Diffuse and fog as in std_fragment.glsl. The
+	// reflection and specular terms are left out at
+	// this distance.
+	vec3 nml = normalize(fs_in.rotation * (texture(normalAtlas, fs_in.uv).xyz * 2.0 - 1.0));
+
+	vec3 light_pos = vec3(-100.0, 100.0, 100.0);
+	vec3 light_vector = normalize(light_pos - fs_in.wpos.xyz);
+
+	const float minFog = 80.0;
+	const float maxFog = 360.0;
+	float fogRng = maxFog - minFog;
+
+	float pLen = length(fs_in.wpos.xyz);
+	float fogFactor = clamp((pLen - minFog) / fogRng,0.0,0.85);
+
+	float diffuse = clamp(dot(light_vector, nml), 0.1, 1.0);
+	vec3 combinedColor = mix(albedo.xyz * diffuse, vec3(1.0), fogFactor);
+
+	out_color = vec4(combinedColor, 1.0);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#version 440 core
+
+#ifdef BINDLESS_TEXTURES
+#extension GL_EXT_nonuniform_qualifier : require
+#define TEXTURE_INDEX(i) nonuniformEXT(i)
+#else
+#define TEXTURE_INDEX(i) (i)
+#endif
+
+layout(location=0) in BAKE_OUT{
+	vec3 nml;
+	vec2 uv;
+	flat int material;
+} fs_in;
+
+// See std_fragment.glsl.
+layout(constant_id = 4) const int TEXTURE_COUNT = 1;
+layout(set = 1, binding = 0) uniform sampler2D tex[TEXTURE_COUNT];
+
+// Albedo with coverage in alpha, and the chopper
+// space normal. Lighting is applied when drawn.
+layout(location = 0) out vec4 out_albedo;
+layout(location = 1) out vec4 out_normal;
+
+void main(){
+	vec4 texColor = texture(tex[TEXTURE_INDEX(fs_in.material)], fs_in.uv);
+
+	out_albedo = vec4(texColor.xyz, 1.0);
+	out_normal = vec4(normalize(fs_in.nml) * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#version 440 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Depth attachment, read a sample at a time.
+layout(set=0, binding = 0) uniform sampler2DMS depthTexture;
+
+// Level below the one being written, unused for level 0.
+layout(set=0, binding = 1, r32f) uniform readonly image2D srcLevel;
+
+layout(set=0, binding = 2, r32f) uniform writeonly image2D dstLevel;
+
+layout(push_constant) uniform hizParams{
+	ivec2 depth_size;
+	uint level;
+	uint samples;
+} params;
+
+void main(){
+	ivec2 dst = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 dstSize = imageSize(dstLevel);
+	if(any(greaterThanEqual(dst, dstSize)))
+		return;
+
+	// Each texel keeps the farthest depth it covers, so a
+	// bound nearer than it is known to be in front.
+	float depth = 0.0;
+
+	if(params.level == 0){
+		// The base is the largest power of two that fits, so
+		// a texel covers one to two pixels a side; take every
+		// pixel it touches and every sample in them.
+		ivec2 first = (dst * params.depth_size) / dstSize;
+		ivec2 last = ((dst + 1) * params.depth_size + dstSize - 1) / dstSize;
+		for(int y = first.y; y < last.y; ++y){
+			for(int x = first.x; x < last.x; ++x){
+				for(int s = 0; s < int(params.samples); ++s)
+					depth = max(depth, texelFetch(depthTexture, ivec2(x, y), s).r);
+			}
+		}
+	}
+	else{
+		ivec2 srcMax = imageSize(srcLevel) - 1;
+		ivec2 src = dst * 2;
+		depth = max(max(imageLoad(srcLevel, src).r,
+						imageLoad(srcLevel, min(src + ivec2(1, 0), srcMax)).r),
+					max(imageLoad(srcLevel, min(src + ivec2(0, 1), srcMax)).r,
+						imageLoad(srcLevel, min(src + ivec2(1, 1), srcMax)).r));
+	}
+
+	imageStore(dstLevel, dst, vec4(depth));
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#version 440 core
+
+layout(local_size_x = 64) in;
+
+// Instance layout, see vkeGameRendererDynamic::InstanceFormat.
+layout(constant_id = 0) const int INSTANCE_FORMAT = 0;
+
+// Compact node record, see VkeNodeRecord.
+struct NodeRecord{
+	vec4 world_rows[3];
+	uint normal_packed[5];
+	uint material_id;
+	uint instance_count;
+	uint pad;
+	vec4 bounding_sphere;
+};
+
+struct InstanceData{
+	mat4 flight_matrix;
+};
+
+// Compact instance, see VkeInstanceRecord.
+struct InstanceRecord{
+	float position[3];
+	float scale;
+	uint rotation_xy;
+	uint rotation_zw;
+};
+
+// VkDrawIndexedIndirectCommand.
+struct DrawCommand{
+	uint index_count;
+	uint instance_count;
+	uint first_index;
+	int vertex_offset;
+	uint first_instance;
+};
+
+layout(std430, set=0, binding = 0) readonly buffer nodeRecordBuffer{
+	NodeRecord nodes[];
+};
+
+layout(std430, set=0, binding = 1) readonly buffer transformBuffer{
+	InstanceData instdata[];
+};
+
+layout(std430, set=0, binding = 1) readonly buffer compactTransformBuffer{
+	InstanceRecord records[];
+};
+
+layout(std430, set=0, binding = 2) writeonly buffer visibleBuffer{
+	// Visible instances of node n from n * instance_count.
+	uint visible[];
+};
+
+layout(std430, set=0, binding = 3) buffer countBuffer{
+	// Per node visible counts, then the instances that
+	// passed the whole chopper test, the draw count, the
+	// instances occluded in the first phase, those found
+	// visible again in the second and the draw count of
+	// each batch.
+	uint counts[];
+};
+
+layout(std430, set=0, binding = 4) readonly buffer templateBuffer{
+	// One command per node, instance counts unused.
+	DrawCommand templates[];
+};
+
+layout(std430, set=0, binding = 5) writeonly buffer drawBuffer{
+	DrawCommand draws[];
+};
+
+layout(std430, set=0, binding = 6) readonly buffer batchBuffer{
+	// End of each draw batch, see vkeGameRendererDynamic::DrawBatch.
+	// The batches cover the nodes in order.
+	uint batch_end[];
+};
+
+layout(push_constant) uniform cullParams{
+	vec4 planes[6];
+	vec4 scene_sphere;	// whole chopper, model space
+	uint instance_count;
+	uint node_count;
+	uint pass;
+} params;
+
+#ifdef OCCLUSION_CULL
+// Farthest depth pyramid, see hiz_build.glsl.
+layout(set=1, binding = 0) uniform sampler2D hizTexture;
+
+layout(set=1, binding = 1) uniform occlusionParams{
+	// Camera the pyramid was built from for the first
+	// phase, this frame's camera for the second.
+	mat4 view_proj[2];
+	vec4 hiz_size;	// base width, height, level count
+} occlusion;
+
+layout(std430, set=1, binding = 2) buffer occludedBuffer{
+	uint occluded[];
+};
+
+// True if the sphere lies behind the farthest depth over
+// its screen rectangle. The box around the sphere is
+// projected, which is conservative in both rect and depth.
+bool sphereOccluded(vec3 center, float radius, mat4 viewProj){
+	vec2 minUV = vec2(1.0);
+	vec2 maxUV = vec2(0.0);
+	float nearest = 1.0;
+	for(int c = 0; c < 8; ++c){
+		vec3 corner = center + radius * vec3((c & 1) != 0 ? 1.0 : -1.0,
+											 (c & 2) != 0 ? 1.0 : -1.0,
+											 (c & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = viewProj * vec4(corner, 1.0);
+		// Crossing the near plane, nothing can hide it.
+		if(clip.w <= 0.0 || clip.z < 0.0)
+			return false;
+		vec3 ndc = clip.xyz / clip.w;
+		minUV = min(minUV, ndc.xy * 0.5 + 0.5);
+		maxUV = max(maxUV, ndc.xy * 0.5 + 0.5);
+		nearest = min(nearest, ndc.z);
+	}
+	minUV = clamp(minUV, 0.0, 1.0);
+	maxUV = clamp(maxUV, 0.0, 1.0);
+
+	// The level where the rect is at most one texel wide,
+	// so it touches at most 2x2 of them.
+	vec2 size = (maxUV - minUV) * occlusion.hiz_size.xy;
+	int level = int(min(ceil(log2(max(max(size.x, size.y), 1.0))), occlusion.hiz_size.z - 1.0));
+
+	ivec2 levelMax = textureSize(hizTexture, level) - 1;
+	ivec2 lo = min(ivec2(minUV * vec2(levelMax + 1)), levelMax);
+	ivec2 hi = min(ivec2(maxUV * vec2(levelMax + 1)), levelMax);
+
+	float farthest = max(max(texelFetch(hizTexture, lo, level).r, texelFetch(hizTexture, ivec2(hi.x, lo.y), level).r),
+						 max(texelFetch(hizTexture, ivec2(lo.x, hi.y), level).r, texelFetch(hizTexture, hi, level).r));
+	return nearest > farthest;
+}
+#endif
+
+bool sphereVisible(vec3 center, float radius){
+	for(int p = 0; p < 6; ++p){
+		if(dot(params.planes[p].xyz, center) + params.planes[p].w < -radius)
+			return false;
+	}
+	return true;
+}
+
+mat4 flightMatrix(uint i, out float scale){
+	if(INSTANCE_FORMAT == 1){
+		InstanceRecord r = records[i];
+		vec4 q = normalize(vec4(unpackSnorm2x16(r.rotation_xy), unpackSnorm2x16(r.rotation_zw)));
+		vec3 q2 = q.xyz * 2.0;
+		float xx = q.x * q2.x, yy = q.y * q2.y, zz = q.z * q2.z;
+		float xy = q.x * q2.y, xz = q.x * q2.z, yz = q.y * q2.z;
+		float wx = q.w * q2.x, wy = q.w * q2.y, wz = q.w * q2.z;
+		scale = r.scale;
+		return mat4(vec4(1.0 - (yy + zz), xy + wz, xz - wy, 0.0) * r.scale,
+					vec4(xy - wz, 1.0 - (xx + zz), yz + wx, 0.0) * r.scale,
+					vec4(xz + wy, yz - wx, 1.0 - (xx + yy), 0.0) * r.scale,
+					vec4(r.position[0], r.position[1], r.position[2], 1.0));
+	}
+	mat4 m = instdata[i].flight_matrix;
+	scale = length(m[0].xyz);
+	return m;
+}
+
+// Appends instance i to the visible list of each of its
+// nodes that passes the frustum test.
+void appendNodes(uint i, mat4 flightMat, float scale){
+	for(uint n = 0; n < params.node_count; ++n){
+		vec4 sphere = nodes[n].bounding_sphere;
+		vec3 center = (flightMat * vec4(sphere.xyz, 1.0)).xyz;
+		if(!sphereVisible(center, sphere.w * scale))
+			continue;
+		uint slot = atomicAdd(counts[n], 1u);
+		visible[n * params.instance_count + slot] = i;
+	}
+}
+
+void main(){
+	uint nodeCount = params.node_count;
+
+	// Pass 1: one invocation packs the non empty node
+	// commands to the front of each batch, keeping the
+	// sorted draw order, so each batch stays one range.
+	if(params.pass == 1){
+		if(gl_GlobalInvocationID.x != 0)
+			return;
+		uint drawCount = 0u;
+		uint first = 0u;
+		for(uint b = 0; first < nodeCount; ++b){
+			uint end = batch_end[b];
+			uint packed = first;
+			for(uint n = first; n < end; ++n){
+				uint visibleCount = counts[n];
+				if(visibleCount == 0)
+					continue;
+				DrawCommand cmd = templates[n];
+				cmd.instance_count = visibleCount;
+				draws[packed++] = cmd;
+			}
+			// Empty the tail, the scene secondaries each draw
+			// a fixed slice of the batch up to its count.
+			for(uint n = packed; n < end; ++n){
+				DrawCommand cmd = templates[n];
+				cmd.instance_count = 0u;
+				draws[n] = cmd;
+			}
+			counts[nodeCount + 4 + b] = packed - first;
+			drawCount += packed - first;
+			first = end;
+		}
+		counts[nodeCount + 1] = drawCount;
+		return;
+	}
+
+	float scale;
+	mat4 flightMat;
+	vec3 center;
+
+#ifdef OCCLUSION_CULL
+	// Pass 2: after the main pass, re-test the instances the
+	// first phase found occluded against this frame's depth.
+	if(params.pass == 2){
+		uint slot = gl_GlobalInvocationID.x;
+		if(slot >= counts[nodeCount + 2])
+			return;
+		uint i = occluded[slot];
+		flightMat = flightMatrix(i, scale);
+		center = (flightMat * vec4(params.scene_sphere.xyz, 1.0)).xyz;
+		if(sphereOccluded(center, params.scene_sphere.w * scale, occlusion.view_proj[1]))
+			return;
+		atomicAdd(counts[nodeCount + 3], 1u);
+		appendNodes(i, flightMat, scale);
+		return;
+	}
+#endif
+
+	// Pass 0: test each instance as a whole, then each of
+	// its nodes, appending to the node's visible list.
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= params.instance_count)
+		return;
+
+	flightMat = flightMatrix(i, scale);
+
+	center = (flightMat * vec4(params.scene_sphere.xyz, 1.0)).xyz;
+	if(!sphereVisible(center, params.scene_sphere.w * scale))
+		return;
+
+#ifdef OCCLUSION_CULL
+	if(sphereOccluded(center, params.scene_sphere.w * scale, occlusion.view_proj[0])){
+		occluded[atomicAdd(counts[nodeCount + 2], 1u)] = i;
+		return;
+	}
+#endif
+
+	atomicAdd(counts[nodeCount], 1u);
+	appendNodes(i, flightMat, scale);
+}
\ No newline at end of file
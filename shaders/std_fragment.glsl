@@ -20,13 +20,24 @@
 
 #version 440 core
 
+#ifdef BINDLESS_TEXTURES
+#extension GL_EXT_nonuniform_qualifier : require
+#define TEXTURE_INDEX(i) nonuniformEXT(i)
+#else
+#define TEXTURE_INDEX(i) (i)
+#endif
+
 layout(location=0) in VS_OUT{
 	vec3 wpos;
 	vec3 nml;
 	vec2 uv;
 	flat ivec4 lut;
+	flat float fade;
 } vs_in;
 
+// See std_vertex.glsl.
+layout(constant_id = 3) const float IMPOSTOR_FAR = 0.0;
+
 struct CameraData{
 	mat4 proj_view_matrix;
 	mat4 inverse_proj_view_matrix;
@@ -51,13 +62,34 @@ layout(std140, set=0, binding = 1) uniform cameraBuffer{
 };
 
 
-layout(set = 1, binding = 0) uniform sampler2D tex[6];
+// Material textures, indexed by material id. With
+// BINDLESS_TEXTURES only the slots in use are bound.
+layout(constant_id = 4) const int TEXTURE_COUNT = 1;
+layout(set = 1, binding = 0) uniform sampler2D tex[TEXTURE_COUNT];
+
+// Alpha tested pipeline only, texels below it are
+// dropped. 0 for the opaque and transparent ones.
+layout(constant_id = 5) const float ALPHA_CUTOFF = 0.0;
 
 layout(set = 0,binding = 0) uniform samplerCube env;
 
 
+// 4x4 ordered dither, the impostor keeps the
+// fragments this drops so the two add up.
+float ditherThreshold(){
+	const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0,
+									  12.0, 4.0, 14.0, 6.0,
+									  3.0, 11.0, 1.0, 9.0,
+									  15.0, 7.0, 13.0, 5.0);
+	ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+	return (bayer[p.y * 4 + p.x] + 0.5) / 16.0;
+}
+
 void main(){
 
+	if(IMPOSTOR_FAR > 0.0 && vs_in.fade > ditherThreshold())
+		discard;
+
 	vec3 light_pos = vec3(-100.0, 100.0, 100.0);
 	vec3 light_vector = normalize(light_pos - vs_in.wpos.xyz);
 	vec3 view_pos = camera.camera_position.xyz;
@@ -77,8 +109,10 @@ void main(){
 	float diffuse = clamp(dot(light_vector, normalize(vs_in.nml.xyz)), 0.1, 1.0);
 	float spec = pow(clamp(dot(light_ref_vector, view_vector), 0.0, 1.0), 1.0*material.shininess);
 
-	vec4 texColor = texture(tex[vs_in.lut.x],vs_in.uv.xy);
-	vec2 lod = textureQueryLod(tex[vs_in.lut.x], vs_in.uv.xy);
+	vec4 texColor = texture(tex[TEXTURE_INDEX(vs_in.lut.x)],vs_in.uv.xy);
+	if(ALPHA_CUTOFF > 0.0 && texColor.w < ALPHA_CUTOFF)
+		discard;
+	vec2 lod = textureQueryLod(tex[TEXTURE_INDEX(vs_in.lut.x)], vs_in.uv.xy);
 	vec4 refColor = texture(env, ref_vector);
 	vec3 combinedColor = mix(texColor.xyz, refColor.xyz, material.reflectivity*2.0)*diffuse + spec;
 	vec3 combinedColor2 = mix(combinedColor, vec3(1.0), fogFactor);
@@ -20,36 +20,79 @@
 
 #version 440 core
 
-struct NodeUniform{
-	mat4 node_matrix;
-	mat4 inverse_node_matrix;
-	ivec4 lut;
-	vec4 lutPad[3];
+#ifdef DRAW_PARAMETERS
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
+// Compact node record, see VkeNodeRecord.
+struct NodeRecord{
+	vec4 world_rows[3];
+	uint normal_packed[5];
+	uint material_id;
+	uint instance_count;
+	uint pad;
+	vec4 bounding_sphere;
 };
 
+// Instance layout, see vkeGameRendererDynamic::InstanceFormat.
+layout(constant_id = 0) const int INSTANCE_FORMAT = 0;
+
+// Instances come through the lists written by instance_cull.glsl.
+layout(constant_id = 1) const bool INSTANCE_LIST = false;
+
+// Crossfade band to the impostors, see fragmentImpostor.glsl.
+// A far distance of 0 means impostors are off.
+layout(constant_id = 2) const float IMPOSTOR_NEAR = 0.0;
+layout(constant_id = 3) const float IMPOSTOR_FAR = 0.0;
+
+// Per draw parameters, see vkeGameRendererDynamic::DrawParams.
+layout(push_constant) uniform drawParams{
+	uint node_base;
+	uint instance_count;
+} draw;
+
 struct InstanceData{
 	mat4 flight_matrix;
 };
 
+// Compact instance, see VkeInstanceRecord.
+struct InstanceRecord{
+	float position[3];
+	float scale;
+	uint rotation_xy;
+	uint rotation_zw;
+};
+
 struct CameraData{
 	mat4 proj_view_matrix;
 	mat4 inverse_proj_view_matrix;
 	vec4 camera_position;
 };
 
-layout(std140, set=0, binding = 2) uniform nodeUniformBuffer{
-	// Node uniform data for each draw.
-	NodeUniform nodes[32];
+layout(std430, set=0, binding = 2) readonly buffer nodeRecordBuffer{
+	// Node record for each draw.
+	NodeRecord nodes[];
 };
 
 layout(std140,set=0, binding = 1) uniform cameraBuffer{
 	CameraData camera;
 };
 
-layout(std140, set=2, binding = 0) uniform transformBuffer{
-	InstanceData instdata[384];
+layout(std430, set=2, binding = 0) readonly buffer transformBuffer{
+	// One flight matrix per instance, sized at runtime.
+	InstanceData instdata[];
 }tra;
 
+layout(std430, set=2, binding = 0) readonly buffer compactTransformBuffer{
+	// Same binding, read when INSTANCE_FORMAT is 1.
+	InstanceRecord records[];
+}compact;
+
+layout(std430, set=2, binding = 1) readonly buffer visibleBuffer{
+	// Visible instances of node n from n * instance_count.
+	uint visible[];
+};
+
 in layout(location = 0) vec4 pos;
 in layout(location = 1) vec4 nml;
 
@@ -58,27 +101,90 @@ layout(location=0) out VS_OUT{
 	vec3 nml;
 	vec2 uv;
 	flat ivec4 lut;
+	flat float fade;
 } vs_out;
 
+mat4 nodeMatrix(int index){
+	return transpose(mat4(nodes[index].world_rows[0],
+						  nodes[index].world_rows[1],
+						  nodes[index].world_rows[2],
+						  vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+mat3 normalMatrix(int index){
+	vec2 a = unpackHalf2x16(nodes[index].normal_packed[0]);
+	vec2 b = unpackHalf2x16(nodes[index].normal_packed[1]);
+	vec2 c = unpackHalf2x16(nodes[index].normal_packed[2]);
+	vec2 d = unpackHalf2x16(nodes[index].normal_packed[3]);
+	vec2 e = unpackHalf2x16(nodes[index].normal_packed[4]);
+	return mat3(a.x, a.y, b.x,
+				b.y, c.x, c.y,
+				d.x, d.y, e.x);
+}
+
+mat3 quatToMat3(vec4 q){
+	vec3 q2 = q.xyz * 2.0;
+	float xx = q.x * q2.x, yy = q.y * q2.y, zz = q.z * q2.z;
+	float xy = q.x * q2.y, xz = q.x * q2.z, yz = q.y * q2.z;
+	float wx = q.w * q2.x, wy = q.w * q2.y, wz = q.w * q2.z;
+	return mat3(1.0 - (yy + zz), xy + wz, xz - wy,
+				xy - wz, 1.0 - (xx + zz), yz + wx,
+				xz + wy, yz - wx, 1.0 - (xx + yy));
+}
+
 void main(){
 	// Flip UVs vertically:
 	vs_out.uv = vec2(pos.w, 1.0f - nml.w);
 
-	int instCount = nodes[0].lut.y;
+	// Draw i starts at firstInstance = i * instance_count.
+	int instCount = int(draw.instance_count);
+#ifdef DRAW_PARAMETERS
+	// The draw index within the multi draw gives the node, except
+	// for the packed GPU culled commands, where only the base
+	// instance still does. Either way it is the same for the
+	// whole draw.
+	int bufferIndex = INSTANCE_LIST ? gl_BaseInstanceARB / instCount : int(draw.node_base) + gl_DrawIDARB;
+	int instanceIndex = gl_InstanceIndex - gl_BaseInstanceARB;
+#else
 	int bufferIndex = gl_InstanceIndex / instCount;
 	int instanceIndex = gl_InstanceIndex % instCount;
-	mat4 flightMat = tra.instdata[instanceIndex].flight_matrix;
-
-	// nml.xyz * mat3(...inverse_node_matrix) multiplies the normal by the
-	// inverse transpose of the node matrix, which is the correct matrix to use
-	// for normals.
-	// We can use the flight matrix as-is, because we know it's only composed
-	// of a translation and a rotation -- so its inverse transpose
-	// is proportional to the matrix itself.
-	vs_out.nml = mat3(flightMat) * (mat3(nodes[bufferIndex].inverse_node_matrix) * nml.xyz);
-
-	vs_out.wpos = (flightMat * (nodes[bufferIndex].node_matrix * vec4(pos.xyz, 1.0))).xyz;
-	vs_out.lut = nodes[bufferIndex].lut;
+#endif
+	if(INSTANCE_LIST)
+		instanceIndex = int(visible[gl_InstanceIndex]);
+	mat4 flightMat;
+	mat3 flightRot;
+	if(INSTANCE_FORMAT == 1){
+		InstanceRecord r = compact.records[instanceIndex];
+		vec4 q = normalize(vec4(unpackSnorm2x16(r.rotation_xy), unpackSnorm2x16(r.rotation_zw)));
+		flightRot = quatToMat3(q);
+		flightMat = mat4(vec4(flightRot[0] * r.scale, 0.0),
+						 vec4(flightRot[1] * r.scale, 0.0),
+						 vec4(flightRot[2] * r.scale, 0.0),
+						 vec4(r.position[0], r.position[1], r.position[2], 1.0));
+	}
+	else{
+		flightMat = tra.instdata[instanceIndex].flight_matrix;
+		flightRot = mat3(flightMat);
+	}
+
+	// normalMatrix() is the upper 3x3 of the inverse node matrix, so
+	// nml.xyz * it multiplies the normal by the inverse transpose of the
+	// node matrix, which is the correct matrix to use for normals.
+	// We can use the flight rotation as-is, because we know the flight
+	// matrix is only composed of a translation, a rotation and a uniform
+	// scale -- so its inverse transpose is proportional to the matrix itself.
+	vs_out.nml = flightRot * (normalMatrix(bufferIndex) * nml.xyz);
+
+	vs_out.wpos = (flightMat * (nodeMatrix(bufferIndex) * vec4(pos.xyz, 1.0))).xyz;
+	vs_out.lut = ivec4(nodes[bufferIndex].material_id, instCount, 0, 0);
+
+	// How far the instance is into the crossfade band,
+	// from its origin as the CPU partition measures it.
+	vs_out.fade = 0.0;
+	if(IMPOSTOR_FAR > 0.0){
+		float dist = distance(camera.camera_position.xyz, flightMat[3].xyz);
+		vs_out.fade = clamp((dist - IMPOSTOR_NEAR) / (IMPOSTOR_FAR - IMPOSTOR_NEAR), 0.0, 1.0);
+	}
 
 	gl_Position = camera.proj_view_matrix * vec4(vs_out.wpos, 1.0f);
 }
\ No newline at end of file
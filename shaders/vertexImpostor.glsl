@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#version 440 core
+
+// Instance layout, see vkeGameRendererDynamic::InstanceFormat.
+layout(constant_id = 0) const int INSTANCE_FORMAT = 0;
+
+// Crossfade band, see std_vertex.glsl.
+layout(constant_id = 2) const float IMPOSTOR_NEAR = 0.0;
+layout(constant_id = 3) const float IMPOSTOR_FAR = 0.0;
+
+struct InstanceData{
+	mat4 flight_matrix;
+};
+
+// Compact instance, see VkeInstanceRecord.
+struct InstanceRecord{
+	float position[3];
+	float scale;
+	uint rotation_xy;
+	uint rotation_zw;
+};
+
+struct CameraData{
+	mat4 proj_view_matrix;
+	mat4 inverse_proj_view_matrix;
+	vec4 camera_position;
+};
+
+layout(std140, set=0, binding = 0) uniform cameraBuffer{
+	CameraData camera;
+};
+
+layout(std430, set=1, binding = 0) readonly buffer transformBuffer{
+	InstanceData instdata[];
+}tra;
+
+layout(std430, set=1, binding = 0) readonly buffer compactTransformBuffer{
+	InstanceRecord records[];
+}compact;
+
+// Chopper bounding sphere and atlas cells per side.
+layout(push_constant) uniform impostorParams{
+	vec4 center_radius;
+	uint grid;
+} params;
+
+layout(location=0) out IMPOSTOR_OUT{
+	vec3 wpos;
+	vec2 uv;
+	flat float fade;
+	flat mat3 rotation;
+} vs_out;
+
+mat3 quatToMat3(vec4 q){
+	vec3 q2 = q.xyz * 2.0;
+	float xx = q.x * q2.x, yy = q.y * q2.y, zz = q.z * q2.z;
+	float xy = q.x * q2.y, xz = q.x * q2.z, yz = q.y * q2.z;
+	float wx = q.w * q2.x, wy = q.w * q2.y, wz = q.w * q2.z;
+	return mat3(1.0 - (yy + zz), xy + wz, xz - wy,
+				xy - wz, 1.0 - (xx + zz), yz + wx,
+				xz + wy, yz - wx, 1.0 - (xx + yy));
+}
+
+vec2 signNotZero(vec2 v){
+	return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Octahedral map of the unit sphere onto [-1,1]^2,
+// the same as octahedralDecode in VkeGameRendererDynamic.cpp.
+vec2 octEncode(vec3 n){
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signNotZero(n.xy);
+}
+
+vec3 octDecode(vec2 p){
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	if(n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+	return normalize(n);
+}
+
+void main(){
+	// firstInstance is the first impostor slot, after
+	// the instances drawn as meshes.
+	int instanceIndex = gl_InstanceIndex;
+	mat4 flightMat;
+	float scale;
+	if(INSTANCE_FORMAT == 1){
+		InstanceRecord r = compact.records[instanceIndex];
+		vec4 q = normalize(vec4(unpackSnorm2x16(r.rotation_xy), unpackSnorm2x16(r.rotation_zw)));
+		mat3 rot = quatToMat3(q);
+		flightMat = mat4(vec4(rot[0] * r.scale, 0.0),
+						 vec4(rot[1] * r.scale, 0.0),
+						 vec4(rot[2] * r.scale, 0.0),
+						 vec4(r.position[0], r.position[1], r.position[2], 1.0));
+		scale = r.scale;
+	}
+	else{
+		flightMat = tra.instdata[instanceIndex].flight_matrix;
+		scale = length(flightMat[0].xyz);
+	}
+	mat3 rotation = mat3(flightMat) / scale;
+
+	vec3 center = (flightMat * vec4(params.center_radius.xyz, 1.0)).xyz;
+	float radius = params.center_radius.w * scale;
+
+	// Pick the baked view nearest the direction to the
+	// camera in chopper space, and rebuild the basis the
+	// bake looked through for it.
+	vec3 toCamera = normalize(transpose(rotation) * (camera.camera_position.xyz - center));
+	float grid = float(params.grid);
+	ivec2 cell = clamp(ivec2((octEncode(toCamera) * 0.5 + 0.5) * grid), ivec2(0), ivec2(params.grid - 1));
+	vec3 dir = octDecode((vec2(cell) + 0.5) / grid * 2.0 - 1.0);
+	vec3 up = abs(dir.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(up, dir));
+	up = cross(dir, right);
+
+	// Triangle strip corners, -1 to 1. The bake flips
+	// y like the scene camera, so v runs down.
+	vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1) * 2.0 - 1.0;
+
+	vs_out.wpos = center + rotation * (right * corner.x + up * corner.y) * radius;
+	vs_out.uv = (vec2(cell) + vec2(corner.x, -corner.y) * 0.5 + 0.5) / grid;
+	vs_out.rotation = rotation;
+
+	float dist = distance(camera.camera_position.xyz, flightMat[3].xyz);
+	vs_out.fade = clamp((dist - IMPOSTOR_NEAR) / (IMPOSTOR_FAR - IMPOSTOR_NEAR), 0.0, 1.0);
+
+	gl_Position = camera.proj_view_matrix * vec4(vs_out.wpos, 1.0f);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2014-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2014-2024 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#version 440 core
+
+// Compact node record, see VkeNodeRecord.
+struct NodeRecord{
+	vec4 world_rows[3];
+	uint normal_packed[5];
+	uint material_id;
+	uint instance_count;
+	uint pad;
+	vec4 bounding_sphere;
+};
+
+layout(std430, set=0, binding = 2) readonly buffer nodeRecordBuffer{
+	NodeRecord nodes[];
+};
+
+// View and orthographic projection of one atlas cell.
+layout(push_constant) uniform bakeParams{
+	mat4 view_proj;
+} params;
+
+in layout(location = 0) vec4 pos;
+in layout(location = 1) vec4 nml;
+
+layout(location=0) out BAKE_OUT{
+	vec3 nml;
+	vec2 uv;
+	flat int material;
+} vs_out;
+
+mat4 nodeMatrix(int index){
+	return transpose(mat4(nodes[index].world_rows[0],
+						  nodes[index].world_rows[1],
+						  nodes[index].world_rows[2],
+						  vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+mat3 normalMatrix(int index){
+	vec2 a = unpackHalf2x16(nodes[index].normal_packed[0]);
+	vec2 b = unpackHalf2x16(nodes[index].normal_packed[1]);
+	vec2 c = unpackHalf2x16(nodes[index].normal_packed[2]);
+	vec2 d = unpackHalf2x16(nodes[index].normal_packed[3]);
+	vec2 e = unpackHalf2x16(nodes[index].normal_packed[4]);
+	return mat3(a.x, a.y, b.x,
+				b.y, c.x, c.y,
+				d.x, d.y, e.x);
+}
+
+void main(){
+	// One chopper is baked, so each node is drawn once
+	// with firstInstance set to its index.
+	int node = gl_InstanceIndex;
+
+	vs_out.uv = vec2(pos.w, 1.0f - nml.w);
+	vs_out.nml = normalMatrix(node) * nml.xyz;
+	vs_out.material = int(nodes[node].material_id);
+
+	gl_Position = params.view_proj * (nodeMatrix(node) * vec4(pos.xyz, 1.0));
+}
@@ -29,6 +29,7 @@
 #include <nvgl/base_gl.hpp>
 #include <nvgl/error_gl.hpp>
 
+#include "VkeFlightPaths.h"
 #include "VulkanAppContext.h"
 #include "VulkanDeviceContext.h"
 
@@ -70,6 +71,8 @@ class Sample : public nvgl::AppWindowProfilerGL
   Tweak tweak;
   Tweak tweakLast;
 
+  bool m_benchmark_only = false;  //a benchmark ran in place of the sample
+
   struct
   {
     GLuint scene = 0;
@@ -83,9 +86,12 @@ class Sample : public nvgl::AppWindowProfilerGL
 
 
   bool begin();
+  void end();
   void think(double time);
   void resize(int width, int height);
 
+  bool runBenchmarks();
+
   bool initProgram();
   bool initVulkan();
   bool initScene();
@@ -94,6 +100,31 @@ class Sample : public nvgl::AppWindowProfilerGL
   bool initFramebuffers(int width, int height, int samples);
 
 public:
+  Sample()
+  {
+    VulkanAppContext::Settings& settings = VulkanAppContext::GetInstance()->getSettings();
+    m_parameterList.add("instances|number of chopper instances", &settings.scenario.instance_count);
+    m_parameterList.add("seed|seed for the scene and flight paths", &settings.scenario.seed);
+    m_parameterList.add("duration|seconds to run before exiting, 0 runs until closed", &settings.scenario.duration);
+    m_parameterList.add("record|file to record frame times and camera to", &settings.record_file);
+    m_parameterList.add("replay|recording to replay frame for frame", &settings.replay_file);
+    m_parameterList.add("instanceformat|0: mat4 per instance, 1: 24 byte position, scale and quaternion", &settings.instance_format);
+    m_parameterList.add("flightbenchmark|1: time the flight path integrator and exit", &settings.flight_benchmark);
+    m_parameterList.add("swarm|radius the flight paths steer to keep apart, 0 flies straight lines", &settings.scenario.swarm_radius);
+    m_parameterList.add("swarmbenchmark|1: time the swarm steering and exit", &settings.swarm_benchmark);
+    m_parameterList.add("gpuflight|1: integrate flight paths in a compute shader", &settings.gpu_flight);
+    m_parameterList.add("validateflight|1: compare the compute flight paths with the CPU", &settings.validate_flight);
+    m_parameterList.add("cull|0: draw every instance, 1: frustum cull the CPU flight instances", &settings.cull_instances);
+    m_parameterList.add("gpucull|1: cull instances and nodes in a compute shader, drawn with an indirect count", &settings.gpu_cull);
+    m_parameterList.add("occlusion|1: two phase Hi-Z occlusion culling, needs gpucull", &settings.occlusion_cull);
+    m_parameterList.add("impostors|distance past which instances draw as impostors, 0 disables", &settings.impostor_distance);
+    m_parameterList.add("threads|worker threads for per frame work, 0 for one per core", &settings.threads);
+    m_parameterList.add("frames|frames in flight, 1 to 4", &settings.frames_in_flight);
+    m_parameterList.add("drawbenchmark|1: re-record the scene every frame and log the per draw CPU and GPU cost",
+                        &settings.draw_benchmark);
+    m_parameterList.add("drawkeys|node draw order, most significant first: p pass, o opacity, s pipeline, m material, g mesh",
+                        &settings.draw_key_order);
+  }
 };
 
 
@@ -177,8 +208,35 @@ bool Sample::initFramebuffers(int width, int height, int samples)
 }
 
 
+/*
+	Runs the benchmarks asked for on the command
+	line. Returns true if any ran.
+*/
+bool Sample::runBenchmarks()
+{
+  VulkanAppContext::Settings& settings = VulkanAppContext::GetInstance()->getSettings();
+  if(settings.flight_benchmark)
+    VkeFlightPaths::benchmark();
+  if(settings.swarm_benchmark)
+    VkeFlightPaths::swarmBenchmark();
+
+  return settings.flight_benchmark || settings.swarm_benchmark;
+}
+
 bool Sample::begin()
 {
+  /*
+	A benchmark run skips Vulkan and asks the
+	framework to close the window, so it leaves
+	through the normal shutdown.
+	*/
+  if(runBenchmarks())
+  {
+    m_benchmark_only = true;
+    close();
+    return true;
+  }
+
   glDisable(GL_CULL_FACE);
   glEnable(GL_DEPTH_TEST);
 
@@ -204,6 +262,8 @@ bool Sample::begin()
 
 void Sample::think(double time)
 {
+  if(m_benchmark_only)
+    return;
 
   m_control.processActions({m_windowState.m_swapSize[0], m_windowState.m_swapSize[1]},
                            glm::vec2(m_windowState.m_mouseCurrent[0], m_windowState.m_mouseCurrent[1]),
@@ -216,11 +276,23 @@ void Sample::think(double time)
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   ctxt->render();
+
+  if(ctxt->isFinished())
+    close();
+}
+
+void Sample::end()
+{
+  if(!m_benchmark_only)
+    VulkanAppContext::GetInstance()->shutdown();
 }
 
 
 void Sample::resize(int width, int height)
 {
+  if(m_benchmark_only)
+    return;
+
   VulkanDC*         dc     = VulkanDC::Get();
   VulkanDC::Device* device = dc->getDefaultDevice();
   VulkanAppContext* ctxt   = VulkanAppContext::GetInstance();